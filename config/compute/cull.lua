@@ -0,0 +1,13 @@
+-- GPU frustum culling into indirect draws, see Renderer::Cull
+compute_pipeline = {
+    is_byte_code = false,
+    source_path = "../src/shaders/cull.slang",
+    format = ShaderFormat.MSL,
+    entry_point = "cullMain",
+    num_readonly_storage_buffers = 2,  -- instances, batches
+    num_readwrite_storage_buffers = 2, -- visible, commands
+    num_uniform_buffers = 1,
+    threadcount_x = 64,
+    threadcount_y = 1,
+    threadcount_z = 1,
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+engine = {
+    -- GPU memory for model buffers in MiB, least recently drawn models are
+    -- evicted above it. 0 disables eviction.
+    model_budget_mb = 0,
+    -- Time the gameplay script collector may take each frame
+    script_gc_budget_ms = 0.5,
+    -- Lua states gameplay scripts are spread over, 0 uses one per core
+    script_threads = 0,
+    -- Simulation steps per second, independent of the frame rate
+    sim_rate = 60,
+    -- Steps a frame may run to catch up, time beyond them is dropped so a
+    -- long frame slows the game down instead of stalling it
+    max_sim_steps = 4,
+    -- How frames reach the screen, see preludes/engine.lua
+    present_mode = PresentMode.VSYNC,
+    -- Frame rate cap on top of the present mode, 0 renders as fast as it can
+    max_fps = 0,
+    -- Cap while minimized or in the background, 0 keeps max_fps
+    background_fps = 15,
+    -- GPU time a frame may take, the render resolution drops when frames
+    -- take longer and recovers when they are well below. 0 renders at
+    -- max_render_scale.
+    gpu_budget_ms = 14.0,
+    -- Render resolution per axis, relative to the window
+    min_render_scale = 0.5,
+    max_render_scale = 1.0,
+    -- Frustum cull instances in a compute pass and draw them indirectly,
+    -- needs compute/cull.lua and pipelines/instanced.lua. Falls back to
+    -- culling on the CPU when either is missing.
+    gpu_culling = true,
+}
\ No newline at end of file
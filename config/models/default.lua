@@ -1,6 +1,6 @@
 model_group = {
     {
-        name = "bunny",
-        path = "/Users/w6rsty/Downloads/bunny.glb"
+        name = "sphere",
+        path = "../assets/sphere.glb" -- relative to the config root
     }
 }
\ No newline at end of file
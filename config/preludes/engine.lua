@@ -0,0 +1,5 @@
+PresentMode = {
+    VSYNC     = 0, -- waits for vblank, always supported
+    IMMEDIATE = 1, -- no wait, may tear
+    MAILBOX   = 2, -- no wait, the newest frame replaces a queued one
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+-- Example entity script, spawned with ScriptRuntime::Spawn("sentinel", entity).
+-- Waits for the player, then loops a wind-up / swing / recover pattern.
+return function(entity)
+    wait_event("player_near")
+    log("sentinel " .. entity .. " engages")
+    while true do
+        wait(30)
+        log("sentinel " .. entity .. " swings")
+        emit("sentinel_swing")
+        wait(60)
+    end
+end
\ No newline at end of file
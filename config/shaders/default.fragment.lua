@@ -1,6 +1,6 @@
 shader = {
     is_byte_code = false,
-    source_path = "/Users/w6rsty/dev/Cpp/soulike/src/shaders/default_fragment.slang",
+    source_path = "../src/shaders/default_fragment.slang",
     stage = ShaderStage.Fragment,
     format = ShaderFormat.MSL,
     entry_point = "fragmentMain",
@@ -1,8 +1,8 @@
 shader = {
     is_byte_code = false,
-    source_path = "/Users/w6rsty/dev/Cpp/soulike/src/shaders/default_vertex.slang",
+    source_path = "../src/shaders/default_vertex.slang",
     stage = ShaderStage.Vertex,
     format = ShaderFormat.MSL,
     entry_point = "vertexMain",
-    num_uniform_buffers = 1,
+    num_uniform_buffers = 2,
 }
\ No newline at end of file
@@ -0,0 +1,9 @@
+shader = {
+    is_byte_code = false,
+    source_path = "../src/shaders/skinned_vertex.slang",
+    stage = ShaderStage.Vertex,
+    format = ShaderFormat.MSL,
+    entry_point = "vertexMain",
+    num_storage_buffers = 1,
+    num_uniform_buffers = 2,
+}
\ No newline at end of file
@@ -0,0 +1,582 @@
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include "Animation.hpp"
+#include "BinaryStream.hpp"
+#include "Logger.hpp"
+
+namespace {
+    constexpr uint32_t s_clip_magic{ 0x4E414F53 }; // "SOAN"
+    // Bump whenever CompressedClip or the file layout changes
+    constexpr uint32_t s_clip_version{ 1 };
+    constexpr float    s_rotation_key_max{ 32767.0f }; // 15 bits per component
+    constexpr float    s_key_max{ 65535.0f };
+    constexpr float    s_sqrt1_2{ 0.70710678f };
+
+    // Neighbouring frames around `time` and how far it is between them
+    struct FramePair
+    {
+        uint32_t first;
+        uint32_t second;
+        float    alpha;
+        float    position; // in frames from the start
+    };
+
+    auto FindFrames(float duration, float sample_rate, uint32_t frame_count, float time, bool loop) -> FramePair
+    {
+        if (loop && duration > 0.0f)
+        {
+            time = std::fmod(time, duration);
+            time = time < 0.0f ? time + duration : time;
+        }
+        float position = std::clamp(time, 0.0f, duration) * sample_rate;
+        auto first = std::min(static_cast<uint32_t>(position), frame_count - 1);
+        uint32_t second = std::min(first + 1, frame_count - 1);
+        return { first, second, position - static_cast<float>(first), position };
+    }
+
+    // Smallest three: the largest component is dropped, made positive and
+    // rebuilt from the unit length. The others lie within +-1/sqrt(2) and
+    // take 15 bits each, the spare top bits of the first two keys tell
+    // which component was dropped.
+    void PackRotation(float const* q, uint16_t* keys)
+    {
+        uint32_t largest{ 0 };
+        for (uint32_t i{ 1 }; i < 4; ++i)
+        {
+            largest = std::abs(q[i]) > std::abs(q[largest]) ? i : largest;
+        }
+        float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+        for (uint32_t i{ 0 }, key{ 0 }; i < 4; ++i)
+        {
+            if (i == largest)
+            {
+                continue;
+            }
+            float unit = std::clamp(q[i] * sign * s_sqrt1_2 + 0.5f, 0.0f, 1.0f);
+            auto value = static_cast<uint16_t>(std::lround(unit * s_rotation_key_max));
+            keys[key] = key < 2 ? static_cast<uint16_t>(value | ((largest >> key) & 1) << 15) : value;
+            ++key;
+        }
+    }
+
+    void UnpackRotation(uint16_t const* keys, float* q)
+    {
+        uint32_t largest = (keys[0] >> 15) | (keys[1] >> 15) << 1;
+        float sum{ 0.0f };
+        for (uint32_t i{ 0 }, key{ 0 }; i < 4; ++i)
+        {
+            if (i == largest)
+            {
+                continue;
+            }
+            q[i] = (static_cast<float>(keys[key] & 0x7FFF) / s_rotation_key_max - 0.5f) * 2.0f * s_sqrt1_2;
+            sum += q[i] * q[i];
+            ++key;
+        }
+        q[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+    }
+
+    // Largest component difference, `q` and `-q` are the same rotation
+    auto RotationError(float const* a, float const* b) -> float
+    {
+        float same{ 0.0f };
+        float flipped{ 0.0f };
+        for (uint32_t i{ 0 }; i < 4; ++i)
+        {
+            same = std::max(same, std::abs(a[i] - b[i]));
+            flipped = std::max(flipped, std::abs(a[i] + b[i]));
+        }
+        return std::min(same, flipped);
+    }
+
+    // Offsets and sizes stay within what sampling a Pose of `joint_count`
+    // touches
+    auto IsConsistent(CompressedClip const& clip, uint32_t joint_count) -> bool
+    {
+        size_t pose_size = static_cast<size_t>(Pose::s_streams) * Pose::PaddedCount(joint_count);
+        auto in_pose = [pose_size](auto const& track) { return track.offset < pose_size; };
+        auto is_joint = [joint_count](uint32_t joint) { return joint < joint_count; };
+        return clip.frame_count > 0 &&
+            clip.sample_rate > 0.0f &&
+            clip.base.size() == pose_size &&
+            std::all_of(clip.linear.begin(), clip.linear.end(), in_pose) &&
+            std::all_of(clip.keyed.begin(), clip.keyed.end(), in_pose) &&
+            std::all_of(clip.linear_rotations.begin(), clip.linear_rotations.end(), [&](auto const& track) { return is_joint(track.joint); }) &&
+            std::all_of(clip.keyed_rotations.begin(), clip.keyed_rotations.end(), is_joint) &&
+            clip.frame_stride == clip.keyed_rotations.size() * 3 + clip.keyed.size() &&
+            clip.keys.size() == static_cast<size_t>(clip.frame_count) * clip.frame_stride;
+    }
+
+    // Rotation streams back to unit length after component wise blending
+    void NormalizeRotations(Pose& pose)
+    {
+        float* x = pose.Stream(PoseStream::RotationX);
+        float* y = pose.Stream(PoseStream::RotationY);
+        float* z = pose.Stream(PoseStream::RotationZ);
+        float* w = pose.Stream(PoseStream::RotationW);
+        for (uint32_t i{ 0 }; i < pose.Stride(); ++i)
+        {
+            float inv_length = 1.0f / std::sqrt(std::max(x[i] * x[i] + y[i] * y[i] + z[i] * z[i] + w[i] * w[i], 1e-12f));
+            x[i] *= inv_length;
+            y[i] *= inv_length;
+            z[i] *= inv_length;
+            w[i] *= inv_length;
+        }
+    }
+}
+
+void Pose::Resize(uint32_t joint_count)
+{
+    if (joint_count == m_joint_count && !m_data.empty())
+    {
+        return;
+    }
+    m_joint_count = joint_count;
+    m_stride = PaddedCount(joint_count);
+    m_data.assign(static_cast<size_t>(s_streams) * m_stride, 0.0f);
+    std::fill_n(Stream(PoseStream::RotationW), m_stride, 1.0f);
+    std::fill_n(Stream(PoseStream::ScaleX), m_stride, 1.0f);
+    std::fill_n(Stream(PoseStream::ScaleY), m_stride, 1.0f);
+    std::fill_n(Stream(PoseStream::ScaleZ), m_stride, 1.0f);
+}
+
+void Pose::SetTranslation(uint32_t joint, glm::vec3 const& translation)
+{
+    Stream(PoseStream::TranslationX)[joint] = translation.x;
+    Stream(PoseStream::TranslationY)[joint] = translation.y;
+    Stream(PoseStream::TranslationZ)[joint] = translation.z;
+}
+
+void Pose::SetRotation(uint32_t joint, glm::quat const& rotation)
+{
+    Stream(PoseStream::RotationX)[joint] = rotation.x;
+    Stream(PoseStream::RotationY)[joint] = rotation.y;
+    Stream(PoseStream::RotationZ)[joint] = rotation.z;
+    Stream(PoseStream::RotationW)[joint] = rotation.w;
+}
+
+void Pose::SetScale(uint32_t joint, glm::vec3 const& scale)
+{
+    Stream(PoseStream::ScaleX)[joint] = scale.x;
+    Stream(PoseStream::ScaleY)[joint] = scale.y;
+    Stream(PoseStream::ScaleZ)[joint] = scale.z;
+}
+
+auto Pose::GetTranslation(uint32_t joint) const -> glm::vec3
+{
+    return {
+        Stream(PoseStream::TranslationX)[joint],
+        Stream(PoseStream::TranslationY)[joint],
+        Stream(PoseStream::TranslationZ)[joint],
+    };
+}
+
+auto Pose::GetRotation(uint32_t joint) const -> glm::quat
+{
+    return {
+        Stream(PoseStream::RotationW)[joint],
+        Stream(PoseStream::RotationX)[joint],
+        Stream(PoseStream::RotationY)[joint],
+        Stream(PoseStream::RotationZ)[joint],
+    };
+}
+
+auto Pose::GetScale(uint32_t joint) const -> glm::vec3
+{
+    return {
+        Stream(PoseStream::ScaleX)[joint],
+        Stream(PoseStream::ScaleY)[joint],
+        Stream(PoseStream::ScaleZ)[joint],
+    };
+}
+
+auto SkinInfo::FindClip(std::string_view name) const -> std::optional<uint32_t>
+{
+    for (uint32_t i{ 0 }; i < clips.size(); ++i)
+    {
+        if (clips[i].name == name)
+        {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+void SampleClip(AnimationClip const& clip, float time, bool loop, Pose& out)
+{
+    if (clip.frame_count == 0 || out.Data().size() != clip.stride)
+    {
+        return;
+    }
+    auto [first, second, alpha, position] = FindFrames(clip.duration, clip.sample_rate, clip.frame_count, time, loop);
+
+    // Every stream of both frames in one pass
+    float const* a = clip.frames.data() + static_cast<size_t>(first) * clip.stride;
+    float const* b = clip.frames.data() + static_cast<size_t>(second) * clip.stride;
+    float* result = out.Data().data();
+    for (uint32_t i{ 0 }; i < clip.stride; ++i)
+    {
+        result[i] = a[i] + (b[i] - a[i]) * alpha;
+    }
+    NormalizeRotations(out);
+}
+
+void SampleClip(CompressedClip const& clip, float time, bool loop, Pose& out)
+{
+    if (clip.frame_count == 0 || out.Data().size() != clip.base.size())
+    {
+        return;
+    }
+    auto [first, second, alpha, position] = FindFrames(clip.duration, clip.sample_rate, clip.frame_count, time, loop);
+    float along = clip.frame_count > 1 ? position / static_cast<float>(clip.frame_count - 1) : 0.0f;
+
+    float* data = out.Data().data();
+    std::copy(clip.base.begin(), clip.base.end(), data);
+    for (auto const& track : clip.linear)
+    {
+        data[track.offset] = track.start + track.delta * along;
+    }
+
+    float* rotation[4] = {
+        out.Stream(PoseStream::RotationX),
+        out.Stream(PoseStream::RotationY),
+        out.Stream(PoseStream::RotationZ),
+        out.Stream(PoseStream::RotationW),
+    };
+    for (auto const& track : clip.linear_rotations)
+    {
+        for (uint32_t i{ 0 }; i < 4; ++i)
+        {
+            rotation[i][track.joint] = track.start[i] + (track.end[i] - track.start[i]) * along;
+        }
+    }
+
+    // The two frames' keys are contiguous runs
+    uint16_t const* a = clip.keys.data() + static_cast<size_t>(first) * clip.frame_stride;
+    uint16_t const* b = clip.keys.data() + static_cast<size_t>(second) * clip.frame_stride;
+    for (uint32_t joint : clip.keyed_rotations)
+    {
+        float qa[4];
+        float qb[4];
+        UnpackRotation(a, qa);
+        UnpackRotation(b, qb);
+        a += 3;
+        b += 3;
+        float sign = qa[0] * qb[0] + qa[1] * qb[1] + qa[2] * qb[2] + qa[3] * qb[3] < 0.0f ? -1.0f : 1.0f;
+        for (uint32_t i{ 0 }; i < 4; ++i)
+        {
+            rotation[i][joint] = qa[i] + (qb[i] * sign - qa[i]) * alpha;
+        }
+    }
+    for (size_t i{ 0 }; i < clip.keyed.size(); ++i)
+    {
+        auto const& track = clip.keyed[i];
+        float scale = track.range / s_key_max;
+        float va = track.min + static_cast<float>(a[i]) * scale;
+        float vb = track.min + static_cast<float>(b[i]) * scale;
+        data[track.offset] = va + (vb - va) * alpha;
+    }
+    NormalizeRotations(out);
+}
+
+auto CompressedClip::ByteSize() const -> size_t
+{
+    return base.size() * sizeof(float) +
+        linear.size() * sizeof(LinearTrack) +
+        linear_rotations.size() * sizeof(LinearRotation) +
+        keyed.size() * sizeof(KeyedTrack) +
+        keyed_rotations.size() * sizeof(uint32_t) +
+        keys.size() * sizeof(uint16_t);
+}
+
+auto CompressClip(AnimationClip const& clip, uint32_t joint_count, ClipTolerance const& tolerance) -> CompressedClip
+{
+    CompressedClip result{
+        .name = clip.name,
+        .duration = clip.duration,
+        .sample_rate = clip.sample_rate,
+        .frame_count = clip.frame_count,
+    };
+    uint32_t stride = clip.stride / Pose::s_streams;
+    if (clip.frame_count == 0 || stride < joint_count || clip.frames.size() < static_cast<size_t>(clip.frame_count) * clip.stride)
+    {
+        result.frame_count = 0;
+        return result;
+    }
+
+    // Constants keep their first value
+    result.base.assign(clip.frames.begin(), clip.frames.begin() + clip.stride);
+    auto value = [&clip](uint32_t frame, uint32_t offset) { return clip.frames[static_cast<size_t>(frame) * clip.stride + offset]; };
+    auto along = [&clip](uint32_t frame) { return clip.frame_count > 1 ? static_cast<float>(frame) / static_cast<float>(clip.frame_count - 1) : 0.0f; };
+    uint32_t last = clip.frame_count - 1;
+
+    for (PoseStream stream : { PoseStream::TranslationX, PoseStream::TranslationY, PoseStream::TranslationZ,
+                               PoseStream::ScaleX, PoseStream::ScaleY, PoseStream::ScaleZ })
+    {
+        float limit = stream <= PoseStream::TranslationZ ? tolerance.translation : tolerance.scale;
+        for (uint32_t joint{ 0 }; joint < joint_count; ++joint)
+        {
+            uint32_t offset = static_cast<uint32_t>(stream) * stride + joint;
+            float start = value(0, offset);
+            float delta = value(last, offset) - start;
+            float min = start;
+            float max = start;
+            bool constant{ true };
+            bool linear{ true };
+            for (uint32_t frame{ 0 }; frame < clip.frame_count; ++frame)
+            {
+                float v = value(frame, offset);
+                min = std::min(min, v);
+                max = std::max(max, v);
+                constant = constant && std::abs(v - start) <= limit;
+                linear = linear && std::abs(v - (start + delta * along(frame))) <= limit;
+            }
+            if (constant)
+            {
+                continue;
+            }
+            if (linear)
+            {
+                result.linear.push_back({ offset, start, delta });
+                continue;
+            }
+            result.keyed.push_back({ offset, min, max - min });
+        }
+    }
+
+    auto rotation = [&](uint32_t frame, uint32_t joint, float* q)
+    {
+        for (uint32_t i{ 0 }; i < 4; ++i)
+        {
+            q[i] = value(frame, (static_cast<uint32_t>(PoseStream::RotationX) + i) * stride + joint);
+        }
+    };
+    for (uint32_t joint{ 0 }; joint < joint_count; ++joint)
+    {
+        CompressedClip::LinearRotation line{ .joint = joint };
+        rotation(0, joint, line.start);
+        rotation(last, joint, line.end);
+        float dot = line.start[0] * line.end[0] + line.start[1] * line.end[1] + line.start[2] * line.end[2] + line.start[3] * line.end[3];
+        for (float& component : line.end)
+        {
+            component = dot < 0.0f ? -component : component;
+        }
+
+        bool constant{ true };
+        bool linear{ true };
+        for (uint32_t frame{ 0 }; frame < clip.frame_count; ++frame)
+        {
+            float q[4];
+            rotation(frame, joint, q);
+            constant = constant && RotationError(q, line.start) <= tolerance.rotation;
+
+            // As sampled, normalized after a component wise lerp
+            float fit[4];
+            float length{ 0.0f };
+            for (uint32_t i{ 0 }; i < 4; ++i)
+            {
+                fit[i] = line.start[i] + (line.end[i] - line.start[i]) * along(frame);
+                length += fit[i] * fit[i];
+            }
+            length = std::sqrt(std::max(length, 1e-12f));
+            for (float& component : fit)
+            {
+                component /= length;
+            }
+            linear = linear && RotationError(q, fit) <= tolerance.rotation;
+        }
+        if (constant)
+        {
+            continue;
+        }
+        if (linear)
+        {
+            result.linear_rotations.push_back(line);
+            continue;
+        }
+        result.keyed_rotations.push_back(joint);
+    }
+
+    // Frame major, everything a sample needs from one frame is adjacent
+    result.frame_stride = static_cast<uint32_t>(result.keyed_rotations.size() * 3 + result.keyed.size());
+    result.keys.resize(static_cast<size_t>(clip.frame_count) * result.frame_stride);
+    for (uint32_t frame{ 0 }; frame < clip.frame_count; ++frame)
+    {
+        uint16_t* keys = result.keys.data() + static_cast<size_t>(frame) * result.frame_stride;
+        for (uint32_t joint : result.keyed_rotations)
+        {
+            float q[4];
+            rotation(frame, joint, q);
+            PackRotation(q, keys);
+            keys += 3;
+        }
+        for (auto const& track : result.keyed)
+        {
+            float unit = track.range > 0.0f ? (value(frame, track.offset) - track.min) / track.range : 0.0f;
+            *keys++ = static_cast<uint16_t>(std::lround(std::clamp(unit, 0.0f, 1.0f) * s_key_max));
+        }
+    }
+    return result;
+}
+
+auto SaveClips(std::filesystem::path const& file, std::vector<CompressedClip> const& clips, uint32_t joint_count) -> bool
+{
+    BinaryWriter writer;
+    writer.Write(s_clip_magic);
+    writer.Write(s_clip_version);
+    writer.Write(joint_count);
+    writer.Write(static_cast<uint32_t>(clips.size()));
+    for (auto const& clip : clips)
+    {
+        writer.WriteString(clip.name);
+        writer.Write(clip.duration);
+        writer.Write(clip.sample_rate);
+        writer.Write(clip.frame_count);
+        writer.WriteArray(clip.base);
+        writer.WriteArray(clip.linear);
+        writer.WriteArray(clip.linear_rotations);
+        writer.WriteArray(clip.keyed);
+        writer.WriteArray(clip.keyed_rotations);
+        writer.Write(clip.frame_stride);
+        writer.WriteArray(clip.keys);
+    }
+
+    std::vector<uint8_t> const& bytes = writer.Bytes();
+    std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<char const*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!stream)
+    {
+        SO_ERROR("Failed to write clips: {}", file.string());
+        return false;
+    }
+    return true;
+}
+
+auto LoadClips(std::filesystem::path const& file, uint32_t joint_count) -> std::optional<std::vector<CompressedClip>>
+{
+    std::ifstream stream(file, std::ios::binary);
+    if (!stream)
+    {
+        SO_ERROR("Failed to open clips: {}", file.string());
+        return std::nullopt;
+    }
+    std::vector<uint8_t> bytes{ std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+
+    BinaryReader reader(bytes.data(), bytes.size());
+    uint32_t magic = reader.Read<uint32_t>();
+    uint32_t version = reader.Read<uint32_t>();
+    if (magic != s_clip_magic || version != s_clip_version)
+    {
+        SO_ERROR("Not a clip file of version {}, import it again: {}", s_clip_version, file.string());
+        return std::nullopt;
+    }
+    uint32_t file_joint_count = reader.Read<uint32_t>();
+    if (file_joint_count != joint_count)
+    {
+        SO_ERROR("Clips are for {} joints, the skeleton has {}: {}", file_joint_count, joint_count, file.string());
+        return std::nullopt;
+    }
+
+    std::vector<CompressedClip> clips;
+    uint32_t clip_count = reader.Read<uint32_t>();
+    for (uint32_t i{ 0 }; i < clip_count && reader.IsValid(); ++i)
+    {
+        CompressedClip& clip = clips.emplace_back();
+        clip.name = reader.ReadString();
+        clip.duration = reader.Read<float>();
+        clip.sample_rate = reader.Read<float>();
+        clip.frame_count = reader.Read<uint32_t>();
+        clip.base = reader.ReadArray<float>();
+        clip.linear = reader.ReadArray<CompressedClip::LinearTrack>();
+        clip.linear_rotations = reader.ReadArray<CompressedClip::LinearRotation>();
+        clip.keyed = reader.ReadArray<CompressedClip::KeyedTrack>();
+        clip.keyed_rotations = reader.ReadArray<uint32_t>();
+        clip.frame_stride = reader.Read<uint32_t>();
+        clip.keys = reader.ReadArray<uint16_t>();
+        if (reader.IsValid() && !IsConsistent(clip, joint_count))
+        {
+            SO_ERROR("Clip {} is malformed: {}", clip.name, file.string());
+            return std::nullopt;
+        }
+    }
+    if (!reader.AtEnd())
+    {
+        SO_ERROR("Clip file is malformed: {}", file.string());
+        return std::nullopt;
+    }
+    return clips;
+}
+
+void BlendPoses(Pose const& from, Pose const& to, float weight, Pose& out)
+{
+    uint32_t stride = from.Stride();
+    if (to.Stride() != stride || out.Stride() != stride)
+    {
+        return;
+    }
+
+    auto blend = [stride, weight](float const* a, float const* b, float* result)
+    {
+        for (uint32_t i{ 0 }; i < stride; ++i)
+        {
+            result[i] = a[i] + (b[i] - a[i]) * weight;
+        }
+    };
+    for (PoseStream stream : { PoseStream::TranslationX, PoseStream::TranslationY, PoseStream::TranslationZ,
+                               PoseStream::ScaleX, PoseStream::ScaleY, PoseStream::ScaleZ })
+    {
+        blend(from.Stream(stream), to.Stream(stream), out.Stream(stream));
+    }
+
+    // Clips need not share a hemisphere, `to` is flipped towards `from` per
+    // joint before the blend
+    float const* ax = from.Stream(PoseStream::RotationX);
+    float const* ay = from.Stream(PoseStream::RotationY);
+    float const* az = from.Stream(PoseStream::RotationZ);
+    float const* aw = from.Stream(PoseStream::RotationW);
+    float const* bx = to.Stream(PoseStream::RotationX);
+    float const* by = to.Stream(PoseStream::RotationY);
+    float const* bz = to.Stream(PoseStream::RotationZ);
+    float const* bw = to.Stream(PoseStream::RotationW);
+    float* ox = out.Stream(PoseStream::RotationX);
+    float* oy = out.Stream(PoseStream::RotationY);
+    float* oz = out.Stream(PoseStream::RotationZ);
+    float* ow = out.Stream(PoseStream::RotationW);
+    for (uint32_t i{ 0 }; i < stride; ++i)
+    {
+        float sign = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i] < 0.0f ? -1.0f : 1.0f;
+        float x = ax[i] + (bx[i] * sign - ax[i]) * weight;
+        float y = ay[i] + (by[i] * sign - ay[i]) * weight;
+        float z = az[i] + (bz[i] * sign - az[i]) * weight;
+        float w = aw[i] + (bw[i] * sign - aw[i]) * weight;
+        ox[i] = x;
+        oy[i] = y;
+        oz[i] = z;
+        ow[i] = w;
+    }
+    NormalizeRotations(out);
+}
+
+void ComputePalette(Skeleton const& skeleton, Pose const& pose, std::span<glm::mat4> palette)
+{
+    uint32_t joint_count = std::min(skeleton.JointCount(), static_cast<uint32_t>(palette.size()));
+    // Model space first, a parent is done before its children
+    for (uint32_t joint{ 0 }; joint < joint_count; ++joint)
+    {
+        glm::mat4 local = glm::mat4_cast(pose.GetRotation(joint));
+        glm::vec3 scale = pose.GetScale(joint);
+        local[0] *= scale.x;
+        local[1] *= scale.y;
+        local[2] *= scale.z;
+        local[3] = glm::vec4(pose.GetTranslation(joint), 1.0f);
+
+        int32_t parent = skeleton.parents[joint];
+        palette[joint] = (parent < 0 ? skeleton.root : palette[parent]) * local;
+    }
+    for (uint32_t joint{ 0 }; joint < joint_count; ++joint)
+    {
+        palette[joint] = palette[joint] * skeleton.inverse_bind[joint];
+    }
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+#pragma once
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Streams of a Pose, in memory order
+enum class PoseStream : uint32_t
+{
+    TranslationX,
+    TranslationY,
+    TranslationZ,
+    RotationX,
+    RotationY,
+    RotationZ,
+    RotationW,
+    ScaleX,
+    ScaleY,
+    ScaleZ,
+    Count
+};
+
+// Local joint transforms as structure of arrays, one stream per component
+// with the joint count padded to s_lanes. Loops run over a whole stream
+// for every joint at once and vectorize without a scalar tail. Padding
+// lanes hold identity transforms.
+class Pose
+{
+public:
+    static constexpr uint32_t s_lanes{ 8 };
+    static constexpr uint32_t s_streams{ static_cast<uint32_t>(PoseStream::Count) };
+
+    [[nodiscard]] static constexpr auto PaddedCount(uint32_t joints) -> uint32_t { return (joints + s_lanes - 1) / s_lanes * s_lanes; }
+
+    void Resize(uint32_t joint_count);
+
+    [[nodiscard]] auto JointCount() const -> uint32_t { return m_joint_count; }
+    // Floats per stream
+    [[nodiscard]] auto Stride() const -> uint32_t { return m_stride; }
+    [[nodiscard]] auto Stream(PoseStream stream) -> float* { return m_data.data() + static_cast<uint32_t>(stream) * m_stride; }
+    [[nodiscard]] auto Stream(PoseStream stream) const -> float const* { return m_data.data() + static_cast<uint32_t>(stream) * m_stride; }
+    // Every stream back to back, s_streams * Stride() floats
+    [[nodiscard]] auto Data() -> std::span<float> { return m_data; }
+    [[nodiscard]] auto Data() const -> std::span<float const> { return m_data; }
+
+    void SetTranslation(uint32_t joint, glm::vec3 const& translation);
+    void SetRotation(uint32_t joint, glm::quat const& rotation);
+    void SetScale(uint32_t joint, glm::vec3 const& scale);
+    [[nodiscard]] auto GetTranslation(uint32_t joint) const -> glm::vec3;
+    [[nodiscard]] auto GetRotation(uint32_t joint) const -> glm::quat;
+    [[nodiscard]] auto GetScale(uint32_t joint) const -> glm::vec3;
+private:
+    uint32_t           m_joint_count{ 0 };
+    uint32_t           m_stride{ 0 };
+    std::vector<float> m_data;
+};
+
+struct Skeleton
+{
+    std::vector<std::string> joint_names;
+    std::vector<int32_t>     parents;      // -1 for roots, parents always come before their children
+    std::vector<glm::mat4>   inverse_bind;
+    glm::mat4                root{ 1.0f }; // nodes above the root joints
+    Pose                     rest;
+
+    [[nodiscard]] auto JointCount() const -> uint32_t { return static_cast<uint32_t>(parents.size()); }
+};
+
+// Resampled at a fixed rate on import, every frame is a whole Pose.
+// Rotations of consecutive frames are kept in the same hemisphere, so
+// frames blend component wise. Input to CompressClip, played as is only
+// for reference.
+struct AnimationClip
+{
+    std::string        name;
+    float              duration{ 0.0f };   // seconds
+    float              sample_rate{ 30.0f };
+    uint32_t           frame_count{ 0 };
+    uint32_t           stride{ 0 };        // floats per frame, as Pose::Data
+    std::vector<float> frames;
+};
+
+// Largest error a track may have and still be stored as a constant or a
+// line instead of per frame keys
+struct ClipTolerance
+{
+    float rotation{ 0.0005f };    // per quaternion component, about 0.06 degrees
+    float translation{ 0.0001f }; // model units
+    float scale{ 0.0001f };
+};
+
+// AnimationClip compressed for playback. Every rotation and every
+// translation or scale component is a track, stored as a constant in
+// `base`, as a line over the clip or as 16 bit keys per frame. Rotation
+// keys are smallest three, the largest component is dropped and rebuilt.
+// The keys of one frame are stored together, a sample reads two
+// neighbouring runs of `frame_stride` keys.
+struct CompressedClip
+{
+    struct LinearTrack
+    {
+        uint32_t offset; // into Pose::Data
+        float    start;
+        float    delta;  // over the whole clip
+    };
+
+    struct LinearRotation
+    {
+        uint32_t joint;
+        float    start[4]; // x, y, z, w, `end` in the same hemisphere
+        float    end[4];
+    };
+
+    struct KeyedTrack
+    {
+        uint32_t offset; // into Pose::Data
+        float    min;
+        float    range;  // key 65535 is min + range
+    };
+
+    std::string                 name;
+    float                       duration{ 0.0f };
+    float                       sample_rate{ 30.0f };
+    uint32_t                    frame_count{ 0 };
+    std::vector<float>          base;             // Pose::Data a sample starts from, holds the constants
+    std::vector<LinearTrack>    linear;
+    std::vector<LinearRotation> linear_rotations;
+    std::vector<KeyedTrack>     keyed;
+    std::vector<uint32_t>       keyed_rotations;  // joints
+    uint32_t                    frame_stride{ 0 }; // keys per frame, 3 per keyed rotation then 1 per keyed track
+    std::vector<uint16_t>       keys;
+
+    [[nodiscard]] auto ByteSize() const -> size_t;
+};
+
+// Everything a skinned model animates with, shared by the model and the
+// jobs evaluating it
+struct SkinInfo
+{
+    Skeleton                    skeleton;
+    std::vector<CompressedClip> clips;
+
+    [[nodiscard]] auto FindClip(std::string_view name) const -> std::optional<uint32_t>;
+};
+
+// `time` past the end wraps when looping and holds the last frame otherwise
+void SampleClip(AnimationClip const& clip, float time, bool loop, Pose& out);
+void SampleClip(CompressedClip const& clip, float time, bool loop, Pose& out);
+// Tracks within `tolerance` of a constant or a line are stored as such
+[[nodiscard]] auto CompressClip(AnimationClip const& clip, uint32_t joint_count, ClipTolerance const& tolerance = {}) -> CompressedClip;
+// Compact clip files, written by tools/animimport.cpp and loaded with the
+// model they were imported from. Loading fails when the joint count does
+// not match.
+auto SaveClips(std::filesystem::path const& file, std::vector<CompressedClip> const& clips, uint32_t joint_count) -> bool;
+[[nodiscard]] auto LoadClips(std::filesystem::path const& file, uint32_t joint_count) -> std::optional<std::vector<CompressedClip>>;
+// `out` is `from` at weight 0 and `to` at 1, any of them may alias
+void BlendPoses(Pose const& from, Pose const& to, float weight, Pose& out);
+// Skinning matrices, model space joint transforms times the inverse bind
+// matrices. `palette` holds one matrix per joint.
+void ComputePalette(Skeleton const& skeleton, Pose const& pose, std::span<glm::mat4> palette);
\ No newline at end of file
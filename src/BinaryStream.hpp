@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Values as raw bytes in host order, for caches written and read by the
+// same build. Only trivially copyable types without pointers.
+class BinaryWriter
+{
+public:
+    template <typename T>
+    void Write(T const& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>);
+        auto const* bytes = reinterpret_cast<uint8_t const*>(&value);
+        m_bytes.insert(m_bytes.end(), bytes, bytes + sizeof(T));
+    }
+
+    void WriteString(std::string const& str)
+    {
+        Write(static_cast<uint32_t>(str.size()));
+        m_bytes.insert(m_bytes.end(), str.begin(), str.end());
+    }
+
+    template <typename T>
+    void WriteArray(std::vector<T> const& values)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>);
+        Write(static_cast<uint32_t>(values.size()));
+        auto const* bytes = reinterpret_cast<uint8_t const*>(values.data());
+        m_bytes.insert(m_bytes.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+
+    [[nodiscard]] auto Bytes() const -> std::vector<uint8_t> const& { return m_bytes; }
+private:
+    std::vector<uint8_t> m_bytes;
+};
+
+// Reads stop at the first overrun, check IsValid once at the end
+class BinaryReader
+{
+public:
+    BinaryReader(uint8_t const* data, size_t size) : m_data(data), m_size(size) {}
+
+    template <typename T>
+    auto Read() -> T
+    {
+        T value{};
+        if (m_offset + sizeof(T) > m_size)
+        {
+            m_offset = m_size + 1;
+            return value;
+        }
+        std::memcpy(&value, m_data + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return value;
+    }
+
+    auto ReadString() -> std::string
+    {
+        uint32_t size = Read<uint32_t>();
+        if (m_offset + size > m_size)
+        {
+            m_offset = m_size + 1;
+            return {};
+        }
+        std::string str(reinterpret_cast<char const*>(m_data + m_offset), size);
+        m_offset += size;
+        return str;
+    }
+
+    template <typename T>
+    auto ReadArray() -> std::vector<T>
+    {
+        uint32_t count = Read<uint32_t>();
+        if (!IsValid() || count * sizeof(T) > m_size - m_offset)
+        {
+            m_offset = m_size + 1;
+            return {};
+        }
+        std::vector<T> values(count);
+        std::memcpy(values.data(), m_data + m_offset, count * sizeof(T));
+        m_offset += count * sizeof(T);
+        return values;
+    }
+
+    [[nodiscard]] auto IsValid() const -> bool { return m_offset <= m_size; }
+    [[nodiscard]] auto AtEnd() const -> bool { return m_offset == m_size; }
+private:
+    uint8_t const* m_data;
+    size_t         m_size;
+    size_t         m_offset{ 0 };
+};
\ No newline at end of file
@@ -8,6 +8,8 @@ Camera::Camera()
 
 void Camera::SetPosition(glm::vec3 const& pos)
 {
+    // Controllers set both every frame, unchanged cameras stay cached
+    m_dirty |= pos != m_position;
     m_position = pos;
 }
 
@@ -18,6 +20,7 @@ auto Camera::GetPosition() const -> glm::vec3 const&
 
 void Camera::SetRotation(const glm::quat& rotation)
 {
+    m_dirty |= rotation != m_rotation;
     m_rotation = rotation;
 }
 
@@ -78,22 +81,56 @@ void Camera::RecalcProjection()
             break;
         }
     }
+    m_dirty = true;
 }
 
-auto Camera::GetViewMatrix() const -> glm::mat4
+void Camera::Refresh() const
 {
-    glm::mat4 rotationMat = glm::mat4_cast(m_rotation);
-    glm::mat4 translationMat = glm::translate(glm::mat4(1.0f), -m_position);
-    glm::mat4 view = glm::mat4_cast(glm::conjugate(m_rotation)) * translationMat;
+    if (!m_dirty)
+    {
+        return;
+    }
+    // Rigid transform, the inverse is the transform itself
+    glm::mat4 rotation = glm::mat4_cast(m_rotation);
+    m_inverse_view = glm::translate(glm::mat4(1.0f), m_position) * rotation;
+    m_view = glm::transpose(rotation) * glm::translate(glm::mat4(1.0f), -m_position);
+    m_view_projection = m_projection * m_view;
+    m_inverse_view_projection = glm::inverse(m_view_projection);
+    m_frustum = Frustum::FromMatrix(m_view_projection);
+    m_dirty = false;
+}
 
-    return view;
+auto Camera::GetViewMatrix() const -> glm::mat4 const&
+{
+    Refresh();
+    return m_view;
+}
+
+auto Camera::GetInverseViewMatrix() const -> glm::mat4 const&
+{
+    Refresh();
+    return m_inverse_view;
 }
 
-auto Camera::GetProjectionMatrix() const -> glm::mat4
+auto Camera::GetProjectionMatrix() const -> glm::mat4 const&
 {
     return m_projection;
 }
-auto Camera::GetViewProjectionMatrix() const -> glm::mat4
+
+auto Camera::GetViewProjectionMatrix() const -> glm::mat4 const&
+{
+    Refresh();
+    return m_view_projection;
+}
+
+auto Camera::GetInverseViewProjectionMatrix() const -> glm::mat4 const&
 {
-    return GetProjectionMatrix() * GetViewMatrix();
+    Refresh();
+    return m_inverse_view_projection;
 }
+
+auto Camera::GetFrustum() const -> Frustum const&
+{
+    Refresh();
+    return m_frustum;
+}
\ No newline at end of file
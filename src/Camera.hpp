@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
+#include "Frustum.hpp"
 
 enum class ProjectionType
 {
@@ -27,11 +28,17 @@ public:
 
     void SetOrthoParams(float left, float right, float bottom, float top, float nearZ, float farZ);
 
-    auto GetViewMatrix() const -> glm::mat4;
-    auto GetProjectionMatrix() const -> glm::mat4;
-    auto GetViewProjectionMatrix() const -> glm::mat4;
+    // Derived data is rebuilt by the first getter after a change. Getters
+    // are not thread safe, hand other threads a RenderView (ViewSet).
+    auto GetViewMatrix() const -> glm::mat4 const&;
+    auto GetInverseViewMatrix() const -> glm::mat4 const&;
+    auto GetProjectionMatrix() const -> glm::mat4 const&;
+    auto GetViewProjectionMatrix() const -> glm::mat4 const&;
+    auto GetInverseViewProjectionMatrix() const -> glm::mat4 const&;
+    auto GetFrustum() const -> Frustum const&;
 private:
     void RecalcProjection();
+    void Refresh() const;
 private:
     ProjectionType m_projection_type = ProjectionType::Perspective;
 
@@ -50,4 +57,11 @@ private:
     float m_far_z_ortho   = 100.f;
 
     glm::mat4 m_projection = glm::mat4(1.f);
+
+    mutable bool      m_dirty                   = true;
+    mutable glm::mat4 m_view                    = glm::mat4(1.f);
+    mutable glm::mat4 m_inverse_view            = glm::mat4(1.f);
+    mutable glm::mat4 m_view_projection         = glm::mat4(1.f);
+    mutable glm::mat4 m_inverse_view_projection = glm::mat4(1.f);
+    mutable Frustum   m_frustum{};
 };
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+#include "ConfigSnapshot.hpp"
+#include "Logger.hpp"
+#include "Hash.hpp"
+#include "BinaryStream.hpp"
+
+namespace {
+    // Bump whenever the layout below or the resolved config structs change
+    constexpr uint32_t s_snapshot_version{ 8 };
+    constexpr uint32_t s_snapshot_magic{ 0x53434F53 }; // "SOCS"
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t input_hash;
+        uint64_t payload_hash;
+        uint64_t payload_size;
+    };
+
+    void WriteShader(BinaryWriter& writer, PendingShader const& shader)
+    {
+        ShaderInfo const& info = shader.info;
+        writer.WriteString(shader.name);
+        writer.Write(info.is_byte_code);
+        writer.WriteString(info.source_path.string());
+        writer.Write(info.stage);
+        writer.Write(info.format);
+        writer.WriteString(info.entry_point);
+        writer.Write(info.num_samplers);
+        writer.Write(info.num_storage_buffers);
+        writer.Write(info.num_uniform_buffers);
+    }
+
+    auto ReadShader(BinaryReader& reader) -> PendingShader
+    {
+        PendingShader shader{};
+        ShaderInfo& info = shader.info;
+        shader.name = reader.ReadString();
+        info.is_byte_code = reader.Read<bool>();
+        info.source_path = reader.ReadString();
+        info.stage = reader.Read<SDL_GPUShaderStage>();
+        info.format = reader.Read<uint32_t>();
+        info.entry_point = reader.ReadString();
+        info.num_samplers = reader.Read<uint32_t>();
+        info.num_storage_buffers = reader.Read<uint32_t>();
+        info.num_uniform_buffers = reader.Read<uint32_t>();
+        return shader;
+    }
+
+    void WriteComputePipeline(BinaryWriter& writer, std::string const& name, ComputePipelineInfo const& info)
+    {
+        WriteShader(writer, { name, info.shader });
+        writer.Write(info.num_readonly_storage_textures);
+        writer.Write(info.num_readwrite_storage_textures);
+        writer.Write(info.num_readwrite_storage_buffers);
+        writer.Write(info.threadcount_x);
+        writer.Write(info.threadcount_y);
+        writer.Write(info.threadcount_z);
+    }
+
+    auto ReadComputePipeline(BinaryReader& reader) -> std::pair<std::string, ComputePipelineInfo>
+    {
+        PendingShader shader = ReadShader(reader);
+        std::pair<std::string, ComputePipelineInfo> pipeline{ std::move(shader.name), {} };
+        ComputePipelineInfo& info = pipeline.second;
+        info.shader = std::move(shader.info);
+        info.num_readonly_storage_textures = reader.Read<uint32_t>();
+        info.num_readwrite_storage_textures = reader.Read<uint32_t>();
+        info.num_readwrite_storage_buffers = reader.Read<uint32_t>();
+        info.threadcount_x = reader.Read<uint32_t>();
+        info.threadcount_y = reader.Read<uint32_t>();
+        info.threadcount_z = reader.Read<uint32_t>();
+        return pipeline;
+    }
+
+    // SDL state structs are written as raw bytes. They carry explicit
+    // padding members and no pointers, value initialization keeps the
+    // bytes deterministic. Array pointers and shaders are patched by
+    // CreatePipeline.
+    void WritePipeline(BinaryWriter& writer, std::string const& name, PipelineInfo const& info)
+    {
+        SDL_GPUGraphicsPipelineCreateInfo const& create_info = info.create_info;
+        writer.WriteString(name);
+        writer.WriteString(info.vertex_shader);
+        writer.WriteString(info.fragment_shader);
+        writer.WriteArray(info.vertex_buffer_descriptions);
+        writer.WriteArray(info.vertex_attributes);
+        writer.WriteArray(info.color_target_descriptions);
+        writer.Write(create_info.primitive_type);
+        writer.Write(create_info.rasterizer_state);
+        writer.Write(create_info.multisample_state);
+        writer.Write(create_info.depth_stencil_state);
+        writer.Write(create_info.target_info.depth_stencil_format);
+        writer.Write(create_info.target_info.has_depth_stencil_target);
+    }
+
+    auto ReadPipeline(BinaryReader& reader) -> std::pair<std::string, PipelineInfo>
+    {
+        std::pair<std::string, PipelineInfo> pipeline{};
+        auto& [name, info] = pipeline;
+        SDL_GPUGraphicsPipelineCreateInfo& create_info = info.create_info;
+        name = reader.ReadString();
+        info.vertex_shader = reader.ReadString();
+        info.fragment_shader = reader.ReadString();
+        info.vertex_buffer_descriptions = reader.ReadArray<SDL_GPUVertexBufferDescription>();
+        info.vertex_attributes = reader.ReadArray<SDL_GPUVertexAttribute>();
+        info.color_target_descriptions = reader.ReadArray<SDL_GPUColorTargetDescription>();
+        create_info.primitive_type = reader.Read<SDL_GPUPrimitiveType>();
+        create_info.rasterizer_state = reader.Read<SDL_GPURasterizerState>();
+        create_info.multisample_state = reader.Read<SDL_GPUMultisampleState>();
+        create_info.depth_stencil_state = reader.Read<SDL_GPUDepthStencilState>();
+        create_info.target_info.depth_stencil_format = reader.Read<SDL_GPUTextureFormat>();
+        create_info.target_info.has_depth_stencil_target = reader.Read<bool>();
+        return pipeline;
+    }
+}
+
+auto ConfigSnapshot::InputHash(std::filesystem::path const& root) -> uint64_t
+{
+    uint64_t hash = Fnv1a::HashValue(s_snapshot_version);
+    // Catches SDL header updates that change the raw structs
+    hash = Fnv1a::HashValue(sizeof(SDL_GPURasterizerState), hash);
+    hash = Fnv1a::HashValue(sizeof(SDL_GPUDepthStencilState), hash);
+    hash = Fnv1a::HashValue(sizeof(SDL_GPUColorTargetDescription), hash);
+    // Paths are resolved against the root when parsed and stored resolved,
+    // a snapshot is only valid for the tree it was written from
+    hash = Fnv1a::Hash(std::filesystem::absolute(root).lexically_normal().generic_string(), hash);
+
+    std::vector<std::filesystem::path> scripts;
+    for (char const* dir : { "preludes", "shaders", "pipelines", "compute", "models" })
+    {
+        std::error_code error;
+        for (auto& entry : std::filesystem::directory_iterator(root/dir, error))
+        {
+            if (entry.path().extension().string() == ".lua")
+            {
+                scripts.push_back(entry.path());
+            }
+        }
+    }
+    if (std::filesystem::exists(root/"engine.lua"))
+    {
+        scripts.push_back(root/"engine.lua");
+    }
+    // Directory order is unspecified
+    std::sort(scripts.begin(), scripts.end());
+
+    for (auto const& script : scripts)
+    {
+        std::ifstream file(script, std::ios::binary);
+        std::string content{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        hash = Fnv1a::Hash(script.lexically_relative(root).generic_string(), hash);
+        hash = Fnv1a::HashValue(content.size(), hash);
+        hash = Fnv1a::Hash(content, hash);
+    }
+    return hash;
+}
+
+auto ConfigSnapshot::Load(std::filesystem::path const& file, uint64_t input_hash) -> std::optional<ConfigSnapshot>
+{
+    std::ifstream stream(file, std::ios::binary);
+    if (!stream)
+    {
+        return std::nullopt;
+    }
+
+    Header header{};
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!stream ||
+        header.magic != s_snapshot_magic ||
+        header.version != s_snapshot_version ||
+        header.input_hash != input_hash)
+    {
+        return std::nullopt;
+    }
+
+    // A torn or corrupt header must not size the allocation
+    std::error_code error;
+    uintmax_t file_size = std::filesystem::file_size(file, error);
+    if (error || header.payload_size > file_size - sizeof(Header))
+    {
+        SO_WARN("Config snapshot is corrupt: {}", file.string());
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> payload(header.payload_size);
+    stream.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    if (!stream || Fnv1a::Hash(payload.data(), payload.size()) != header.payload_hash)
+    {
+        SO_WARN("Config snapshot is corrupt: {}", file.string());
+        return std::nullopt;
+    }
+
+    ConfigSnapshot snapshot{};
+    BinaryReader reader(payload.data(), payload.size());
+    snapshot.engine.model_budget = reader.Read<uint64_t>();
+    snapshot.engine.script_gc_budget_ms = reader.Read<float>();
+    snapshot.engine.script_threads = reader.Read<uint32_t>();
+    snapshot.engine.sim_rate = reader.Read<uint32_t>();
+    snapshot.engine.max_sim_steps = reader.Read<uint32_t>();
+    snapshot.engine.present_mode = static_cast<SDL_GPUPresentMode>(reader.Read<uint32_t>());
+    snapshot.engine.max_fps = reader.Read<uint32_t>();
+    snapshot.engine.background_fps = reader.Read<uint32_t>();
+    snapshot.engine.gpu_budget_ms = reader.Read<float>();
+    snapshot.engine.min_render_scale = reader.Read<float>();
+    snapshot.engine.max_render_scale = reader.Read<float>();
+    snapshot.engine.gpu_culling = reader.Read<bool>();
+    uint32_t shader_count = reader.Read<uint32_t>();
+    for (uint32_t i{ 0 }; i < shader_count && reader.IsValid(); ++i)
+    {
+        snapshot.shaders.push_back(ReadShader(reader));
+    }
+    uint32_t pipeline_count = reader.Read<uint32_t>();
+    for (uint32_t i{ 0 }; i < pipeline_count && reader.IsValid(); ++i)
+    {
+        snapshot.pipelines.push_back(ReadPipeline(reader));
+    }
+    uint32_t compute_pipeline_count = reader.Read<uint32_t>();
+    for (uint32_t i{ 0 }; i < compute_pipeline_count && reader.IsValid(); ++i)
+    {
+        snapshot.compute_pipelines.push_back(ReadComputePipeline(reader));
+    }
+    uint32_t model_count = reader.Read<uint32_t>();
+    for (uint32_t i{ 0 }; i < model_count && reader.IsValid(); ++i)
+    {
+        std::string name = reader.ReadString();
+        std::string path = reader.ReadString();
+        std::string clips = reader.ReadString();
+        snapshot.models.push_back({ std::move(name), std::move(path), std::move(clips) });
+    }
+
+    if (!reader.AtEnd())
+    {
+        SO_WARN("Config snapshot is malformed: {}", file.string());
+        return std::nullopt;
+    }
+    return snapshot;
+}
+
+auto ConfigSnapshot::Save(std::filesystem::path const& file, uint64_t input_hash) const -> bool
+{
+    BinaryWriter writer;
+    writer.Write(engine.model_budget);
+    writer.Write(engine.script_gc_budget_ms);
+    writer.Write(engine.script_threads);
+    writer.Write(engine.sim_rate);
+    writer.Write(engine.max_sim_steps);
+    writer.Write(static_cast<uint32_t>(engine.present_mode));
+    writer.Write(engine.max_fps);
+    writer.Write(engine.background_fps);
+    writer.Write(engine.gpu_budget_ms);
+    writer.Write(engine.min_render_scale);
+    writer.Write(engine.max_render_scale);
+    writer.Write(engine.gpu_culling);
+    writer.Write(static_cast<uint32_t>(shaders.size()));
+    for (auto const& shader : shaders)
+    {
+        WriteShader(writer, shader);
+    }
+    writer.Write(static_cast<uint32_t>(pipelines.size()));
+    for (auto const& [name, info] : pipelines)
+    {
+        WritePipeline(writer, name, info);
+    }
+    writer.Write(static_cast<uint32_t>(compute_pipelines.size()));
+    for (auto const& [name, info] : compute_pipelines)
+    {
+        WriteComputePipeline(writer, name, info);
+    }
+    writer.Write(static_cast<uint32_t>(models.size()));
+    for (auto const& model : models)
+    {
+        writer.WriteString(model.name);
+        writer.WriteString(model.path.string());
+        writer.WriteString(model.clips.string());
+    }
+
+    std::vector<uint8_t> const& payload = writer.Bytes();
+    Header header{
+        .magic = s_snapshot_magic,
+        .version = s_snapshot_version,
+        .input_hash = input_hash,
+        .payload_hash = Fnv1a::Hash(payload.data(), payload.size()),
+        .payload_size = payload.size(),
+    };
+
+    // Written aside and renamed so a crash never leaves a torn snapshot
+    std::error_code error;
+    std::filesystem::create_directories(file.parent_path(), error);
+    std::filesystem::path temp = file;
+    temp += ".tmp";
+    {
+        std::ofstream stream(temp, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        stream.write(reinterpret_cast<char const*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        if (!stream)
+        {
+            SO_WARN("Failed to write config snapshot: {}", temp.string());
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, file, error);
+    if (error)
+    {
+        SO_WARN("Failed to write config snapshot: {}", error.message());
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <filesystem>
+#include "ResourceManager.hpp"
+
+// Fully resolved config scripts. Written after a Lua startup together with
+// a hash of every script, a later startup with unchanged scripts loads it
+// without creating a Lua state.
+struct ConfigSnapshot
+{
+    EngineConfig                                             engine{};
+    std::vector<PendingShader>                               shaders;
+    std::vector<std::pair<std::string, PipelineInfo>>        pipelines;
+    std::vector<std::pair<std::string, ComputePipelineInfo>> compute_pipelines;
+    std::vector<ModelSource>                                 models;
+
+    // Where root is, the scripts below it and the snapshot format version
+    [[nodiscard]] static auto InputHash(std::filesystem::path const& root) -> uint64_t;
+    // Fails on a missing or corrupt file and on a hash mismatch
+    [[nodiscard]] static auto Load(std::filesystem::path const& file, uint64_t input_hash) -> std::optional<ConfigSnapshot>;
+    auto Save(std::filesystem::path const& file, uint64_t input_hash) const -> bool;
+};
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include "DynamicResolution.hpp"
+#include "Logger.hpp"
+
+namespace {
+    // Steps per change, quick to give time back and slow to take it
+    constexpr float s_max_step_down{ 0.15f };
+    constexpr float s_max_step_up{ 0.05f };
+    // Changes smaller than this are not worth a visible jump
+    constexpr float s_min_step{ 0.02f };
+}
+
+DynamicResolution::DynamicResolution(DynamicResolutionSettings const& settings)
+    : m_settings(settings)
+    , m_scale(settings.max_scale)
+{
+    m_settings.min_scale = std::clamp(m_settings.min_scale, 0.1f, 1.0f);
+    m_settings.max_scale = std::clamp(m_settings.max_scale, m_settings.min_scale, 1.0f);
+    m_scale = m_settings.max_scale;
+}
+
+void DynamicResolution::AddSample(float gpu_ms)
+{
+    if (m_settings.budget_ms <= 0.0f)
+    {
+        return;
+    }
+    m_samples[m_next] = gpu_ms;
+    m_next = (m_next + 1) % s_window;
+    m_count = std::min(m_count + 1, s_window);
+    if (m_cooldown > 0)
+    {
+        --m_cooldown;
+        return;
+    }
+
+    float average = GetAverageMs();
+    float load = average / m_settings.budget_ms;
+    if (load >= s_lower_threshold && load <= s_upper_threshold)
+    {
+        return;
+    }
+
+    // Aim at the middle of the band
+    float target_load = (s_lower_threshold + s_upper_threshold) * 0.5f;
+    float wanted = m_scale * std::sqrt(target_load / std::max(load, 0.01f));
+    float scale = std::clamp(wanted, m_scale - s_max_step_down, m_scale + s_max_step_up);
+    scale = std::clamp(scale, m_settings.min_scale, m_settings.max_scale);
+    if (std::abs(scale - m_scale) < s_min_step)
+    {
+        return;
+    }
+    SO_INFO("Render scale {:.2f} -> {:.2f}, GPU {:.2f} ms of {:.2f} ms", m_scale, scale, average, m_settings.budget_ms);
+    // Older samples stand in for the new scale until they roll out
+    float cost_ratio = (scale * scale) / (m_scale * m_scale);
+    for (uint32_t i{ 0 }; i < m_count; ++i)
+    {
+        m_samples[i] *= cost_ratio;
+    }
+    m_scale = scale;
+    m_cooldown = s_cooldown;
+}
+
+auto DynamicResolution::GetAverageMs() const -> float
+{
+    if (m_count == 0)
+    {
+        return 0.0f;
+    }
+    return std::accumulate(m_samples.begin(), m_samples.begin() + m_count, 0.0f) / static_cast<float>(m_count);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+struct DynamicResolutionSettings
+{
+    float budget_ms{ 0.0f }; // GPU time per frame to stay under, 0 keeps max_scale
+    float min_scale{ 0.5f }; // per axis
+    float max_scale{ 1.0f };
+};
+
+// Picks the render scale from the rolling average GPU time of recent
+// frames, checked on every sample. Cost is taken to follow the pixel count,
+// the square of the scale. Between the two thresholds nothing changes, and
+// after a change the scale holds for a cooldown, so it does not flip back
+// and forth around the budget.
+class DynamicResolution
+{
+public:
+    // Frames averaged, the most recent ones
+    static constexpr uint32_t s_window{ 30 };
+    // Samples after a change before the next one, frames still in flight
+    // were rendered at the old scale
+    static constexpr uint32_t s_cooldown{ 10 };
+    // Relative to the budget
+    static constexpr float    s_lower_threshold{ 0.75f };
+    static constexpr float    s_upper_threshold{ 0.95f };
+
+    explicit DynamicResolution(DynamicResolutionSettings const& settings = {});
+
+    // GPU time of a completed frame rendered at the current scale
+    void AddSample(float gpu_ms);
+
+    [[nodiscard]] auto GetScale() const -> float { return m_scale; }
+    [[nodiscard]] auto GetAverageMs() const -> float;
+private:
+    DynamicResolutionSettings    m_settings;
+    float                        m_scale;
+    std::array<float, s_window>  m_samples{}; // ring buffer
+    uint32_t                     m_next{ 0 };
+    uint32_t                     m_count{ 0 };
+    uint32_t                     m_cooldown{ 0 };
+};
\ No newline at end of file
@@ -1,26 +1,311 @@
+#include <thread>
+#include <utility>
+#include <charconv>
+#include <algorithm>
+#include <string_view>
 #include "Engine.hpp"
+#include "Logger.hpp"
 #include "ResourceManager.hpp"
+#include "Profiler.hpp"
 #include "SDL3/SDL_gpu.h"
 
-void Engine::Initialize()
+namespace {
+    constexpr uint64_t s_min_spin_ns{ 200'000 };
+    constexpr uint64_t s_max_spin_ns{ 4'000'000 };
+
+    auto PresentModeName(SDL_GPUPresentMode mode) -> char const*
+    {
+        switch (mode)
+        {
+        case SDL_GPU_PRESENTMODE_VSYNC:
+            return "vsync";
+        case SDL_GPU_PRESENTMODE_IMMEDIATE:
+            return "immediate";
+        case SDL_GPU_PRESENTMODE_MAILBOX:
+            return "mailbox";
+        }
+        return "unknown";
+    }
+
+    // background_fps only ever lowers the cap
+    auto BackgroundRate(EngineConfig const& config) -> uint32_t
+    {
+        if (config.background_fps == 0)
+        {
+            return config.max_fps;
+        }
+        return config.max_fps == 0 ? config.background_fps : std::min(config.max_fps, config.background_fps);
+    }
+}
+
+auto ParseEngineOptions(int argc, char* argv[]) -> EngineOptions
+{
+    EngineOptions options{};
+    auto read_size = [](char const* text, uint32_t& value)
+    {
+        std::string_view str{ text };
+        uint32_t parsed{ 0 };
+        auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), parsed);
+        if (error != std::errc{} || end != str.data() + str.size() || parsed == 0)
+        {
+            SO_WARN("Ignoring invalid size {}", str);
+            return;
+        }
+        value = parsed;
+    };
+
+    for (int i{ 1 }; i < argc; ++i)
+    {
+        std::string_view arg{ argv[i] };
+        bool has_value = i + 1 < argc;
+        if (arg == "--headless")
+        {
+            options.headless = true;
+        }
+        else if (arg == "--no-render-thread")
+        {
+            options.render_thread = false;
+        }
+        else if (arg == "--no-hot-reload")
+        {
+            options.hot_reload = false;
+        }
+        else if (arg == "--config" && has_value)
+        {
+            options.config_root = argv[++i];
+        }
+        else if (arg == "--width" && has_value)
+        {
+            read_size(argv[++i], options.width);
+        }
+        else if (arg == "--height" && has_value)
+        {
+            read_size(argv[++i], options.height);
+        }
+    }
+    return options;
+}
+
+FixedTimestep::FixedTimestep(uint32_t rate, uint32_t max_steps)
+    : m_step_ns(1'000'000'000ull / std::max(rate, 1u))
+    , m_max_steps(std::max(max_steps, 1u))
+{
+}
+
+auto FixedTimestep::Advance(uint64_t elapsed_ns) -> uint32_t
+{
+    m_accumulator += elapsed_ns;
+    uint64_t steps = m_accumulator / m_step_ns;
+    if (steps > m_max_steps)
+    {
+        // Keep the fraction so Alpha does not jump
+        m_dropped_ns += (steps - m_max_steps) * m_step_ns;
+        steps = m_max_steps;
+    }
+    m_accumulator %= m_step_ns;
+    return static_cast<uint32_t>(steps);
+}
+
+void FrameLimiter::SetRate(uint32_t fps)
+{
+    if (fps == m_fps)
+    {
+        return;
+    }
+    m_fps = fps;
+    m_period_ns = fps == 0 ? 0 : 1'000'000'000ull / fps;
+    m_deadline_ns = 0;
+}
+
+void FrameLimiter::Wait()
+{
+    if (m_period_ns == 0)
+    {
+        return;
+    }
+    SO_PROFILE_FUNCTION();
+    uint64_t now = SDL_GetTicksNS();
+    if (m_deadline_ns == 0 || now >= m_deadline_ns + m_period_ns)
+    {
+        m_deadline_ns = now + m_period_ns;
+        return;
+    }
+
+    if (now + m_spin_ns < m_deadline_ns)
+    {
+        uint64_t wake = m_deadline_ns - m_spin_ns;
+        SDL_DelayNS(wake - now);
+        uint64_t woke = SDL_GetTicksNS();
+        uint64_t overshoot = woke > wake ? woke - wake : 0;
+        // Grows at once, shrinks slowly
+        m_spin_ns = std::clamp(std::max(overshoot + overshoot / 4, m_spin_ns - m_spin_ns / 16), s_min_spin_ns, s_max_spin_ns);
+    }
+    while (SDL_GetTicksNS() < m_deadline_ns)
+    {
+        std::this_thread::yield();
+    }
+    m_deadline_ns += m_period_ns;
+}
+
+void Engine::Initialize(EngineOptions const& options)
 {
+    SO_PROFILE_THREAD("main");
+    SO_PROFILE_FUNCTION();
+    m_options = options;
     SDL_SetAppMetadata("soulike", "0.1", "com.w6rsty.soulike");
+    if (m_options.headless)
+    {
+        // Vulkan still loads through the video subsystem, no display needed
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    }
     SDL_Init(SDL_INIT_VIDEO);
 
-    /// Create window
-    m_window.handle = SDL_CreateWindow("window", 800, 600, SDL_WINDOW_RESIZABLE);
-
     /// Create GPU device
-    m_rhi.device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_MSL, m_rhi.debug_mode, nullptr);
-    SDL_ClaimWindowForGPUDevice(m_rhi.device, m_window.handle);
+    // Shader sources are compiled to whichever of these the device takes
+    SDL_GPUShaderFormat formats = m_options.headless
+        ? SDL_GPU_SHADERFORMAT_SPIRV
+        : SDL_GPU_SHADERFORMAT_SPIRV | SDL_GPU_SHADERFORMAT_MSL;
+    m_rhi.device = SDL_CreateGPUDevice(formats, m_rhi.debug_mode, nullptr);
+    if (!m_rhi.device)
+    {
+        SO_ERROR("Failed to create GPU device, {}", SDL_GetError());
+    }
+    else
+    {
+        SO_INFO("GPU driver: {}", SDL_GetGPUDeviceDriver(m_rhi.device));
+    }
+
+    if (m_options.headless)
+    {
+        SDL_GPUTextureCreateInfo info{
+            .type = SDL_GPU_TEXTURETYPE_2D,
+            // Matches the swapchain the pipelines are configured for
+            .format = Renderer::s_offscreen_format,
+            .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+            .width = m_options.width,
+            .height = m_options.height,
+            .layer_count_or_depth = 1,
+            .num_levels = 1,
+        };
+        m_rhi.offscreen_texture = {
+            .handle = SDL_CreateGPUTexture(m_rhi.device, &info),
+            .width = m_options.width,
+            .height = m_options.height,
+        };
+    }
+    else
+    {
+        /// Create window
+        m_window.handle = SDL_CreateWindow(
+            "window",
+            static_cast<int>(m_options.width),
+            static_cast<int>(m_options.height),
+            SDL_WINDOW_RESIZABLE);
+        SDL_ClaimWindowForGPUDevice(m_rhi.device, m_window.handle);
+    }
+    m_renderer = std::make_unique<Renderer>(m_rhi.device, m_window.handle, m_rhi.offscreen_texture, m_options.render_thread);
+
+    // The main thread is the last worker
+    m_jobs = std::make_unique<JobSystem>(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
+    std::filesystem::path root = std::filesystem::absolute(m_options.config_root).lexically_normal();
+    SO_INFO("Config root: {}", root.string());
+    ResourceManager::Initialize(root, m_rhi.device, *m_jobs);
+    if (m_options.hot_reload)
+    {
+        ResourceManager::Instance().EnableHotReload();
+    }
 
-    ResourceManager::Initialize("/Users/w6rsty/dev/Cpp/soulike/config", m_rhi.device);
+    uint32_t script_threads = ResourceManager::Instance().GetEngineConfig().script_threads;
+    if (script_threads == 0)
+    {
+        script_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    m_scripts = std::make_unique<ScriptRuntime>(root/"scripts", script_threads);
+    m_world = std::make_unique<World>();
+
+    EngineConfig const& config = ResourceManager::Instance().GetEngineConfig();
+    m_timestep = FixedTimestep(config.sim_rate, config.max_sim_steps);
+    SO_INFO("Simulation: {} Hz, up to {} steps per frame", config.sim_rate, config.max_sim_steps);
+    if (m_window.handle)
+    {
+        // Claiming the window set up vsync, stays on it when unsupported
+        SetPresentMode(config.present_mode);
+    }
+    m_limiter.SetRate(config.max_fps);
+    m_resolution = DynamicResolution({
+        .budget_ms = config.gpu_budget_ms,
+        .min_scale = config.min_render_scale,
+        .max_scale = config.max_render_scale,
+    });
+    if (config.gpu_culling)
+    {
+        auto& mgr = ResourceManager::Instance();
+        m_cull_pipeline = mgr.AcquireComputePipeline("cull"_rid);
+        m_instanced_pipeline = mgr.AcquirePipeline("instanced"_rid);
+        if (!m_cull_pipeline.IsValid() || !m_instanced_pipeline.IsValid())
+        {
+            SO_WARN("GPU culling needs the cull compute pipeline and the instanced pipeline, culling on the CPU");
+            mgr.Release(m_cull_pipeline);
+            mgr.Release(m_instanced_pipeline);
+            m_cull_pipeline = {};
+            m_instanced_pipeline = {};
+        }
+    }
+    SO_INFO("Culling on the {}", IsGpuCulling() ? "GPU" : "CPU");
+    m_skinned_pipeline = ResourceManager::Instance().AcquirePipeline("skinned"_rid);
+    if (!m_skinned_pipeline.IsValid())
+    {
+        SO_WARN("No skinned pipeline, skinned models are drawn in their bind pose");
+    }
+    m_last_ticks_ns = SDL_GetTicksNS();
 }
 
 void Engine::Destroy()
 {
+    // Finishes the frames in flight, nothing below is used by the GPU after
+    if (m_renderer)
+    {
+        m_renderer->WaitIdle();
+        LatencyStats latency = m_renderer->GetLatencyStats();
+        if (latency.frames > 0)
+        {
+            SO_INFO("Input to present: {:.2f} ms mean, {:.2f} ms max over {} frames",
+                latency.total_ms / static_cast<double>(latency.frames), latency.max_ms, latency.frames);
+        }
+        m_renderer.reset();
+    }
+    if (m_timestep.DroppedNS() > 0)
+    {
+        SO_INFO("Simulation fell behind, dropped {:.1f} ms", static_cast<double>(m_timestep.DroppedNS()) * 1e-6);
+    }
+    if (m_scripts)
+    {
+        m_scripts->LogStats();
+        m_scripts.reset();
+    }
+    m_world.reset();
+    if (m_cull_pipeline.IsValid())
+    {
+        ResourceManager::Instance().Release(m_cull_pipeline);
+        ResourceManager::Instance().Release(m_instanced_pipeline);
+        m_cull_pipeline = {};
+        m_instanced_pipeline = {};
+    }
+    ResourceManager::Instance().Release(m_skinned_pipeline);
+    m_skinned_pipeline = {};
     ResourceManager::Destroy();
+    if (m_jobs)
+    {
+        m_jobs->LogStats();
+        m_jobs.reset();
+    }
 
+    if (m_rhi.offscreen_texture.handle)
+    {
+        SDL_ReleaseGPUTexture(m_rhi.device, m_rhi.offscreen_texture.handle);
+        m_rhi.offscreen_texture = {};
+    }
     if (m_window.handle)
     {
         SDL_ReleaseWindowFromGPUDevice(m_rhi.device, m_window.handle);
@@ -29,13 +314,82 @@ void Engine::Destroy()
         SDL_DestroyGPUDevice(m_rhi.device);
     }
 
-    SDL_DestroyWindow(m_window.handle);
+    if (m_window.handle)
+    {
+        SDL_DestroyWindow(m_window.handle);
+    }
 
     SDL_Quit();
 }
 
 void Engine::Update()
 {
+    SO_PROFILE_FUNCTION();
+    m_jobs->PumpMain();
+
+    auto& mgr = ResourceManager::Instance();
+    if (m_window.handle)
+    {
+        SDL_WindowFlags flags = SDL_GetWindowFlags(m_window.handle);
+        m_window.b_minimalize = (flags & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN)) != 0;
+        m_window.b_focused = (flags & SDL_WINDOW_INPUT_FOCUS) != 0;
+    }
+    // Nobody is watching, no reason to burn a core
+    bool background = m_window.b_minimalize || !m_window.b_focused;
+    m_limiter.SetRate(background ? BackgroundRate(mgr.GetEngineConfig()) : mgr.GetEngineConfig().max_fps);
+
+    // Releases and uploads of frames the renderer finished
+    uint64_t completed = m_renderer->CompletedFrame();
+    mgr.BeginFrame(completed);
+    if (completed != m_sampled_frame)
+    {
+        m_resolution.AddSample(m_renderer->GpuTimeMs());
+        m_sampled_frame = completed;
+    }
+    std::erase_if(m_inflight_uploads, [&mgr, completed](InflightUpload const& upload)
+    {
+        if (upload.frame > completed)
+        {
+            return false;
+        }
+        for (auto handle : upload.models)
+        {
+            mgr.MarkUploaded(handle);
+        }
+        return true;
+    });
+    mgr.ApplyReloads();
+
+    uint64_t ticks_ns = SDL_GetTicksNS();
+    uint32_t steps = m_timestep.Advance(ticks_ns - m_last_ticks_ns);
+    m_last_ticks_ns = ticks_ns;
+    for (uint32_t step{ 0 }; step < steps; ++step)
+    {
+        SO_PROFILE_ZONE("Simulation step");
+        float delta_time = m_timestep.StepSeconds();
+        if (m_fixed_update)
+        {
+            m_fixed_update(delta_time);
+        }
+        // Gameplay scripts, waits count steps
+        m_scripts->Update();
+
+        // Structural changes made since last step land here, before systems run
+        m_world->Flush();
+        SnapshotTransforms(*m_world, *m_jobs);
+        IntegrateVelocities(*m_world, *m_jobs, delta_time);
+        AdvanceAnimators(*m_world, *m_jobs, delta_time);
+    }
+    // The collector gets what is left of its budget, once per frame
+    m_scripts->StepGC(mgr.GetEngineConfig().script_gc_budget_ms);
+
+    UpdateTransforms(*m_world, *m_jobs, m_timestep.Alpha());
+    EvaluatePoses(*m_world, *m_jobs, m_timestep.Alpha(), m_timestep.StepSeconds());
+    CollectDraws(*m_world, m_draws);
+    m_views.Clear();
+    SO_PROFILE_COUNTER("simulation steps", steps);
+    SO_PROFILE_COUNTER("entities", m_world->Size());
+    SO_PROFILE_COUNTER("draws", m_draws.size());
 }
     
 auto Engine::CreateShader(SDL_GPUShaderCreateInfo const& info) const -> SDL_GPUShader*
@@ -48,79 +402,270 @@ auto Engine::CreateGraphicsPipeline(SDL_GPUGraphicsPipelineCreateInfo const& inf
     return SDL_CreateGPUGraphicsPipeline(m_rhi.device, &info);
 }
 
-auto Engine::UploadModel(SDL_GPUCopyPass* pass, std::string const& name) -> ModelInfo const&
+void Engine::CullScene(ViewSet const& views)
 {
+    if (IsGpuCulling())
+    {
+        m_views = views;
+        return;
+    }
+    CullDraws(m_draws, views, *m_jobs);
+}
+
+void Engine::SubmitFrame(PipelineHandle pipeline, std::span<std::byte const> constants, uint32_t view)
+{
+    SO_PROFILE_FUNCTION();
+    if (m_window.b_minimalize)
+    {
+        // No swapchain image to render to
+        m_input_ns = 0;
+        m_dispatches.clear();
+        m_limiter.Wait();
+        return;
+    }
+
     auto& mgr = ResourceManager::Instance();
-    auto const& model = mgr.GetModel(name);
-    
-    uint32_t offset{ 0 };
-    for (auto const& mesh : model.meshes)
+    FramePacket& packet = m_renderer->BeginPacket();
+    packet.frame = mgr.GetFrame();
+    packet.input_ns = std::exchange(m_input_ns, 0);
+    packet.render_scale = m_resolution.GetScale();
+    packet.constants.assign(constants.begin(), constants.end());
+    PackDispatches(packet);
+    // Resolved every frame, hot reload may replace them
+    packet.skinned_pipeline = mgr.GetPipeline(m_skinned_pipeline);
+    if (IsGpuCulling())
     {
-        for (auto const& buffer : mesh.buffers)
+        packet.pipeline = mgr.GetPipeline(m_instanced_pipeline);
+        packet.cull_pipeline = mgr.GetComputePipeline(m_cull_pipeline);
+        if (view < m_views.Size())
         {
-            SDL_GPUTransferBufferLocation location{
-                .transfer_buffer = model.transfer_buffer,
-                .offset = offset,
-            };
-            SDL_GPUBufferRegion region{
-                .buffer = buffer.first,
-                .offset = 0,
-                .size = buffer.second,
-            };
-            SDL_UploadToGPUBuffer(pass, &location, &region, false);
-            offset += buffer.second;
+            packet.cull_planes = m_views[view].frustum.planes;
         }
+        PackInstances(packet, view);
     }
-    mgr.SetModelStatus(name, true);
-    return model;
+    else
+    {
+        packet.pipeline = mgr.GetPipeline(pipeline);
+        PackDraws(packet, view);
+    }
+
+    // Staging buffers of models made resident above, copied before drawing
+    std::vector<ModelHandle> uploads = mgr.TakePendingUploads();
+    for (auto handle : uploads)
+    {
+        ModelInfo const* model = mgr.GetModel(handle);
+        if (!model || !model->transfer_buffer)
+        {
+            continue;
+        }
+        uint32_t offset{ 0 };
+        for (auto const& mesh : model->meshes)
+        {
+            for (auto const& buffer : mesh.buffers)
+            {
+                packet.uploads.push_back({
+                    .source = { .transfer_buffer = model->transfer_buffer, .offset = offset },
+                    .destination = { .buffer = buffer.first, .offset = 0, .size = buffer.second },
+                });
+                offset += buffer.second;
+            }
+        }
+    }
+    if (!uploads.empty())
+    {
+        m_inflight_uploads.push_back({ packet.frame, std::move(uploads) });
+    }
+    SO_PROFILE_COUNTER("packet meshes", packet.meshes.size());
+    SO_PROFILE_COUNTER("render scale", packet.render_scale);
+    m_renderer->SubmitPacket();
+    m_limiter.Wait();
 }
 
-void Engine::DrawMesh(SDL_GPURenderPass* pass, MeshInfo const& mesh)
+void Engine::PackDraws(FramePacket& packet, uint32_t view)
 {
-    std::vector<SDL_GPUBufferBinding> vertex_bindings(mesh.buffers.size() - 1);
-    for (size_t i{ 0 }; i < vertex_bindings.size(); ++i)
+    auto& mgr = ResourceManager::Instance();
+    ViewMask bit = ViewMask{ 1 } << view;
+    for (auto const& draw : m_draws)
     {
-        vertex_bindings[i].buffer = mesh.buffers[i].first;
-        vertex_bindings[i].offset = 0;
+        if (!(draw.views & bit))
+        {
+            continue;
+        }
+        // Keeps the model resident, draws once it has been uploaded
+        ModelInfo const* model = mgr.UseModel(draw.model);
+        if (!model || !model->active)
+        {
+            continue;
+        }
+
+        if (draw.palette && packet.skinned_pipeline)
+        {
+            PackSkinned(packet, draw, *model);
+            continue;
+        }
+        auto object = static_cast<uint32_t>(packet.objects.size());
+        packet.objects.push_back(draw.world);
+        PackMeshes(packet, *model, object, packet.meshes);
     }
-    SDL_BindGPUVertexBuffers(pass, 0, vertex_bindings.data(), static_cast<uint32_t>(vertex_bindings.size()));
-    SDL_GPUBufferBinding index_binding{ mesh.buffers.back().first, 0 };
-    SDL_BindGPUIndexBuffer(pass, &index_binding, mesh.index_type);
-    SDL_DrawGPUIndexedPrimitives(pass, static_cast<uint32_t>(mesh.index_count), 1, 0, 0, 0);
 }
 
-void Engine::DrawModel(SDL_GPURenderPass* pass, ModelInfo const& model)
+void Engine::PackInstances(FramePacket& packet, uint32_t view)
 {
-    if (!model.active)
+    SO_PROFILE_FUNCTION();
+    auto& mgr = ResourceManager::Instance();
+    // Every skinned draw has its own pose, they are not instanced and are
+    // culled here instead
+    bool skinning = packet.skinned_pipeline != nullptr;
+    auto skinned_begin = std::partition(m_draws.begin(), m_draws.end(), [skinning](DrawItem const& draw)
     {
-        return;
+        return !(skinning && draw.palette);
+    });
+    for (auto draw = skinned_begin; draw != m_draws.end(); ++draw)
+    {
+        if (view < m_views.Size() && !m_views[view].frustum.Intersects(draw->bounds))
+        {
+            continue;
+        }
+        ModelInfo const* model = mgr.UseModel(draw->model);
+        if (model && model->active)
+        {
+            PackSkinned(packet, *draw, *model);
+        }
     }
+
+    // Instances of a model become one batch, its meshes are drawn once each
+    // for whatever instances pass the cull
+    std::sort(m_draws.begin(), skinned_begin, [](DrawItem const& lhs, DrawItem const& rhs)
+    {
+        return std::pair(lhs.model.index, lhs.model.generation) < std::pair(rhs.model.index, rhs.model.generation);
+    });
+
+    auto static_count = static_cast<size_t>(skinned_begin - m_draws.begin());
+    for (size_t begin{ 0 }, end{ 0 }; begin < static_count; begin = end)
+    {
+        ModelHandle handle = m_draws[begin].model;
+        for (end = begin + 1; end < static_count && m_draws[end].model == handle; ++end)
+        {
+        }
+        // Visibility is only known on the GPU, every instance keeps the
+        // model resident
+        ModelInfo const* model = mgr.UseModel(handle);
+        if (!model || !model->active)
+        {
+            continue;
+        }
+
+        auto batch = static_cast<uint32_t>(packet.batches.size());
+        packet.batches.push_back({
+            .first_mesh = static_cast<uint32_t>(packet.meshes.size()),
+            .mesh_count = static_cast<uint32_t>(model->meshes.size()),
+            .first_instance = static_cast<uint32_t>(packet.objects.size()),
+        });
+        for (size_t i{ begin }; i < end; ++i)
+        {
+            packet.instances.push_back({ .bounds = m_draws[i].bounds, .batch = batch });
+            packet.objects.push_back(m_draws[i].world);
+        }
+        PackMeshes(packet, *model, batch, packet.meshes);
+    }
+    SO_PROFILE_COUNTER("gpu cull instances", packet.instances.size());
+}
+
+void Engine::PackSkinned(FramePacket& packet, DrawItem const& draw, ModelInfo const& model)
+{
+    auto skin = static_cast<uint32_t>(packet.skins.size());
+    packet.skins.push_back({ .model = draw.world, .palette_base = static_cast<uint32_t>(packet.palettes.size()) });
+    packet.palettes.insert(packet.palettes.end(), draw.palette->joints.begin(), draw.palette->joints.end());
+    PackMeshes(packet, model, skin, packet.skinned_meshes);
+}
+
+void Engine::PackMeshes(FramePacket& packet, ModelInfo const& model, uint32_t object, std::vector<PacketMesh>& meshes)
+{
     for (auto const& mesh : model.meshes)
     {
-        DrawMesh(pass, mesh);
+        auto first_binding = static_cast<uint32_t>(packet.bindings.size());
+        for (size_t i{ 0 }; i + 1 < mesh.buffers.size(); ++i)
+        {
+            packet.bindings.push_back({ mesh.buffers[i].first, 0 });
+        }
+        meshes.push_back({
+            .first_binding = first_binding,
+            .binding_count = static_cast<uint32_t>(mesh.buffers.size() - 1),
+            .index = { mesh.buffers.back().first, 0 },
+            .index_type = mesh.index_type,
+            .index_count = static_cast<uint32_t>(mesh.index_count),
+            .object = object,
+        });
     }
 }
 
-auto Engine::AcquireCmdBuf() -> SDL_GPUCommandBuffer*
+void Engine::PackDispatches(FramePacket& packet)
 {
-    return SDL_AcquireGPUCommandBuffer(m_rhi.device);
+    auto& mgr = ResourceManager::Instance();
+    for (auto const& dispatch : m_dispatches)
+    {
+        SDL_GPUComputePipeline* pipeline = mgr.GetComputePipeline(dispatch.pipeline);
+        if (!pipeline)
+        {
+            continue;
+        }
+        packet.dispatches.push_back({
+            .pipeline = pipeline,
+            .first_buffer = static_cast<uint32_t>(packet.dispatch_buffers.size()),
+            .buffer_count = static_cast<uint32_t>(dispatch.readonly_buffers.size()),
+            .first_rw_buffer = static_cast<uint32_t>(packet.dispatch_rw_buffers.size()),
+            .rw_buffer_count = static_cast<uint32_t>(dispatch.readwrite_buffers.size()),
+            .constants_offset = static_cast<uint32_t>(packet.dispatch_constants.size()),
+            .constants_size = static_cast<uint32_t>(dispatch.constants.size()),
+            .groups_x = dispatch.groups_x,
+            .groups_y = dispatch.groups_y,
+            .groups_z = dispatch.groups_z,
+        });
+        packet.dispatch_buffers.insert(packet.dispatch_buffers.end(), dispatch.readonly_buffers.begin(), dispatch.readonly_buffers.end());
+        packet.dispatch_rw_buffers.insert(packet.dispatch_rw_buffers.end(), dispatch.readwrite_buffers.begin(), dispatch.readwrite_buffers.end());
+        packet.dispatch_constants.insert(packet.dispatch_constants.end(), dispatch.constants.begin(), dispatch.constants.end());
+    }
+    m_dispatches.clear();
 }
 
-void Engine::SubmitCmdBuf(SDL_GPUCommandBuffer* cmd)
+void Engine::Dispatch(ComputeDispatch dispatch)
 {
-    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmd);
-    SDL_WaitForGPUFences(m_rhi.device, false, &fence, 1);
-    SDL_ReleaseGPUFence(m_rhi.device, fence);
+    m_dispatches.push_back(std::move(dispatch));
 }
 
+void Engine::WaitIdle()
+{
+    m_renderer->WaitIdle();
+}
 
-auto Engine::AcquireSwapchainImage(SDL_GPUCommandBuffer* cmd) -> Texture const&
+void Engine::NoteInput(uint64_t timestamp_ns)
 {
-    SDL_AcquireGPUSwapchainTexture(
-        cmd,
-        m_window.handle,
-        &m_rhi.present_texture.handle,
-        &m_rhi.present_texture.width,
-        &m_rhi.present_texture.height);
-    return m_rhi.present_texture;
+    if (m_input_ns == 0 || timestamp_ns < m_input_ns)
+    {
+        m_input_ns = timestamp_ns;
+    }
+}
+
+auto Engine::SetPresentMode(SDL_GPUPresentMode mode) -> bool
+{
+    if (!m_window.handle)
+    {
+        return false;
+    }
+    if (!SDL_WindowSupportsGPUPresentMode(m_rhi.device, m_window.handle, mode))
+    {
+        SO_WARN("Present mode {} is not supported", PresentModeName(mode));
+        return false;
+    }
+
+    // The render thread acquires swapchain images
+    m_renderer->WaitIdle();
+    if (!SDL_SetGPUSwapchainParameters(m_rhi.device, m_window.handle, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, mode))
+    {
+        SO_WARN("Failed to set present mode {}, {}", PresentModeName(mode), SDL_GetError());
+        return false;
+    }
+    m_present_mode = mode;
+    SO_INFO("Present mode: {}", PresentModeName(mode));
+    return true;
 }
\ No newline at end of file
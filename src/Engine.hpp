@@ -1,38 +1,170 @@
 #pragma once
+#include <span>
+#include <functional>
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_gpu.h>
 #include "ResourceManager.hpp"
+#include "Renderer.hpp"
+#include "DynamicResolution.hpp"
+#include "ScriptRuntime.hpp"
+#include "JobSystem.hpp"
+#include "Scene.hpp"
 
-struct Texture
+struct EngineOptions
 {
-    SDL_GPUTexture* handle{ nullptr };
-    uint32_t        width{ 0 };
-    uint32_t        height{ 0 };
+    std::filesystem::path config_root{ "config" };
+    // No window, frames render to an offscreen texture of the given size
+    // and shaders are compiled to SPIR-V, e.g. for lavapipe on CI
+    bool                  headless{ false };
+    uint32_t              width{ 800 };
+    uint32_t              height{ 600 };
+    // Record and submit on a render thread, off renders on the game thread
+    // when debugging or where a backend wants the window's thread
+    bool                  render_thread{ true };
+    // Watch config and shader sources, on in debug builds only
+#ifdef NDEBUG
+    bool                  hot_reload{ false };
+#else
+    bool                  hot_reload{ true };
+#endif
+};
+
+// --config <dir> --headless --width <px> --height <px> --no-render-thread
+// --no-hot-reload, anything else is left to the caller
+[[nodiscard]] auto ParseEngineOptions(int argc, char* argv[]) -> EngineOptions;
+
+// Turns variable frame times into a whole number of fixed steps, the rest
+// carries over to the next frame
+class FixedTimestep
+{
+public:
+    FixedTimestep(uint32_t rate = 60, uint32_t max_steps = 4);
+
+    // Steps to run for a frame that took `elapsed_ns`. Past `max_steps` the
+    // backlog is dropped, simulating it would only make the next frame
+    // longer still.
+    [[nodiscard]] auto Advance(uint64_t elapsed_ns) -> uint32_t;
+
+    [[nodiscard]] auto StepSeconds() const -> float { return static_cast<float>(m_step_ns) * 1e-9f; }
+    // Share of a step in the accumulator, to blend the last two states
+    [[nodiscard]] auto Alpha() const -> float { return static_cast<float>(m_accumulator) / static_cast<float>(m_step_ns); }
+    [[nodiscard]] auto DroppedNS() const -> uint64_t { return m_dropped_ns; }
+private:
+    uint64_t m_step_ns;
+    uint32_t m_max_steps;
+    uint64_t m_accumulator{ 0 };
+    uint64_t m_dropped_ns{ 0 };
+};
+
+// Holds frames to a rate. Sleeps most of the wait and spins the rest, as
+// sleeps overshoot by up to a scheduler tick; the spin margin follows the
+// overshoot seen.
+class FrameLimiter
+{
+public:
+    // 0 does not limit
+    void SetRate(uint32_t fps);
+    [[nodiscard]] auto GetRate() const -> uint32_t { return m_fps; }
+    // Returns at the end of the current frame's slot. A frame that overran
+    // a whole slot starts a new schedule instead of a burst of short ones.
+    void Wait();
+private:
+    uint32_t m_fps{ 0 };
+    uint64_t m_period_ns{ 0 };
+    uint64_t m_deadline_ns{ 0 };
+    uint64_t m_spin_ns{ 1'000'000 };
+};
+
+// Compute work run on the GPU before a frame's draws. Buffers must stay
+// alive until the frame completed on the GPU.
+struct ComputeDispatch
+{
+    ComputePipelineHandle                             pipeline;
+    std::vector<SDL_GPUBuffer*>                       readonly_buffers;  // storage buffer slots from 0
+    std::vector<SDL_GPUStorageBufferReadWriteBinding> readwrite_buffers;
+    std::vector<std::byte>                            constants;         // compute uniform slot 0
+    uint32_t                                          groups_x{ 1 };
+    uint32_t                                          groups_y{ 1 };
+    uint32_t                                          groups_z{ 1 };
 };
 
 class Engine
 {
 public:
-    void Initialize();
+    void Initialize(EngineOptions const& options = {});
     void Destroy();
+    // Runs as many fixed simulation steps as the time since the last call
+    // asks for, then prepares the frame's draws in between the last two
     void Update();
+    // Game code run at the start of every simulation step, with the step
+    // length in seconds
+    void SetFixedUpdate(std::function<void(float)> fixed_update) { m_fixed_update = std::move(fixed_update); }
+    // How far the frame is between the previous and the current step, for
+    // interpolating state kept outside the world, e.g. cameras
+    [[nodiscard]] auto GetInterpolationAlpha() const -> float { return m_timestep.Alpha(); }
 
     auto CreateShader(SDL_GPUShaderCreateInfo const& info) const -> SDL_GPUShader*;
     auto CreateGraphicsPipeline(SDL_GPUGraphicsPipelineCreateInfo const& info) const -> SDL_GPUGraphicsPipeline*;
 
-    auto UploadModel(SDL_GPUCopyPass* pass, std::string const& name) -> ModelInfo const&;
-    void DrawMesh(SDL_GPURenderPass* pass, MeshInfo const& mesh);
-    void DrawModel(SDL_GPURenderPass* pass, ModelInfo const& model);
+    // Culls this frame's draws against every view at once, call after
+    // Update. Without it everything counts as visible. With GPU culling
+    // only the views are kept, the GPU tests the view drawn.
+    void CullScene(ViewSet const& views);
+    // Hands the frame to the renderer: renderable entities visible in
+    // `view` drawn with `pipeline`, `constants` in vertex uniform slot 0 and
+    // the model matrix in slot 1. Models that are not resident yet are
+    // uploaded and drawn from a later frame. Waits while the renderer is a
+    // whole frame behind.
+    // With GPU culling the engine's instanced pipeline replaces `pipeline`,
+    // instances of a model are culled by a compute pass and drawn with one
+    // indirect draw per mesh.
+    // Entities with a SkinPalette are drawn with the engine's skinned
+    // pipeline when there is one, culled on the CPU either way.
+    void SubmitFrame(PipelineHandle pipeline, std::span<std::byte const> constants, uint32_t view = 0);
+    // Runs with the next submitted frame, before its culling and draws, in
+    // the order queued. Dropped when the frame is not rendered.
+    void Dispatch(ComputeDispatch dispatch);
+    // Workgroups covering `items` at `threads` per group
+    [[nodiscard]] static constexpr auto GroupCount(uint32_t items, uint32_t threads) -> uint32_t { return (items + threads - 1) / threads; }
+    // Cull and instanced pipelines were found, see EngineConfig::gpu_culling
+    [[nodiscard]] auto IsGpuCulling() const -> bool { return m_cull_pipeline.IsValid(); }
+    // Returns once every submitted frame finished on the GPU
+    void WaitIdle();
+
+    // Input events the coming frames respond to, `timestamp_ns` as in
+    // SDL_Event, for the input to present latency
+    void NoteInput(uint64_t timestamp_ns);
+    // False when the window does not support it, VSYNC always is
+    auto SetPresentMode(SDL_GPUPresentMode mode) -> bool;
+    [[nodiscard]] auto GetPresentMode() const -> SDL_GPUPresentMode { return m_present_mode; }
+    // Per axis, of the window or offscreen size
+    [[nodiscard]] auto GetRenderScale() const -> float { return m_resolution.GetScale(); }
+    // Minimized frames are simulated but not rendered
+    [[nodiscard]] auto IsMinimized() const -> bool { return m_window.b_minimalize; }
 
-    auto AcquireCmdBuf() -> SDL_GPUCommandBuffer*;
-    void SubmitCmdBuf(SDL_GPUCommandBuffer* cmd);
-    auto AcquireSwapchainImage(SDL_GPUCommandBuffer* cmd) -> Texture const&;
+    [[nodiscard]] auto Jobs() -> JobSystem& { return *m_jobs; }
+    [[nodiscard]] auto Scripts() -> ScriptRuntime& { return *m_scripts; }
+    [[nodiscard]] auto GetWorld() -> World& { return *m_world; }
+    [[nodiscard]] auto GetOptions() const -> EngineOptions const& { return m_options; }
+    // SDL's name for the backend, e.g. "vulkan" or "metal"
+    [[nodiscard]] auto GetDriverName() const -> char const* { return SDL_GetGPUDeviceDriver(m_rhi.device); }
 // private:
+    // Fill the packet's meshes, per visible draw or per model batch for
+    // GPU culling
+    void PackDraws(FramePacket& packet, uint32_t view);
+    void PackInstances(FramePacket& packet, uint32_t view);
+    void PackSkinned(FramePacket& packet, DrawItem const& draw, ModelInfo const& model);
+    void PackMeshes(FramePacket& packet, ModelInfo const& model, uint32_t object, std::vector<PacketMesh>& meshes);
+    void PackDispatches(FramePacket& packet);
+
+    EngineOptions m_options;
+
     struct Window
     {
         SDL_Window* handle{ nullptr };
         bool b_fullscreen{ false };
         bool b_minimalize{ false };
+        bool b_focused{ true };
     } m_window;
     
     struct RHI
@@ -40,6 +172,32 @@ public:
         bool debug_mode{ true };
         SDL_GPUDevice* device{ nullptr };
 
-        Texture present_texture{};
+        Texture offscreen_texture{}; // headless only
     } m_rhi;
+
+    struct InflightUpload
+    {
+        uint64_t                 frame; // done once the renderer completed it
+        std::vector<ModelHandle> models;
+    };
+
+    std::unique_ptr<Renderer>      m_renderer;
+    std::unique_ptr<JobSystem>     m_jobs;
+    std::unique_ptr<ScriptRuntime> m_scripts;
+    std::unique_ptr<World>         m_world;
+    std::vector<DrawItem>          m_draws;
+    std::vector<InflightUpload>    m_inflight_uploads;
+    std::vector<ComputeDispatch>   m_dispatches;
+    ComputePipelineHandle          m_cull_pipeline;      // valid with GPU culling
+    PipelineHandle                 m_instanced_pipeline;
+    PipelineHandle                 m_skinned_pipeline;   // optional, skinned models draw in bind pose without
+    ViewSet                        m_views;              // of CullScene, with GPU culling
+    FixedTimestep                  m_timestep;
+    std::function<void(float)>     m_fixed_update;
+    FrameLimiter                   m_limiter;
+    DynamicResolution              m_resolution;
+    uint64_t                       m_sampled_frame{ 0 }; // last fed to m_resolution
+    SDL_GPUPresentMode             m_present_mode{ SDL_GPU_PRESENTMODE_VSYNC };
+    uint64_t                       m_input_ns{ 0 };
+    uint64_t                       m_last_ticks_ns{ 0 };
 };
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include <set>
+#include <thread>
+#include "FileWatcher.hpp"
+#include "Logger.hpp"
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace {
+    auto LastWriteTime(std::filesystem::path const& file) -> std::filesystem::file_time_type
+    {
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(file, error);
+        return error ? std::filesystem::file_time_type::min() : time;
+    }
+
+    auto Normalize(std::filesystem::path const& file) -> std::filesystem::path
+    {
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(file, error);
+        return (error ? file : absolute).lexically_normal();
+    }
+}
+
+FileWatcher::FileWatcher()
+{
+#ifdef __linux__
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0)
+    {
+        SO_WARN("inotify unavailable, falling back to polling");
+    }
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+    if (m_inotify >= 0)
+    {
+        close(m_inotify);
+    }
+#endif
+}
+
+void FileWatcher::Watch(std::filesystem::path const& file)
+{
+    std::filesystem::path path = Normalize(file);
+    if (m_files.contains(path))
+    {
+        return;
+    }
+    m_files[path] = LastWriteTime(path);
+
+#ifdef __linux__
+    if (m_inotify < 0)
+    {
+        return;
+    }
+    std::filesystem::path directory = path.parent_path();
+    for (auto const& [_, watched] : m_directories)
+    {
+        if (watched == directory)
+        {
+            return;
+        }
+    }
+    int wd = inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0)
+    {
+        SO_WARN("Failed to watch directory: {}", directory.string());
+        return;
+    }
+    m_directories[wd] = directory;
+#endif
+}
+
+auto FileWatcher::IsWatched(std::filesystem::path const& file) const -> bool
+{
+    return m_files.contains(Normalize(file));
+}
+
+auto FileWatcher::Poll(int timeout_ms) -> std::vector<std::filesystem::path>
+{
+    std::set<std::filesystem::path> changed;
+
+#ifdef __linux__
+    if (m_inotify >= 0)
+    {
+        pollfd descriptor{ .fd = m_inotify, .events = POLLIN, .revents = 0 };
+        if (poll(&descriptor, 1, timeout_ms) <= 0)
+        {
+            return {};
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length{ 0 };
+        while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* cursor = buffer; cursor < buffer + length; )
+            {
+                auto const* event = reinterpret_cast<inotify_event const*>(cursor);
+                cursor += sizeof(inotify_event) + event->len;
+
+                auto directory = m_directories.find(event->wd);
+                if (directory == m_directories.end() || event->len == 0)
+                {
+                    continue;
+                }
+                std::filesystem::path path = directory->second/event->name;
+                if (m_files.contains(path))
+                {
+                    changed.insert(path);
+                }
+            }
+        }
+        return { changed.begin(), changed.end() };
+    }
+#endif
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+    for (auto& [path, time] : m_files)
+    {
+        auto current = LastWriteTime(path);
+        if (current != time)
+        {
+            time = current;
+            changed.insert(path);
+        }
+    }
+    return { changed.begin(), changed.end() };
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+#include <map>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+// Reports modifications of individual files. Uses inotify on Linux
+// (watching the parent directories so editor rename-on-save is seen) and
+// falls back to polling modification times elsewhere.
+class FileWatcher
+{
+public:
+     FileWatcher();
+    ~FileWatcher();
+    FileWatcher(FileWatcher const&) = delete;
+    auto operator = (FileWatcher const&) -> FileWatcher& = delete;
+
+    void Watch(std::filesystem::path const& file);
+    [[nodiscard]] auto IsWatched(std::filesystem::path const& file) const -> bool;
+
+    // Blocks up to `timeout_ms` for the first change and returns every
+    // watched file modified since the previous call.
+    [[nodiscard]] auto Poll(int timeout_ms) -> std::vector<std::filesystem::path>;
+private:
+    std::map<std::filesystem::path, std::filesystem::file_time_type> m_files;
+#ifdef __linux__
+    int                                            m_inotify{ -1 };
+    std::unordered_map<int, std::filesystem::path> m_directories; // watch descriptor -> directory
+#endif
+};
\ No newline at end of file
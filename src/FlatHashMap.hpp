@@ -0,0 +1,182 @@
+#pragma once
+#include <bit>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Open addressing table (linear probing, backward shift erase) for keys
+// that are already well distributed hashes, e.g. ResouceID. Entries live
+// in one contiguous array; inserting a new key may rehash and invalidate
+// references to values.
+template <typename Value>
+class FlatHashMap
+{
+public:
+    using Key   = uint64_t;
+    using Entry = std::pair<Key, Value>;
+
+    template <typename EntryT, typename MapT>
+    class Iterator
+    {
+    public:
+        Iterator(MapT* map, size_t index) : m_map(map), m_index(index) { Skip(); }
+
+        auto operator * () const -> EntryT& { return m_map->m_entries[m_index]; }
+        auto operator -> () const -> EntryT* { return &m_map->m_entries[m_index]; }
+        auto operator ++ () -> Iterator&
+        {
+            ++m_index;
+            Skip();
+            return *this;
+        }
+        auto operator == (Iterator const& rhs) const -> bool { return m_index == rhs.m_index; }
+    private:
+        void Skip()
+        {
+            while (m_index < m_map->m_used.size() && !m_map->m_used[m_index])
+            {
+                ++m_index;
+            }
+        }
+    private:
+        MapT*  m_map;
+        size_t m_index;
+    };
+    using iterator       = Iterator<Entry, FlatHashMap>;
+    using const_iterator = Iterator<Entry const, FlatHashMap const>;
+
+    [[nodiscard]] auto Find(Key key) -> Value*
+    {
+        size_t index = Probe(key);
+        return index == s_npos ? nullptr : &m_entries[index].second;
+    }
+
+    [[nodiscard]] auto Find(Key key) const -> Value const*
+    {
+        size_t index = Probe(key);
+        return index == s_npos ? nullptr : &m_entries[index].second;
+    }
+
+    [[nodiscard]] auto Contains(Key key) const -> bool
+    {
+        return Probe(key) != s_npos;
+    }
+
+    // Insert or overwrite
+    auto Assign(Key key, Value value) -> Value&
+    {
+        if ((m_size + 1) * 4 > m_used.size() * 3)
+        {
+            Rehash(m_used.empty() ? 16 : m_used.size() * 2);
+        }
+
+        size_t mask = m_used.size() - 1;
+        for (size_t index = Home(key); ; index = (index + 1) & mask)
+        {
+            if (!m_used[index])
+            {
+                m_used[index] = 1;
+                m_entries[index] = { key, std::move(value) };
+                ++m_size;
+                return m_entries[index].second;
+            }
+            if (m_entries[index].first == key)
+            {
+                m_entries[index].second = std::move(value);
+                return m_entries[index].second;
+            }
+        }
+    }
+
+    auto Erase(Key key) -> bool
+    {
+        size_t hole = Probe(key);
+        if (hole == s_npos)
+        {
+            return false;
+        }
+
+        // Shift later members of the probe chain back so lookups never
+        // stop early at the freed slot.
+        size_t mask = m_used.size() - 1;
+        for (size_t index = (hole + 1) & mask; m_used[index]; index = (index + 1) & mask)
+        {
+            size_t home = Home(m_entries[index].first);
+            bool movable = hole <= index
+                ? (home <= hole || home > index)
+                : (home <= hole && home > index);
+            if (movable)
+            {
+                m_entries[hole] = std::move(m_entries[index]);
+                hole = index;
+            }
+        }
+        m_used[hole] = 0;
+        m_entries[hole] = {};
+        --m_size;
+        return true;
+    }
+
+    void Clear()
+    {
+        m_entries.clear();
+        m_used.clear();
+        m_size = 0;
+    }
+
+    [[nodiscard]] auto Size() const -> size_t { return m_size; }
+    [[nodiscard]] auto Empty() const -> bool { return m_size == 0; }
+
+    auto begin() -> iterator { return { this, 0 }; }
+    auto end() -> iterator { return { this, m_used.size() }; }
+    auto begin() const -> const_iterator { return { this, 0 }; }
+    auto end() const -> const_iterator { return { this, m_used.size() }; }
+private:
+    static constexpr size_t s_npos{ ~size_t{ 0 } };
+
+    // Fibonacci hashing on top of the key spreads low-entropy keys as well
+    [[nodiscard]] auto Home(Key key) const -> size_t
+    {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> m_shift);
+    }
+
+    [[nodiscard]] auto Probe(Key key) const -> size_t
+    {
+        if (m_size == 0)
+        {
+            return s_npos;
+        }
+        size_t mask = m_used.size() - 1;
+        for (size_t index = Home(key); m_used[index]; index = (index + 1) & mask)
+        {
+            if (m_entries[index].first == key)
+            {
+                return index;
+            }
+        }
+        return s_npos;
+    }
+
+    void Rehash(size_t capacity)
+    {
+        std::vector<Entry> entries(capacity);
+        std::vector<uint8_t> used(capacity, 0);
+        std::swap(entries, m_entries);
+        std::swap(used, m_used);
+        m_shift = 64 - std::countr_zero(capacity);
+        m_size = 0;
+        for (size_t i{ 0 }; i < used.size(); ++i)
+        {
+            if (used[i])
+            {
+                Assign(entries[i].first, std::move(entries[i].second));
+            }
+        }
+    }
+private:
+    std::vector<Entry>   m_entries;
+    std::vector<uint8_t> m_used;
+    size_t               m_size{ 0 };
+    uint32_t             m_shift{ 64 };
+};
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "Frustum.hpp"
+#include "Camera.hpp"
+#include "Logger.hpp"
+
+auto Frustum::FromMatrix(glm::mat4 const& view_projection) -> Frustum
+{
+    // Gribb/Hartmann, rows of the matrix combined; glm stores columns
+    auto row = [&view_projection](int i)
+    {
+        return glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+    };
+    glm::vec4 r0 = row(0);
+    glm::vec4 r1 = row(1);
+    glm::vec4 r2 = row(2);
+    glm::vec4 r3 = row(3);
+
+    Frustum frustum{ { r3 + r0, r3 - r0, r3 + r1, r3 - r1, r2, r3 - r2 } };
+    for (glm::vec4& plane : frustum.planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+auto Frustum::Intersects(glm::vec4 const& sphere) const -> bool
+{
+    for (glm::vec4 const& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+auto ViewSet::Add(Camera const& camera) -> std::optional<uint32_t>
+{
+    return Add(RenderView{
+        .view = camera.GetViewMatrix(),
+        .projection = camera.GetProjectionMatrix(),
+        .view_projection = camera.GetViewProjectionMatrix(),
+        .position = camera.GetPosition(),
+        .frustum = camera.GetFrustum(),
+    });
+}
+
+auto ViewSet::Add(RenderView const& view) -> std::optional<uint32_t>
+{
+    if (m_views.size() == s_max_views)
+    {
+        SO_WARN("View set is full, {} views", s_max_views);
+        return std::nullopt;
+    }
+
+    auto index = static_cast<uint32_t>(m_views.size());
+    m_views.push_back(view);
+    for (size_t p{ 0 }; p < m_planes.size(); ++p)
+    {
+        glm::vec4 const& plane = view.frustum.planes[p];
+        m_planes[p].x[index] = plane.x;
+        m_planes[p].y[index] = plane.y;
+        m_planes[p].z[index] = plane.z;
+        m_planes[p].w[index] = plane.w;
+    }
+    return index;
+}
+
+void ViewSet::Clear()
+{
+    m_views.clear();
+    m_planes = {};
+}
+
+auto ViewSet::Cull(glm::vec4 const& sphere) const -> ViewMask
+{
+    // Unused lanes hold zero planes and pass, the mask drops them
+    std::array<float, s_max_views> outside{};
+    for (PlaneLanes const& plane : m_planes)
+    {
+        for (uint32_t v{ 0 }; v < s_max_views; ++v)
+        {
+            float distance = plane.x[v] * sphere.x + plane.y[v] * sphere.y + plane.z[v] * sphere.z + plane.w[v];
+            outside[v] = distance < -sphere.w ? 1.0f : outside[v];
+        }
+    }
+
+    ViewMask mask{ 0 };
+    for (uint32_t v{ 0 }; v < Size(); ++v)
+    {
+        mask |= outside[v] == 0.0f ? ViewMask{ 1 } << v : 0;
+    }
+    return mask;
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <glm/glm.hpp>
+
+class Camera;
+
+// Planes as (normal, distance) with normals pointing inside, p is on the
+// inner side of a plane when dot(normal, p) + distance >= 0
+struct Frustum
+{
+    std::array<glm::vec4, 6> planes; // left, right, bottom, top, near, far
+
+    // Expects a [0, 1] depth range as made by the *_ZO projections
+    [[nodiscard]] static auto FromMatrix(glm::mat4 const& view_projection) -> Frustum;
+    // `sphere` is center and radius. Conservative, spheres just outside a
+    // corner still pass.
+    [[nodiscard]] auto Intersects(glm::vec4 const& sphere) const -> bool;
+};
+
+// What culling and drawing need to know about a camera, copied so jobs
+// never touch the camera itself
+struct RenderView
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 view_projection;
+    glm::vec3 position;
+    Frustum   frustum;
+};
+
+// Bit i is set when an object is visible in view i of a ViewSet
+using ViewMask = uint32_t;
+
+// Every view rendered in a frame, e.g. the main camera, shadow cascades
+// and reflections. An object is tested against all of them at once.
+class ViewSet
+{
+public:
+    static constexpr uint32_t s_max_views{ 32 };
+
+    // Index of the view, nullopt once full
+    auto Add(Camera const& camera) -> std::optional<uint32_t>;
+    auto Add(RenderView const& view) -> std::optional<uint32_t>;
+    void Clear();
+
+    [[nodiscard]] auto Size() const -> uint32_t { return static_cast<uint32_t>(m_views.size()); }
+    [[nodiscard]] auto operator [] (uint32_t index) const -> RenderView const& { return m_views[index]; }
+
+    // Safe to call from any number of threads once the set is filled
+    [[nodiscard]] auto Cull(glm::vec4 const& sphere) const -> ViewMask;
+private:
+    // Plane p of view v is (x[v], y[v], z[v], w[v]) of m_planes[p], so the
+    // inner loop runs over views and vectorizes
+    struct PlaneLanes
+    {
+        alignas(64) std::array<float, s_max_views> x{};
+        alignas(64) std::array<float, s_max_views> y{};
+        alignas(64) std::array<float, s_max_views> z{};
+        alignas(64) std::array<float, s_max_views> w{};
+    };
+
+    std::vector<RenderView>   m_views;
+    std::array<PlaneLanes, 6> m_planes{};
+};
\ No newline at end of file
@@ -1,9 +1,110 @@
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
 #include "GLTFHelper.hpp"
 #include "Logger.hpp"
 
+namespace {
+    // Clips are resampled at this rate on import
+    constexpr float s_sample_rate{ 30.0f };
+
+    struct NodeTRS
+    {
+        glm::vec3 translation{ 0.0f };
+        glm::quat rotation{};
+        glm::vec3 scale{ 1.0f };
+    };
+
+    // Matrices are decomposed assuming no shear, as the spec requires for
+    // animated nodes
+    auto NodeTransform(tinygltf::Node const& node) -> NodeTRS
+    {
+        NodeTRS trs{};
+        if (node.matrix.size() == 16)
+        {
+            glm::mat4 matrix(1.0f);
+            for (int i{ 0 }; i < 16; ++i)
+            {
+                matrix[i / 4][i % 4] = static_cast<float>(node.matrix[i]);
+            }
+            trs.translation = glm::vec3(matrix[3]);
+            for (int axis{ 0 }; axis < 3; ++axis)
+            {
+                trs.scale[axis] = glm::length(glm::vec3(matrix[axis]));
+                matrix[axis] *= trs.scale[axis] > 0.0f ? 1.0f / trs.scale[axis] : 0.0f;
+            }
+            trs.rotation = glm::normalize(glm::quat_cast(glm::mat3(matrix)));
+            return trs;
+        }
+        if (node.translation.size() == 3)
+        {
+            trs.translation = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+        }
+        if (node.rotation.size() == 4)
+        {
+            trs.rotation = glm::quat(node.rotation[3], node.rotation[0], node.rotation[1], node.rotation[2]);
+        }
+        if (node.scale.size() == 3)
+        {
+            trs.scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+        }
+        return trs;
+    }
+
+    auto NodeMatrix(tinygltf::Node const& node) -> glm::mat4
+    {
+        NodeTRS trs = NodeTransform(node);
+        glm::mat4 matrix = glm::mat4_cast(trs.rotation);
+        matrix[0] *= trs.scale.x;
+        matrix[1] *= trs.scale.y;
+        matrix[2] *= trs.scale.z;
+        matrix[3] = glm::vec4(trs.translation, 1.0f);
+        return matrix;
+    }
+
+    auto ReadComponent(unsigned char const* source, int component_type, bool normalized) -> float
+    {
+        auto read = [source]<typename T>(T value)
+        {
+            std::memcpy(&value, source, sizeof(T));
+            return value;
+        };
+        switch (component_type)
+        {
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+            return read(float{});
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+        {
+            auto value = static_cast<float>(read(int8_t{}));
+            return normalized ? std::max(value / 127.0f, -1.0f) : value;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        {
+            auto value = static_cast<float>(read(uint8_t{}));
+            return normalized ? value / 255.0f : value;
+        }
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
+        {
+            auto value = static_cast<float>(read(int16_t{}));
+            return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        {
+            auto value = static_cast<float>(read(uint16_t{}));
+            return normalized ? value / 65535.0f : value;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            return static_cast<float>(read(uint32_t{}));
+        default:
+            return 0.0f;
+        }
+    }
+}
+
 auto VertexElementSize(SDL_GPUVertexElementFormat format) -> uint32_t
 {
     switch (format)
@@ -65,7 +166,7 @@ auto IndexElementSize(SDL_GPUIndexElementSize size) -> uint32_t
     }
 }
 
-auto GLTFHelper::Load(std::filesystem::path const& path) -> std::pair<uint32_t, std::vector<MeshDescription> const&>
+auto GLTFHelper::Load(std::filesystem::path const& path, std::filesystem::path const& clips) -> std::pair<uint32_t, std::vector<MeshDescription> const&>
 {
     tinygltf::TinyGLTF loader{};
     std::string warn, error;
@@ -95,10 +196,33 @@ auto GLTFHelper::Load(std::filesystem::path const& path) -> std::pair<uint32_t,
     if (!result)
     {
         SO_ERROR("Failed to load: {}", path.string());
+        return {0, m_meshes};
     }
-    else
+    SO_INFO("Loaded: {}", path.string());
+
+    // Before the meshes, their joint streams are remapped to the skeleton
+    m_node_joints.assign(m_model.nodes.size(), -1);
+    if (!m_model.skins.empty())
+    {
+        LoadSkin();
+    }
+    std::optional<std::vector<CompressedClip>> loaded_clips;
+    if (m_skin && !clips.empty())
+    {
+        loaded_clips = LoadClips(clips, m_skin->skeleton.JointCount());
+    }
+    if (loaded_clips)
     {
-        SO_INFO("Loaded: {}", path.string());
+        m_skin->clips = std::move(*loaded_clips);
+    }
+    else if (m_skin)
+    {
+        // Also when the clip file is missing or stale, at the cost of the
+        // import time
+        for (auto const& animation : m_model.animations)
+        {
+            LoadAnimation(animation);
+        }
     }
 
     auto const& scene = m_model.scenes[m_model.defaultScene];
@@ -112,6 +236,10 @@ auto GLTFHelper::Load(std::filesystem::path const& path) -> std::pair<uint32_t,
 
 void GLTFHelper::LoadNode(tinygltf::Node const& node)
 {
+    if (node.skin > 0)
+    {
+        SO_WARN("Node {} uses skin {}, meshes are bound to the first skin", node.name, node.skin);
+    }
     if (node.mesh >= 0)
     {
         LoadMesh(m_model.meshes[node.mesh]);
@@ -127,7 +255,7 @@ void GLTFHelper::LoadMesh(tinygltf::Mesh const& mesh)
     for (auto const& primitive : mesh.primitives)
     {
         MeshDescription mesh_info{};
-        mesh_info.attributes.reserve(primitive.attributes.size() + 1);
+        mesh_info.attributes.reserve(primitive.attributes.size() + 3);
 
         if (primitive.attributes.find("POSITION") != primitive.attributes.end())
         {
@@ -143,6 +271,16 @@ void GLTFHelper::LoadMesh(tinygltf::Mesh const& mesh)
                 }
             );
             m_total_size += position_view.byteLength;
+
+            // Required by the spec for positions
+            if (position_accessor.minValues.size() == 3 && position_accessor.maxValues.size() == 3)
+            {
+                for (int i{ 0 }; i < 3; ++i)
+                {
+                    m_min[i] = std::min(m_min[i], static_cast<float>(position_accessor.minValues[i]));
+                    m_max[i] = std::max(m_max[i], static_cast<float>(position_accessor.maxValues[i]));
+                }
+            }
         }
         
         if (primitive.attributes.find("NORMAL") != primitive.attributes.end())
@@ -161,6 +299,11 @@ void GLTFHelper::LoadMesh(tinygltf::Mesh const& mesh)
             m_total_size += normal_view.byteLength;
         }
 
+        if (m_skin)
+        {
+            AppendSkinStreams(primitive, mesh_info);
+        }
+
         // index buffer
         if (primitive.indices >= 0)
         {
@@ -195,11 +338,333 @@ void GLTFHelper::LoadMesh(tinygltf::Mesh const& mesh)
     }
 }
 
+void GLTFHelper::LoadSkin()
+{
+    if (m_model.skins.size() > 1)
+    {
+        SO_WARN("Only the first of {} skins is loaded", m_model.skins.size());
+    }
+    auto const& skin = m_model.skins.front();
+    auto joint_count = static_cast<uint32_t>(skin.joints.size());
+    if (joint_count == 0 || joint_count > std::numeric_limits<uint16_t>::max())
+    {
+        SO_ERROR("Invalid joint count {} in skin {}", joint_count, skin.name);
+        return;
+    }
+
+    std::vector<int32_t> node_parents(m_model.nodes.size(), -1);
+    for (size_t node{ 0 }; node < m_model.nodes.size(); ++node)
+    {
+        for (int child : m_model.nodes[node].children)
+        {
+            node_parents[child] = static_cast<int32_t>(node);
+        }
+    }
+
+    // Shallower joints first puts every parent before its children
+    std::vector<uint32_t> depths(joint_count, 0);
+    for (uint32_t i{ 0 }; i < joint_count; ++i)
+    {
+        for (int32_t node = node_parents[skin.joints[i]]; node >= 0; node = node_parents[node])
+        {
+            ++depths[i];
+        }
+    }
+    std::vector<uint32_t> order(joint_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&depths](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+
+    m_joint_remap.resize(joint_count);
+    for (uint32_t joint{ 0 }; joint < joint_count; ++joint)
+    {
+        m_joint_remap[order[joint]] = static_cast<uint16_t>(joint);
+        m_node_joints[skin.joints[order[joint]]] = static_cast<int32_t>(joint);
+    }
+
+    auto skin_info = std::make_shared<SkinInfo>();
+    Skeleton& skeleton = skin_info->skeleton;
+    skeleton.joint_names.resize(joint_count);
+    skeleton.parents.resize(joint_count, -1);
+    skeleton.inverse_bind.resize(joint_count, glm::mat4(1.0f));
+    skeleton.rest.Resize(joint_count);
+    std::vector<float> inverse_bind = skin.inverseBindMatrices >= 0 ? ReadAccessor(skin.inverseBindMatrices) : std::vector<float>{};
+    for (uint32_t joint{ 0 }; joint < joint_count; ++joint)
+    {
+        int node_index = skin.joints[order[joint]];
+        auto const& node = m_model.nodes[node_index];
+        skeleton.joint_names[joint] = node.name;
+
+        // Nodes in between that are not joints are skipped
+        int32_t parent = node_parents[node_index];
+        while (parent >= 0 && m_node_joints[parent] < 0)
+        {
+            parent = node_parents[parent];
+        }
+        skeleton.parents[joint] = parent >= 0 ? m_node_joints[parent] : -1;
+
+        if (inverse_bind.size() >= (order[joint] + 1) * 16)
+        {
+            float const* matrix = inverse_bind.data() + order[joint] * 16;
+            for (int i{ 0 }; i < 16; ++i)
+            {
+                skeleton.inverse_bind[joint][i / 4][i % 4] = matrix[i];
+            }
+        }
+
+        NodeTRS trs = NodeTransform(node);
+        skeleton.rest.SetTranslation(joint, trs.translation);
+        skeleton.rest.SetRotation(joint, trs.rotation);
+        skeleton.rest.SetScale(joint, trs.scale);
+    }
+
+    // Ancestors of the first root joint, assumed shared by every root
+    for (int32_t node = node_parents[skin.joints[order[0]]]; node >= 0; node = node_parents[node])
+    {
+        skeleton.root = NodeMatrix(m_model.nodes[node]) * skeleton.root;
+    }
+
+    m_skin = std::move(skin_info);
+}
+
+void GLTFHelper::LoadAnimation(tinygltf::Animation const& animation)
+{
+    struct Track
+    {
+        uint32_t           joint;
+        PoseStream         stream;     // first of the target's streams
+        uint32_t           components;
+        bool               step;
+        bool               cubic;      // keys are in tangent, value, out tangent
+        std::vector<float> times;
+        std::vector<float> values;
+    };
+
+    std::vector<Track> tracks;
+    float duration{ 0.0f };
+    for (auto const& channel : animation.channels)
+    {
+        // Morph weights and nodes outside the skeleton are not animated
+        if (channel.target_node < 0 || channel.sampler < 0 || m_node_joints[channel.target_node] < 0)
+        {
+            continue;
+        }
+        Track track{ .joint = static_cast<uint32_t>(m_node_joints[channel.target_node]) };
+        if (channel.target_path == "translation")
+        {
+            track.stream = PoseStream::TranslationX;
+            track.components = 3;
+        }
+        else if (channel.target_path == "rotation")
+        {
+            track.stream = PoseStream::RotationX;
+            track.components = 4;
+        }
+        else if (channel.target_path == "scale")
+        {
+            track.stream = PoseStream::ScaleX;
+            track.components = 3;
+        }
+        else
+        {
+            continue;
+        }
+
+        auto const& sampler = animation.samplers[channel.sampler];
+        track.step = sampler.interpolation == "STEP";
+        track.cubic = sampler.interpolation == "CUBICSPLINE";
+        track.times = ReadAccessor(sampler.input);
+        track.values = ReadAccessor(sampler.output);
+        size_t key_floats = track.components * (track.cubic ? 3 : 1);
+        if (track.times.empty() || track.values.size() < track.times.size() * key_floats)
+        {
+            SO_WARN("Skipped a malformed channel of animation {}", animation.name);
+            continue;
+        }
+        duration = std::max(duration, track.times.back());
+        tracks.push_back(std::move(track));
+    }
+
+    Skeleton const& skeleton = m_skin->skeleton;
+    AnimationClip clip{};
+    clip.name = animation.name.empty() ? std::to_string(m_skin->clips.size()) : animation.name;
+    clip.duration = duration;
+    clip.sample_rate = s_sample_rate;
+    clip.frame_count = static_cast<uint32_t>(std::ceil(duration * s_sample_rate)) + 1;
+    clip.stride = static_cast<uint32_t>(skeleton.rest.Data().size());
+    clip.frames.resize(static_cast<size_t>(clip.frame_count) * clip.stride);
+
+    Pose pose{};
+    Pose previous{};
+    for (uint32_t frame{ 0 }; frame < clip.frame_count; ++frame)
+    {
+        pose = skeleton.rest;
+        float time = std::min(static_cast<float>(frame) / s_sample_rate, duration);
+        for (auto const& track : tracks)
+        {
+            // Keys around the frame, held at both ends
+            auto next = static_cast<size_t>(std::upper_bound(track.times.begin(), track.times.end(), time) - track.times.begin());
+            size_t b = std::min(next, track.times.size() - 1);
+            size_t a = next == 0 ? 0 : next - 1;
+            float alpha = a == b || track.step ? 0.0f : (time - track.times[a]) / (track.times[b] - track.times[a]);
+
+            // Cubic splines are sampled through their values only, the
+            // fixed rate keeps the error small
+            size_t key_floats = track.components * (track.cubic ? 3 : 1);
+            size_t value_offset = track.cubic ? track.components : 0;
+            float const* va = track.values.data() + a * key_floats + value_offset;
+            float const* vb = track.values.data() + b * key_floats + value_offset;
+            if (track.stream == PoseStream::RotationX)
+            {
+                glm::quat qa(va[3], va[0], va[1], va[2]);
+                glm::quat qb(vb[3], vb[0], vb[1], vb[2]);
+                pose.SetRotation(track.joint, glm::normalize(glm::slerp(qa, qb, alpha)));
+            }
+            else
+            {
+                glm::vec3 value = glm::mix(glm::vec3(va[0], va[1], va[2]), glm::vec3(vb[0], vb[1], vb[2]), alpha);
+                if (track.stream == PoseStream::TranslationX)
+                {
+                    pose.SetTranslation(track.joint, value);
+                }
+                else
+                {
+                    pose.SetScale(track.joint, value);
+                }
+            }
+        }
+
+        // Same hemisphere as the frame before, sampling blends neighbours
+        // component wise
+        if (frame > 0)
+        {
+            for (uint32_t joint{ 0 }; joint < skeleton.JointCount(); ++joint)
+            {
+                glm::quat rotation = pose.GetRotation(joint);
+                if (glm::dot(rotation, previous.GetRotation(joint)) < 0.0f)
+                {
+                    pose.SetRotation(joint, -rotation);
+                }
+            }
+        }
+        std::copy(pose.Data().begin(), pose.Data().end(), clip.frames.begin() + static_cast<size_t>(frame) * clip.stride);
+        previous = pose;
+    }
+
+    m_skin->clips.push_back(CompressClip(clip, skeleton.JointCount(), m_tolerance));
+}
+
+void GLTFHelper::AppendSkinStreams(tinygltf::Primitive const& primitive, MeshDescription& mesh_info)
+{
+    auto position = primitive.attributes.find("POSITION");
+    if (position == primitive.attributes.end())
+    {
+        return;
+    }
+    size_t vertex_count = m_model.accessors[position->second].count;
+    std::vector<uint16_t> joints(vertex_count * 4, 0);
+    std::vector<float> weights(vertex_count * 4, 0.0f);
+
+    auto joints_attribute = primitive.attributes.find("JOINTS_0");
+    auto weights_attribute = primitive.attributes.find("WEIGHTS_0");
+    std::vector<float> source_joints = joints_attribute != primitive.attributes.end() ? ReadAccessor(joints_attribute->second) : std::vector<float>{};
+    std::vector<float> source_weights = weights_attribute != primitive.attributes.end() ? ReadAccessor(weights_attribute->second) : std::vector<float>{};
+    if (source_joints.size() < joints.size() || source_weights.size() < weights.size())
+    {
+        SO_WARN("Primitive of a skinned model has no JOINTS_0 or WEIGHTS_0, bound to the first joint");
+        source_joints.assign(joints.size(), 0.0f);
+        source_weights.assign(weights.size(), 0.0f);
+    }
+    for (size_t vertex{ 0 }; vertex < vertex_count; ++vertex)
+    {
+        float sum{ 0.0f };
+        for (size_t i = vertex * 4; i < vertex * 4 + 4; ++i)
+        {
+            auto joint = static_cast<size_t>(source_joints[i]);
+            joints[i] = joint < m_joint_remap.size() ? m_joint_remap[joint] : 0;
+            weights[i] = source_weights[i];
+            sum += weights[i];
+        }
+        // Exporters quantize weights, they rarely sum to exactly one
+        if (sum > 0.0f)
+        {
+            for (size_t i = vertex * 4; i < vertex * 4 + 4; ++i)
+            {
+                weights[i] /= sum;
+            }
+        }
+        else
+        {
+            joints[vertex * 4] = 0;
+            weights[vertex * 4] = 1.0f;
+        }
+    }
+
+    auto append = [this, &mesh_info](void const* data, size_t byte_size)
+    {
+        auto& bytes = m_converted.emplace_back(byte_size);
+        std::memcpy(bytes.data(), data, byte_size);
+        mesh_info.attributes.push_back(BufferAttribute{
+            .data_section = bytes.data(),
+            .byte_size = byte_size,
+            .byte_offset = 0,
+        });
+        m_total_size += byte_size;
+    };
+    append(joints.data(), joints.size() * sizeof(uint16_t));
+    append(weights.data(), weights.size() * sizeof(float));
+}
+
+auto GLTFHelper::ReadAccessor(int accessor_index) const -> std::vector<float>
+{
+    auto const& accessor = m_model.accessors[accessor_index];
+    auto components = static_cast<size_t>(tinygltf::GetNumComponentsInType(accessor.type));
+    std::vector<float> values(accessor.count * components, 0.0f);
+    // Zero without a view, sparse values are not applied
+    if (accessor.bufferView < 0)
+    {
+        return values;
+    }
+
+    auto const& view = m_model.bufferViews[accessor.bufferView];
+    int stride = accessor.ByteStride(view);
+    auto component_size = static_cast<size_t>(tinygltf::GetComponentSizeInBytes(accessor.componentType));
+    if (stride <= 0 || component_size == 0)
+    {
+        SO_ERROR("Invalid accessor {}", accessor_index);
+        return values;
+    }
+    unsigned char const* data = m_model.buffers[view.buffer].data.data() + view.byteOffset + accessor.byteOffset;
+    for (size_t element{ 0 }; element < accessor.count; ++element)
+    {
+        for (size_t component{ 0 }; component < components; ++component)
+        {
+            unsigned char const* source = data + element * stride + component * component_size;
+            values[element * components + component] = ReadComponent(source, accessor.componentType, accessor.normalized);
+        }
+    }
+    return values;
+}
+
 void GLTFHelper::Clear()
 {
     // MeshInfo hold data reference from tinygltf::Model,
     // so when clearing the model, the data become invalid as well.
     m_model = {};
     m_meshes.clear();
+    m_skin.reset();
+    m_node_joints.clear();
+    m_joint_remap.clear();
+    m_converted.clear();
     m_total_size = 0;
+    m_min = glm::vec3(std::numeric_limits<float>::max());
+    m_max = glm::vec3(std::numeric_limits<float>::lowest());
+}
+
+auto GLTFHelper::GetBounds() const -> glm::vec4
+{
+    if (m_min.x > m_max.x)
+    {
+        return glm::vec4(0.0f);
+    }
+    return glm::vec4((m_min + m_max) * 0.5f, glm::length(m_max - m_min) * 0.5f);
 }
\ No newline at end of file
@@ -1,9 +1,12 @@
 #pragma once
+#include <limits>
+#include <memory>
 #include <vector>
 #include <filesystem>
 #include <tiny_gltf.h>
 #include <glm/glm.hpp>
 #include <SDL3/SDL_gpu.h>
+#include "Animation.hpp"
 
 auto VertexElementSize(SDL_GPUVertexElementFormat format) -> uint32_t;
 auto IndexElementSize(SDL_GPUIndexElementSize size) -> uint32_t;
@@ -24,13 +27,37 @@ class GLTFHelper
         SDL_GPUIndexElementSize      index_type;
     };
 public:
-    auto Load(std::filesystem::path const& path) -> std::pair<uint32_t, std::vector<MeshDescription> const&>;
+    // Clips come from `clips` when set, a file written by tools/animimport.cpp,
+    // instead of compressing the glTF's animations
+    auto Load(std::filesystem::path const& path, std::filesystem::path const& clips = {}) -> std::pair<uint32_t, std::vector<MeshDescription> const&>;
     void Clear();
+
+    [[nodiscard]] auto GetMeshes() const -> std::vector<MeshDescription> const& { return m_meshes; }
+    [[nodiscard]] auto GetTotalSize() const -> uint32_t { return static_cast<uint32_t>(m_total_size); }
+    // Sphere around every position as center and radius, zero without meshes
+    [[nodiscard]] auto GetBounds() const -> glm::vec4;
+    // Skeleton and clips of the first skin, null for static models. Meshes
+    // of a skinned model carry joint and weight streams after the normals.
+    [[nodiscard]] auto GetSkin() const -> std::shared_ptr<SkinInfo> { return m_skin; }
+    // Used for the glTF's animations by the next Load
+    void SetClipTolerance(ClipTolerance const& tolerance) { m_tolerance = tolerance; }
 private:
     void LoadNode(tinygltf::Node const& node);
     void LoadMesh(tinygltf::Mesh const& mesh);
+    void LoadSkin();
+    void LoadAnimation(tinygltf::Animation const& animation);
+    void AppendSkinStreams(tinygltf::Primitive const& primitive, MeshDescription& mesh_info);
+    // Elements as floats, normalized integers are mapped to [0, 1] or [-1, 1]
+    [[nodiscard]] auto ReadAccessor(int accessor_index) const -> std::vector<float>;
 private:
     tinygltf::Model m_model;
     std::vector<MeshDescription> m_meshes;
+    std::shared_ptr<SkinInfo> m_skin;
+    ClipTolerance m_tolerance{};
+    std::vector<int32_t> m_node_joints;            // joint of every node, -1 for other nodes
+    std::vector<uint16_t> m_joint_remap;           // skin joint order to Skeleton order
+    std::vector<std::vector<uint8_t>> m_converted; // streams not in the glTF buffers
     size_t m_total_size{ 0 };
+    glm::vec3 m_min{ std::numeric_limits<float>::max() };
+    glm::vec3 m_max{ std::numeric_limits<float>::lowest() };
 };
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <optional>
+
+// Index into a SlotArray plus the generation of the slot when the handle
+// was issued. A handle to a freed slot stops resolving even after the slot
+// is reused. `Tag` only keeps handles of different resources apart.
+template <typename Tag>
+struct Handle
+{
+    uint32_t index{ 0 };
+    uint32_t generation{ 0 }; // 0 never names a live slot
+
+    [[nodiscard]] auto IsValid() const -> bool { return generation != 0; }
+    [[nodiscard]] auto operator == (Handle const& rhs) const -> bool = default;
+};
+
+// Dense slots with a free list and a reference count per slot. Insert
+// hands out the first reference, the slot is freed when the last one is
+// released.
+template <typename T, typename HandleT>
+class SlotArray
+{
+public:
+    auto Insert(T value) -> HandleT
+    {
+        uint32_t index{ 0 };
+        if (m_free.empty())
+        {
+            index = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back({});
+        }
+        else
+        {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+
+        Slot& slot = m_slots[index];
+        slot.value = std::move(value);
+        slot.ref_count = 1;
+        ++m_size;
+        return { index, slot.generation };
+    }
+
+    [[nodiscard]] auto Get(HandleT handle) -> T*
+    {
+        Slot* slot = Resolve(handle);
+        return slot ? &slot->value : nullptr;
+    }
+
+    [[nodiscard]] auto Get(HandleT handle) const -> T const*
+    {
+        return const_cast<SlotArray*>(this)->Get(handle);
+    }
+
+    [[nodiscard]] auto RefCount(HandleT handle) const -> uint32_t
+    {
+        Slot const* slot = const_cast<SlotArray*>(this)->Resolve(handle);
+        return slot ? slot->ref_count : 0;
+    }
+
+    auto AddRef(HandleT handle) -> bool
+    {
+        Slot* slot = Resolve(handle);
+        if (!slot)
+        {
+            return false;
+        }
+        ++slot->ref_count;
+        return true;
+    }
+
+    // Returns the value once the last reference is gone
+    auto Release(HandleT handle) -> std::optional<T>
+    {
+        Slot* slot = Resolve(handle);
+        if (!slot || --slot->ref_count > 0)
+        {
+            return std::nullopt;
+        }
+
+        T value = std::exchange(slot->value, T{});
+        if (++slot->generation == 0)
+        {
+            slot->generation = 1;
+        }
+        m_free.push_back(handle.index);
+        --m_size;
+        return value;
+    }
+
+    template <typename Fn>
+    void ForEach(Fn&& fn)
+    {
+        for (uint32_t i{ 0 }; i < m_slots.size(); ++i)
+        {
+            if (m_slots[i].ref_count > 0)
+            {
+                fn(HandleT{ i, m_slots[i].generation }, m_slots[i].value);
+            }
+        }
+    }
+
+    void Clear()
+    {
+        m_slots.clear();
+        m_free.clear();
+        m_size = 0;
+    }
+
+    [[nodiscard]] auto Size() const -> size_t { return m_size; }
+private:
+    struct Slot
+    {
+        T        value{};
+        uint32_t generation{ 1 };
+        uint32_t ref_count{ 0 };
+    };
+
+    auto Resolve(HandleT handle) -> Slot*
+    {
+        if (handle.index >= m_slots.size())
+        {
+            return nullptr;
+        }
+        Slot& slot = m_slots[handle.index];
+        return slot.generation == handle.generation && slot.ref_count > 0 ? &slot : nullptr;
+    }
+private:
+    std::vector<Slot>     m_slots;
+    std::vector<uint32_t> m_free;
+    size_t                m_size{ 0 };
+};
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+// 64-bit FNV-1a, usable both at compile time and for incremental hashing
+// of byte streams (seed with a previous result to continue a hash).
+struct Fnv1a
+{
+    static constexpr uint64_t OffsetBasis{ 14695981039346656037ull };
+    static constexpr uint64_t Prime{ 1099511628211ull };
+
+    [[nodiscard]] static constexpr auto Hash(std::string_view str, uint64_t seed = OffsetBasis) -> uint64_t
+    {
+        uint64_t hash = seed;
+        for (char c : str)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= Prime;
+        }
+        return hash;
+    }
+
+    [[nodiscard]] static auto Hash(void const* data, size_t size, uint64_t seed = OffsetBasis) -> uint64_t
+    {
+        return Hash(std::string_view{ static_cast<char const*>(data), size }, seed);
+    }
+
+    template <typename T>
+    [[nodiscard]] static constexpr auto HashValue(T value, uint64_t seed = OffsetBasis) -> uint64_t
+    {
+        static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "HashValue expects an integral or enum value");
+        uint64_t hash = seed;
+        auto bits = static_cast<uint64_t>(value);
+        for (size_t i{ 0 }; i < sizeof(T); ++i)
+        {
+            hash ^= (bits >> (i * 8)) & 0xFF;
+            hash *= Prime;
+        }
+        return hash;
+    }
+};
\ No newline at end of file
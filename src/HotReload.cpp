@@ -0,0 +1,315 @@
+#include <algorithm>
+#include "HotReload.hpp"
+#include "ShaderCache.hpp"
+#include "Script.hpp"
+#include "Logger.hpp"
+#include "Profiler.hpp"
+
+namespace {
+    // Changes arriving within this window are rebuilt together
+    constexpr int s_debounce_ms{ 50 };
+    constexpr int s_poll_ms{ 250 };
+
+    auto Normalize(std::filesystem::path const& file) -> std::filesystem::path
+    {
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(file, error);
+        return (error ? file : absolute).lexically_normal();
+    }
+
+    template <typename Fn>
+    void ForEachScript(std::filesystem::path const& dir, Fn&& fn)
+    {
+        std::error_code error;
+        for (auto& entry : std::filesystem::directory_iterator(dir, error))
+        {
+            if (entry.path().extension().string() == ".lua")
+            {
+                fn(entry.path());
+            }
+        }
+    }
+}
+
+HotReloader::HotReloader(std::filesystem::path const& root, ResourceManager& manager)
+    : m_root(root)
+    , m_manager(manager)
+{
+    m_thread = std::thread([this]() { Run(); });
+}
+
+HotReloader::~HotReloader()
+{
+    m_running = false;
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+auto HotReloader::TakeReady() -> std::vector<ReloadBatch>
+{
+    std::lock_guard lock(m_ready_mutex);
+    return std::exchange(m_ready, {});
+}
+
+void HotReloader::Run()
+{
+    SO_PROFILE_THREAD("hot reload");
+    m_lua = m_allocator.NewState();
+    luaL_openlibs(m_lua);
+    ResourceManager::LoadPreludes(m_lua, m_root);
+    Track();
+    SO_INFO("Hot reload watching {}", m_root.string());
+
+    while (m_running)
+    {
+        std::vector<std::filesystem::path> changed = m_watcher.Poll(s_poll_ms);
+        if (changed.empty())
+        {
+            continue;
+        }
+        // Editors often write a file in several steps, wait until it settles
+        for (auto more = m_watcher.Poll(s_debounce_ms); !more.empty(); more = m_watcher.Poll(s_debounce_ms))
+        {
+            changed.insert(changed.end(), more.begin(), more.end());
+        }
+
+        std::set<ReloadNode> nodes;
+        for (auto const& file : changed)
+        {
+            SO_INFO("Changed: {}", file.string());
+            if (auto dependents = m_dependents.find(file); dependents != m_dependents.end())
+            {
+                nodes.insert(dependents->second.begin(), dependents->second.end());
+            }
+            if (file.parent_path().filename() == "preludes")
+            {
+                SO_WARN("Prelude changes require a restart: {}", file.string());
+            }
+        }
+        if (nodes.empty())
+        {
+            continue;
+        }
+
+        ReloadBatch batch = Prepare(nodes);
+        std::lock_guard lock(m_ready_mutex);
+        m_ready.push_back(std::move(batch));
+    }
+
+    lua_close(m_lua);
+    m_lua = nullptr;
+}
+
+void HotReloader::Track()
+{
+    ForEachScript(m_root/"shaders", [this](std::filesystem::path const& script)
+    {
+        TrackShader(script.stem().string(), script);
+    });
+    ForEachScript(m_root/"pipelines", [this](std::filesystem::path const& script)
+    {
+        Depend(script, { ReloadTarget::Pipeline, script.stem().string() });
+    });
+    ForEachScript(m_root/"compute", [this](std::filesystem::path const& script)
+    {
+        TrackComputePipeline(script.stem().string(), script);
+    });
+    ForEachScript(m_root/"models", [this](std::filesystem::path const& script)
+    {
+        TrackModelGroup(script);
+    });
+}
+
+void HotReloader::TrackShader(std::string const& name, std::filesystem::path const& script)
+{
+    ReloadNode node{ ReloadTarget::Shader, name };
+    Forget(node);
+    Depend(script, node);
+
+    std::optional<ShaderInfo> info = m_manager.LoadShaderInfo(m_lua, script);
+    if (info && !info->is_byte_code)
+    {
+        for (auto const& file : ShaderCache::Dependencies(info->source_path))
+        {
+            Depend(file, node);
+        }
+    }
+    else if (info)
+    {
+        Depend(info->source_path, node);
+    }
+}
+
+void HotReloader::TrackComputePipeline(std::string const& name, std::filesystem::path const& script)
+{
+    ReloadNode node{ ReloadTarget::ComputePipeline, name };
+    Forget(node);
+    Depend(script, node);
+
+    std::optional<ComputePipelineInfo> info = m_manager.LoadComputePipelineInfo(m_lua, script);
+    if (info && !info->shader.is_byte_code)
+    {
+        for (auto const& file : ShaderCache::Dependencies(info->shader.source_path))
+        {
+            Depend(file, node);
+        }
+    }
+    else if (info)
+    {
+        Depend(info->shader.source_path, node);
+    }
+}
+
+auto HotReloader::TrackModelGroup(std::filesystem::path const& script) -> bool
+{
+    std::string group = Normalize(script).string();
+    Depend(script, { ReloadTarget::ModelGroup, group });
+
+    std::optional<std::vector<ModelSource>> sources = m_manager.LoadModelGroupInfo(m_lua, script);
+    if (!sources)
+    {
+        return false;
+    }
+    std::vector<std::string>& models = m_group_models[group];
+    for (auto const& name : models)
+    {
+        Forget({ ReloadTarget::Model, name });
+        m_model_sources.erase(name);
+    }
+    models.clear();
+    for (auto const& source : *sources)
+    {
+        models.push_back(source.name);
+        m_model_sources[source.name] = source;
+        Depend(source.path, { ReloadTarget::Model, source.name });
+        if (!source.clips.empty())
+        {
+            Depend(source.clips, { ReloadTarget::Model, source.name });
+        }
+    }
+    return true;
+}
+
+void HotReloader::Depend(std::filesystem::path const& file, ReloadNode const& node)
+{
+    std::filesystem::path path = Normalize(file);
+    m_dependents[path].insert(node);
+    m_watcher.Watch(path);
+}
+
+void HotReloader::Forget(ReloadNode const& node)
+{
+    // Files stay watched, changes without dependents are ignored
+    for (auto it = m_dependents.begin(); it != m_dependents.end();)
+    {
+        it->second.erase(node);
+        it = it->second.empty() ? m_dependents.erase(it) : std::next(it);
+    }
+}
+
+auto HotReloader::Prepare(std::set<ReloadNode> const& nodes) -> ReloadBatch
+{
+    ReloadBatch batch;
+    std::vector<PendingShader> shaders;
+    std::vector<std::pair<std::string, ComputePipelineInfo>> compute_pipelines;
+    std::set<std::string> models;
+
+    for (auto const& node : nodes)
+    {
+        switch (node.target)
+        {
+        case ReloadTarget::Shader:
+            {
+                std::filesystem::path script = m_root/"shaders"/(node.name + ".lua");
+                if (auto info = m_manager.LoadShaderInfo(m_lua, script))
+                {
+                    shaders.push_back({ node.name, std::move(*info) });
+                }
+                // Imports may have changed
+                TrackShader(node.name, script);
+                break;
+            }
+        case ReloadTarget::Pipeline:
+            {
+                std::filesystem::path script = m_root/"pipelines"/(node.name + ".lua");
+                if (auto info = m_manager.LoadPipelineInfo(m_lua, script))
+                {
+                    batch.pipelines.push_back({ node.name, std::move(*info) });
+                }
+                break;
+            }
+        case ReloadTarget::ComputePipeline:
+            {
+                std::filesystem::path script = m_root/"compute"/(node.name + ".lua");
+                if (auto info = m_manager.LoadComputePipelineInfo(m_lua, script))
+                {
+                    compute_pipelines.push_back({ node.name, std::move(*info) });
+                }
+                TrackComputePipeline(node.name, script);
+                break;
+            }
+        case ReloadTarget::ModelGroup:
+            {
+                std::vector<std::string> previous = m_group_models[node.name];
+                if (!TrackModelGroup(node.name))
+                {
+                    break;
+                }
+                std::vector<std::string> const& current = m_group_models[node.name];
+                for (auto const& name : previous)
+                {
+                    if (std::find(current.begin(), current.end(), name) == current.end())
+                    {
+                        batch.removed_models.push_back(name);
+                    }
+                }
+                models.insert(current.begin(), current.end());
+                break;
+            }
+        case ReloadTarget::Model:
+            models.insert(node.name);
+            break;
+        }
+    }
+
+    // Compute shaders compile in the same batch
+    size_t graphics_count = shaders.size();
+    for (auto const& [name, info] : compute_pipelines)
+    {
+        shaders.push_back({ .name = name, .info = info.shader, .compute = true });
+    }
+    std::vector<std::filesystem::path> code_paths = m_manager.CompileShaders(shaders);
+    for (size_t i{ 0 }; i < graphics_count; ++i)
+    {
+        if (!code_paths[i].empty())
+        {
+            batch.shaders.push_back({ std::move(shaders[i]), code_paths[i] });
+        }
+    }
+    for (size_t i{ 0 }; i < compute_pipelines.size(); ++i)
+    {
+        if (!code_paths[graphics_count + i].empty())
+        {
+            auto& [name, info] = compute_pipelines[i];
+            batch.compute_pipelines.push_back({ std::move(name), std::move(info), code_paths[graphics_count + i] });
+        }
+    }
+
+    for (auto const& name : models)
+    {
+        if (!m_model_sources.contains(name))
+        {
+            continue;
+        }
+        auto gltf_helper = std::make_unique<GLTFHelper>();
+        ModelSource const& source = m_model_sources[name];
+        if (gltf_helper->Load(source.path, source.clips).first > 0)
+        {
+            batch.models.push_back({ name, std::move(gltf_helper) });
+        }
+    }
+
+    return batch;
+}
\ No newline at end of file
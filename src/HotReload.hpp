@@ -0,0 +1,85 @@
+#pragma once
+#include <set>
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <filesystem>
+#include <lua.hpp>
+#include "FileWatcher.hpp"
+#include "LuaAllocator.hpp"
+#include "GLTFHelper.hpp"
+#include "ResourceManager.hpp"
+
+enum class ReloadTarget : uint8_t
+{
+    Shader,
+    Pipeline,
+    ComputePipeline,
+    ModelGroup,
+    Model
+};
+
+struct ReloadNode
+{
+    ReloadTarget target;
+    std::string  name; // resource name, script path for model groups
+
+    [[nodiscard]] auto operator <=> (ReloadNode const& rhs) const = default;
+};
+
+// Everything prepared off the main thread for one change set.
+// Applied by ResourceManager::ApplyReloads at a frame boundary.
+struct ReloadBatch
+{
+    std::vector<std::pair<PendingShader, std::filesystem::path>>                     shaders; // info, byte code path
+    std::vector<std::pair<std::string, PipelineInfo>>                                pipelines;
+    std::vector<std::tuple<std::string, ComputePipelineInfo, std::filesystem::path>> compute_pipelines; // byte code path
+    std::vector<std::pair<std::string, std::unique_ptr<GLTFHelper>>>                 models;
+    std::vector<std::string>                                                         removed_models; // dropped from their group
+};
+
+// Watches config scripts, shader sources and model files and rebuilds the
+// affected objects on a worker thread with its own Lua state:
+//   shader source/imports, shader script -> shader -> pipelines using it
+//   pipeline script                      -> pipeline
+//   compute script, its shader source    -> compute pipeline
+//   model group script                   -> models in the group, models
+//                                           dropped from it are unloaded
+//   .glb / .gltf, compact clip file      -> model
+class HotReloader
+{
+public:
+     HotReloader(std::filesystem::path const& root, ResourceManager& manager);
+    ~HotReloader();
+
+    [[nodiscard]] auto TakeReady() -> std::vector<ReloadBatch>;
+private:
+    void Run();
+    void Track();
+    void TrackShader(std::string const& name, std::filesystem::path const& script);
+    void TrackComputePipeline(std::string const& name, std::filesystem::path const& script);
+    // False when the script fails to load, the group keeps its models
+    auto TrackModelGroup(std::filesystem::path const& script) -> bool;
+    void Depend(std::filesystem::path const& file, ReloadNode const& node);
+    // Drops every file -> node edge, before tracking the node again
+    void Forget(ReloadNode const& node);
+    auto Prepare(std::set<ReloadNode> const& nodes) -> ReloadBatch;
+private:
+    std::filesystem::path                                   m_root;
+    ResourceManager&                                        m_manager;
+    LuaAllocator                                            m_allocator{ "hot reload" };
+    lua_State*                                              m_lua{ nullptr };
+    FileWatcher                                             m_watcher;
+    std::map<std::filesystem::path, std::set<ReloadNode>>   m_dependents;
+    std::map<std::string, ModelSource>                      m_model_sources;
+    std::map<std::string, std::vector<std::string>>         m_group_models; // by group script
+
+    std::mutex                                              m_ready_mutex;
+    std::vector<ReloadBatch>                                m_ready;
+    std::atomic<bool>                                       m_running{ true };
+    std::thread                                             m_thread;
+};
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include <format>
+#include <algorithm>
+#include "JobSystem.hpp"
+#include "Logger.hpp"
+#include "Profiler.hpp"
+
+namespace {
+    // Queue of the current thread, valid while s_owner matches
+    thread_local JobSystem const* s_owner{ nullptr };
+    thread_local size_t s_queue{ 0 };
+}
+
+JobSystem::JobSystem(size_t workers)
+    : m_main_thread(std::this_thread::get_id())
+{
+    m_queues.resize(workers + 1);
+    for (auto& queue : m_queues)
+    {
+        queue = std::make_unique<Queue>();
+    }
+    m_workers.reserve(workers);
+    for (size_t i{ 1 }; i <= workers; ++i)
+    {
+        m_workers.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(m_sleep_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::Run(Job job, JobCounter* counter)
+{
+    if (counter)
+    {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    Push({ std::move(job), counter });
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, Job job, JobCounter* counter)
+{
+    // Counted now, so waiting on `counter` covers the deferred job
+    if (counter)
+    {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard lock(dependency.m_mutex);
+        if (!dependency.IsDone())
+        {
+            dependency.m_continuations.push_back([this, job = std::move(job), counter]() mutable
+            {
+                Push({ std::move(job), counter });
+            });
+            return;
+        }
+    }
+    Push({ std::move(job), counter });
+}
+
+void JobSystem::RunOnMain(Job job, JobCounter* counter)
+{
+    if (counter)
+    {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::lock_guard lock(m_main_queue.mutex);
+    m_main_queue.tasks.push_back({ std::move(job), counter });
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, RangeJob job, JobCounter* counter)
+{
+    grain = std::max<size_t>(grain, 1);
+    auto shared = std::make_shared<RangeJob>(std::move(job));
+    for (size_t begin{ 0 }; begin < count; begin += grain)
+    {
+        size_t end = std::min(begin + grain, count);
+        Run([shared, begin, end]() { (*shared)(begin, end); }, counter);
+    }
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, RangeJob const& job)
+{
+    JobCounter counter;
+    ParallelFor(count, grain, [&job](size_t begin, size_t end) { job(begin, end); }, &counter);
+    Wait(counter);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    bool main_thread = IsMainThread();
+    while (!counter.IsDone())
+    {
+        std::optional<Task> task = main_thread ? TakeMain() : std::nullopt;
+        if (!task)
+        {
+            task = Take(CurrentQueue());
+        }
+        if (task)
+        {
+            Execute(*task);
+            continue;
+        }
+        std::this_thread::yield();
+    }
+    // The last Finish may still hold the lock
+    std::lock_guard lock(counter.m_mutex);
+}
+
+void JobSystem::PumpMain()
+{
+    // Only what is queued now, jobs queued by these wait for the next pump
+    std::deque<Task> tasks;
+    {
+        std::lock_guard lock(m_main_queue.mutex);
+        tasks.swap(m_main_queue.tasks);
+    }
+    for (auto& task : tasks)
+    {
+        Execute(task);
+        m_main_executed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+auto JobSystem::GetStats() const -> JobStats
+{
+    return {
+        .executed = m_executed.load(std::memory_order_relaxed),
+        .stolen = m_stolen.load(std::memory_order_relaxed),
+        .main_thread = m_main_executed.load(std::memory_order_relaxed),
+    };
+}
+
+void JobSystem::LogStats() const
+{
+    JobStats stats = GetStats();
+    SO_INFO("Jobs: {} executed on {} workers, {} stolen, {} on main thread",
+        stats.executed, m_workers.size(), stats.stolen, stats.main_thread);
+}
+
+void JobSystem::Push(Task task)
+{
+    // Counted first so it never drops below the queued tasks
+    m_queued.fetch_add(1, std::memory_order_release);
+    {
+        Queue& queue = *m_queues[CurrentQueue()];
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    // Taking the lock orders this against a worker about to sleep
+    {
+        std::lock_guard lock(m_sleep_mutex);
+    }
+    m_wake.notify_one();
+}
+
+auto JobSystem::Take(size_t index) -> std::optional<Task>
+{
+    if (m_queued.load(std::memory_order_acquire) == 0)
+    {
+        return std::nullopt;
+    }
+
+    // Own queue newest first, it is still warm in cache
+    {
+        Queue& own = *m_queues[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            Task task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+
+    // Steal the oldest, usually the largest piece of remaining work
+    for (size_t i{ 1 }; i < m_queues.size(); ++i)
+    {
+        Queue& victim = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            Task task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            m_stolen.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    return std::nullopt;
+}
+
+auto JobSystem::TakeMain() -> std::optional<Task>
+{
+    std::lock_guard lock(m_main_queue.mutex);
+    if (m_main_queue.tasks.empty())
+    {
+        return std::nullopt;
+    }
+    Task task = std::move(m_main_queue.tasks.front());
+    m_main_queue.tasks.pop_front();
+    m_main_executed.fetch_add(1, std::memory_order_relaxed);
+    return task;
+}
+
+void JobSystem::Execute(Task& task)
+{
+    task.job();
+    m_executed.fetch_add(1, std::memory_order_relaxed);
+    if (task.counter)
+    {
+        Finish(*task.counter);
+    }
+}
+
+void JobSystem::Finish(JobCounter& counter)
+{
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard lock(counter.m_mutex);
+        if (counter.m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            ready = std::move(counter.m_continuations);
+            counter.m_continuations.clear();
+        }
+    }
+    // The counter may be gone from here on
+    for (auto& continuation : ready)
+    {
+        continuation();
+    }
+}
+
+auto JobSystem::CurrentQueue() const -> size_t
+{
+    return s_owner == this ? s_queue : 0;
+}
+
+void JobSystem::WorkerLoop(size_t index)
+{
+    s_owner = this;
+    s_queue = index;
+    SO_PROFILE_THREAD(std::format("job worker {}", index));
+
+    while (true)
+    {
+        if (std::optional<Task> task = Take(index))
+        {
+            Execute(*task);
+            continue;
+        }
+
+        std::unique_lock lock(m_sleep_mutex);
+        m_wake.wait(lock, [this]()
+        {
+            return m_stop || m_queued.load(std::memory_order_acquire) > 0;
+        });
+        if (m_stop && m_queued.load(std::memory_order_acquire) == 0)
+        {
+            break;
+        }
+    }
+
+    s_owner = nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <condition_variable>
+
+// Number of unfinished jobs signalling it. Jobs can be scheduled to start
+// once a counter reaches zero. Wait on it before it goes out of scope.
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(JobCounter const&) = delete;
+    auto operator = (JobCounter const&) -> JobCounter& = delete;
+
+    [[nodiscard]] auto IsDone() const -> bool { return m_pending.load(std::memory_order_acquire) == 0; }
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t>              m_pending{ 0 };
+    std::mutex                         m_mutex; // continuations, and the last decrement
+    std::vector<std::function<void()>> m_continuations;
+};
+
+struct JobStats
+{
+    uint64_t executed{ 0 };
+    uint64_t stolen{ 0 };
+    uint64_t main_thread{ 0 };
+};
+
+// Work-stealing scheduler. Every worker and the main thread own a deque:
+// the owner pushes and pops at the back, idle threads steal from the front
+// of the others. Jobs must not block on anything but Wait, which keeps
+// running jobs until its counter drops to zero. Jobs scheduled with
+// RunOnMain only run on the thread that created the system, for SDL calls.
+class JobSystem
+{
+public:
+    using Job = std::function<void()>;
+    using RangeJob = std::function<void(size_t begin, size_t end)>;
+
+    // Background workers, the main thread works too while it waits
+    explicit JobSystem(size_t workers);
+    ~JobSystem();
+    JobSystem(JobSystem const&) = delete;
+    auto operator = (JobSystem const&) -> JobSystem& = delete;
+
+    void Run(Job job, JobCounter* counter = nullptr);
+    // Starts once `dependency` reaches zero
+    void RunAfter(JobCounter& dependency, Job job, JobCounter* counter = nullptr);
+    // Picked up by Wait or PumpMain on the main thread
+    void RunOnMain(Job job, JobCounter* counter = nullptr);
+    // job(begin, end) over [0, count) in ranges of at most `grain` items
+    void ParallelFor(size_t count, size_t grain, RangeJob job, JobCounter* counter);
+    // Blocking, `job` only has to live for the call
+    void ParallelFor(size_t count, size_t grain, RangeJob const& job);
+
+    void Wait(JobCounter& counter);
+    // Runs queued main thread jobs, once per frame
+    void PumpMain();
+
+    [[nodiscard]] auto WorkerCount() const -> size_t { return m_workers.size(); }
+    [[nodiscard]] auto IsMainThread() const -> bool { return std::this_thread::get_id() == m_main_thread; }
+    [[nodiscard]] auto GetStats() const -> JobStats;
+    void LogStats() const;
+private:
+    struct Task
+    {
+        Job         job;
+        JobCounter* counter;
+    };
+
+    struct Queue
+    {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Push(Task task);
+    [[nodiscard]] auto Take(size_t index) -> std::optional<Task>;
+    [[nodiscard]] auto TakeMain() -> std::optional<Task>;
+    void Execute(Task& task);
+    void Finish(JobCounter& counter);
+    [[nodiscard]] auto CurrentQueue() const -> size_t;
+    void WorkerLoop(size_t index);
+private:
+    std::thread::id                     m_main_thread;
+    // 0 belongs to the main thread, and to threads outside the system
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    Queue                               m_main_queue;
+    std::vector<std::thread>            m_workers;
+
+    std::atomic<size_t>                 m_queued{ 0 };
+    std::mutex                          m_sleep_mutex;
+    std::condition_variable             m_wake;
+    std::atomic<bool>                   m_stop{ false };
+
+    std::atomic<uint64_t>               m_executed{ 0 };
+    std::atomic<uint64_t>               m_stolen{ 0 };
+    std::atomic<uint64_t>               m_main_executed{ 0 };
+};
\ No newline at end of file
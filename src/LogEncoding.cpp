@@ -0,0 +1,197 @@
+#include <vector>
+#include <variant>
+#include "LogEncoding.hpp"
+
+namespace {
+    using LogArgValue = std::variant<bool, char, int64_t, uint64_t, double, std::string_view, void const*>;
+
+    auto DecodeArgs(std::string_view args) -> std::vector<LogArgValue>
+    {
+        std::vector<LogArgValue> values;
+        LogReader reader(args);
+        while (!reader.AtEnd())
+        {
+            std::optional<uint8_t> type = reader.Byte();
+            std::optional<uint64_t> number{};
+            switch (static_cast<LogArgType>(type.value_or(0xff)))
+            {
+            case LogArgType::Bool:
+                number = reader.Byte();
+                if (number)
+                {
+                    values.emplace_back(*number != 0);
+                }
+                break;
+            case LogArgType::Char:
+                number = reader.Byte();
+                if (number)
+                {
+                    values.emplace_back(static_cast<char>(*number));
+                }
+                break;
+            case LogArgType::Int:
+                number = reader.Varint();
+                if (number)
+                {
+                    values.emplace_back(static_cast<int64_t>((*number >> 1) ^ (~(*number & 1) + 1)));
+                }
+                break;
+            case LogArgType::UInt:
+                number = reader.Varint();
+                if (number)
+                {
+                    values.emplace_back(*number);
+                }
+                break;
+            case LogArgType::Double:
+                if (auto bytes = reader.Bytes(sizeof(double)))
+                {
+                    double value{ 0.0 };
+                    std::memcpy(&value, bytes->data(), sizeof(value));
+                    values.emplace_back(value);
+                    number = 0;
+                }
+                break;
+            case LogArgType::String:
+                if (auto text = reader.String())
+                {
+                    values.emplace_back(*text);
+                    number = 0;
+                }
+                break;
+            case LogArgType::Pointer:
+                number = reader.Varint();
+                if (number)
+                {
+                    values.emplace_back(reinterpret_cast<void const*>(static_cast<uintptr_t>(*number)));
+                }
+                break;
+            }
+            if (!number)
+            {
+                break; // truncated or unknown, keep what was read
+            }
+        }
+        return values;
+    }
+
+    void FormatField(std::string& out, std::string_view spec, LogArgValue const& value)
+    {
+        std::string field_format = std::format("{{:{}}}", spec);
+        std::visit([&](auto const& argument)
+        {
+            try
+            {
+                out += std::vformat(field_format, std::make_format_args(argument));
+            }
+            catch (std::format_error const&)
+            {
+                // Spec written for another type, e.g. a narrowed enum
+                out += std::vformat("{}", std::make_format_args(argument));
+            }
+        }, value);
+    }
+}
+
+auto LogReader::Byte() -> std::optional<uint8_t>
+{
+    if (m_offset >= m_bytes.size())
+    {
+        return std::nullopt;
+    }
+    return static_cast<uint8_t>(m_bytes[m_offset++]);
+}
+
+auto LogReader::Varint() -> std::optional<uint64_t>
+{
+    uint64_t value{ 0 };
+    for (uint32_t shift{ 0 }; shift < 64; shift += 7)
+    {
+        std::optional<uint8_t> byte = Byte();
+        if (!byte)
+        {
+            return std::nullopt;
+        }
+        value |= static_cast<uint64_t>(*byte & 0x7f) << shift;
+        if (!(*byte & 0x80))
+        {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+auto LogReader::String() -> std::optional<std::string_view>
+{
+    std::optional<uint64_t> size = Varint();
+    if (!size)
+    {
+        return std::nullopt;
+    }
+    return Bytes(*size);
+}
+
+auto LogReader::Bytes(size_t size) -> std::optional<std::string_view>
+{
+    if (size > m_bytes.size() - m_offset)
+    {
+        return std::nullopt;
+    }
+    std::string_view bytes = m_bytes.substr(m_offset, size);
+    m_offset += size;
+    return bytes;
+}
+
+auto FormatLogMessage(std::string_view format, std::string_view args) -> std::string
+{
+    std::vector<LogArgValue> values = DecodeArgs(args);
+    std::string out;
+    out.reserve(format.size() + args.size());
+
+    size_t next_arg{ 0 };
+    for (size_t i{ 0 }; i < format.size(); ++i)
+    {
+        char c = format[i];
+        if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c)
+        {
+            out += c; // escaped brace
+            ++i;
+            continue;
+        }
+        if (c != '{')
+        {
+            out += c;
+            continue;
+        }
+
+        size_t close = format.find('}', i);
+        if (close == std::string_view::npos)
+        {
+            out += format.substr(i);
+            break;
+        }
+        std::string_view field = format.substr(i + 1, close - i - 1);
+        std::string_view index = field.substr(0, field.find(':'));
+        std::string_view spec = index.size() < field.size() ? field.substr(index.size() + 1) : std::string_view{};
+
+        size_t arg = next_arg++;
+        if (!index.empty())
+        {
+            arg = 0;
+            for (char digit : index)
+            {
+                arg = arg * 10 + static_cast<size_t>(digit - '0');
+            }
+        }
+        if (arg < values.size())
+        {
+            FormatField(out, spec, values[arg]);
+        }
+        else
+        {
+            out += "{?}";
+        }
+        i = close;
+    }
+    return out;
+}
\ No newline at end of file
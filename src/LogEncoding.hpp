@@ -0,0 +1,180 @@
+#pragma once
+#include <array>
+#include <format>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+// Log arguments are not formatted where they are logged. Each one is
+// stored as a type tag plus its raw value, and formatted later against
+// the format string of its call site, by the logger thread for text sinks
+// or offline by logdecode for binary logs.
+//
+// Binary log file, integers are LEB128 varints, strings a varint length
+// followed by the bytes:
+//   "SLOG" version
+//   1 site:    id level line file function format
+//   2 message: site_id thread time_delta_ns args
+// A site is written before the first message that refers to it.
+
+constexpr std::string_view s_log_magic{ "SLOG" };
+constexpr uint64_t s_log_version{ 1 };
+
+enum class LogRecordKind : uint8_t
+{
+    Site = 1,
+    Message = 2
+};
+
+enum class LogArgType : uint8_t
+{
+    Bool,
+    Char,
+    Int,     // zigzag varint
+    UInt,    // varint
+    Double,  // 8 bytes
+    String,  // varint length + bytes
+    Pointer  // varint
+};
+
+// Encoded arguments of one record. Small enough payloads stay inline so a
+// log call does not allocate, larger ones spill to the heap.
+class LogArgBuffer
+{
+public:
+    static constexpr size_t s_inline_size{ 128 };
+
+    void Append(void const* data, size_t size)
+    {
+        if (m_spill.empty() && m_size + size <= s_inline_size)
+        {
+            std::memcpy(m_inline.data() + m_size, data, size);
+            m_size += static_cast<uint32_t>(size);
+            return;
+        }
+        if (m_spill.empty())
+        {
+            m_spill.assign(reinterpret_cast<char const*>(m_inline.data()), m_size);
+        }
+        m_spill.append(static_cast<char const*>(data), size);
+    }
+
+    void AppendByte(uint8_t byte)
+    {
+        Append(&byte, 1);
+    }
+
+    void AppendVarint(uint64_t value)
+    {
+        std::array<uint8_t, 10> bytes{};
+        size_t count{ 0 };
+        do
+        {
+            uint8_t byte = value & 0x7f;
+            value >>= 7;
+            bytes[count++] = value ? byte | 0x80 : byte;
+        } while (value);
+        Append(bytes.data(), count);
+    }
+
+    void AppendString(std::string_view text)
+    {
+        AppendVarint(text.size());
+        Append(text.data(), text.size());
+    }
+
+    [[nodiscard]] auto View() const -> std::string_view
+    {
+        if (!m_spill.empty())
+        {
+            return m_spill;
+        }
+        return { reinterpret_cast<char const*>(m_inline.data()), m_size };
+    }
+
+    void Clear()
+    {
+        m_size = 0;
+        m_spill.clear();
+    }
+private:
+    std::array<std::byte, s_inline_size> m_inline;
+    uint32_t                             m_size{ 0 };
+    std::string                          m_spill;
+};
+
+template <typename T>
+void EncodeLogArg(LogArgBuffer& buffer, T const& value)
+{
+    using U = std::remove_cvref_t<T>;
+    if constexpr (std::is_same_v<U, bool>)
+    {
+        buffer.AppendByte(static_cast<uint8_t>(LogArgType::Bool));
+        buffer.AppendByte(value ? 1 : 0);
+    }
+    else if constexpr (std::is_same_v<U, char>)
+    {
+        buffer.AppendByte(static_cast<uint8_t>(LogArgType::Char));
+        buffer.AppendByte(static_cast<uint8_t>(value));
+    }
+    else if constexpr (std::is_enum_v<U>)
+    {
+        EncodeLogArg(buffer, static_cast<std::underlying_type_t<U>>(value));
+    }
+    else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>)
+    {
+        auto wide = static_cast<int64_t>(value);
+        buffer.AppendByte(static_cast<uint8_t>(LogArgType::Int));
+        buffer.AppendVarint((static_cast<uint64_t>(wide) << 1) ^ static_cast<uint64_t>(wide >> 63));
+    }
+    else if constexpr (std::is_integral_v<U>)
+    {
+        buffer.AppendByte(static_cast<uint8_t>(LogArgType::UInt));
+        buffer.AppendVarint(static_cast<uint64_t>(value));
+    }
+    else if constexpr (std::is_floating_point_v<U>)
+    {
+        auto wide = static_cast<double>(value);
+        buffer.AppendByte(static_cast<uint8_t>(LogArgType::Double));
+        buffer.Append(&wide, sizeof(wide));
+    }
+    else if constexpr (std::is_convertible_v<U const&, std::string_view>)
+    {
+        buffer.AppendByte(static_cast<uint8_t>(LogArgType::String));
+        buffer.AppendString(std::string_view(value));
+    }
+    else if constexpr (std::is_pointer_v<U>)
+    {
+        buffer.AppendByte(static_cast<uint8_t>(LogArgType::Pointer));
+        buffer.AppendVarint(reinterpret_cast<uintptr_t>(value));
+    }
+    else
+    {
+        // Anything else only knows how to format itself, do it now
+        buffer.AppendByte(static_cast<uint8_t>(LogArgType::String));
+        buffer.AppendString(std::format("{}", value));
+    }
+}
+
+// Reads back what LogArgBuffer and the binary log writer produce
+class LogReader
+{
+public:
+    explicit LogReader(std::string_view bytes) : m_bytes(bytes) {}
+
+    [[nodiscard]] auto Byte() -> std::optional<uint8_t>;
+    [[nodiscard]] auto Varint() -> std::optional<uint64_t>;
+    [[nodiscard]] auto String() -> std::optional<std::string_view>;
+    [[nodiscard]] auto Bytes(size_t size) -> std::optional<std::string_view>;
+    [[nodiscard]] auto AtEnd() const -> bool { return m_offset >= m_bytes.size(); }
+private:
+    std::string_view m_bytes;
+    size_t           m_offset{ 0 };
+};
+
+// Formats encoded arguments like std::format would have at the call site
+[[nodiscard]] auto FormatLogMessage(std::string_view format, std::string_view args) -> std::string;
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include <format>
+#include <algorithm>
+#include <iostream>
+#include "LogSinks.hpp"
+
+namespace {
+    auto LevelName(LogLevelFlag level) -> std::string_view
+    {
+        if (level & LogLevelFlagBits::Error)
+        {
+            return "error";
+        }
+        if (level & LogLevelFlagBits::Warn)
+        {
+            return "warn";
+        }
+        return "info";
+    }
+}
+
+auto FormatLogLine(LogRecord const& record) -> std::string
+{
+    LogSite const& site = *record.site;
+    return std::format(
+        "[{:10.3f}] [{}] [{}] {}:{} ({}) {}\n",
+        static_cast<double>(record.time) * 1e-9, LevelName(site.level), record.thread,
+        site.file, site.line, site.function,
+        record.message);
+}
+
+void ConsoleSink::Write(LogRecord const& record)
+{
+    LogSite const& site = *record.site;
+    std::cout << std::format(
+        "󱞩[ {}:{} ({}) ] {}\n",
+        site.file, site.line, site.function,
+        record.message);
+}
+
+void ConsoleSink::Flush()
+{
+    std::cout.flush();
+}
+
+FileSink::FileSink(std::filesystem::path const& path)
+    : m_path(path)
+{
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    m_file.open(path, std::ios::app);
+}
+
+void FileSink::Write(LogRecord const& record)
+{
+    m_file << FormatLogLine(record);
+}
+
+void FileSink::Flush()
+{
+    m_file.flush();
+}
+
+RotatingFileSink::RotatingFileSink(std::filesystem::path const& path, uint64_t max_bytes, uint32_t max_files)
+    : FileSink(path)
+    , m_max_bytes(max_bytes)
+    , m_max_files(max_files)
+{
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(path, error);
+    m_bytes = error ? 0 : static_cast<uint64_t>(size);
+}
+
+void RotatingFileSink::Write(LogRecord const& record)
+{
+    std::string line = FormatLogLine(record);
+    if (m_bytes > 0 && m_bytes + line.size() > m_max_bytes)
+    {
+        Rotate();
+    }
+    m_file << line;
+    m_bytes += line.size();
+}
+
+void RotatingFileSink::Rotate()
+{
+    m_file.close();
+
+    auto numbered = [this](uint32_t index)
+    {
+        std::filesystem::path path = m_path;
+        path += std::format(".{}", index);
+        return path;
+    };
+    std::error_code error;
+    if (m_max_files > 0)
+    {
+        std::filesystem::remove(numbered(m_max_files), error);
+        for (uint32_t i = m_max_files; i > 1; --i)
+        {
+            std::filesystem::rename(numbered(i - 1), numbered(i), error);
+        }
+        std::filesystem::rename(m_path, numbered(1), error);
+    }
+
+    m_file.open(m_path, std::ios::trunc);
+    m_bytes = 0;
+}
+
+BinaryLogSink::BinaryLogSink(std::filesystem::path const& path)
+{
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    // Site ids are only valid within one file, start a new one every run
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+
+    m_buffer.Append(s_log_magic.data(), s_log_magic.size());
+    m_buffer.AppendVarint(s_log_version);
+}
+
+void BinaryLogSink::Write(LogRecord const& record)
+{
+    uint64_t site = SiteID(*record.site);
+    std::string_view args = record.args.View();
+
+    m_buffer.AppendByte(static_cast<uint8_t>(LogRecordKind::Message));
+    m_buffer.AppendVarint(site);
+    m_buffer.AppendVarint(record.thread);
+    // Records from different threads may arrive slightly out of order
+    m_buffer.AppendVarint(record.time > m_last_time ? record.time - m_last_time : 0);
+    m_buffer.AppendString(args);
+    m_last_time = std::max(m_last_time, record.time);
+}
+
+void BinaryLogSink::Flush()
+{
+    std::string_view bytes = m_buffer.View();
+    m_file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    m_file.flush();
+    m_buffer.Clear();
+}
+
+auto BinaryLogSink::SiteID(LogSite const& site) -> uint64_t
+{
+    auto key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&site));
+    if (uint64_t const* id = m_sites.Find(key))
+    {
+        return *id;
+    }
+
+    uint64_t id = m_sites.Size();
+    m_sites.Assign(key, id);
+    m_buffer.AppendByte(static_cast<uint8_t>(LogRecordKind::Site));
+    m_buffer.AppendVarint(id);
+    m_buffer.AppendVarint(site.level.value);
+    m_buffer.AppendVarint(static_cast<uint64_t>(site.line));
+    m_buffer.AppendString(site.file);
+    m_buffer.AppendString(site.function);
+    m_buffer.AppendString(site.format);
+    return id;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <fstream>
+#include <filesystem>
+#include <string_view>
+#include "Logger.hpp"
+
+#include "FlatHashMap.hpp"
+
+// Destination of log records. Only the logger thread calls into a sink,
+// implementations need no locking.
+class LogSink
+{
+public:
+    virtual ~LogSink() = default;
+    virtual void Write(LogRecord const& record) = 0;
+    // After every drained batch
+    virtual void Flush() {}
+    // Sinks that write the encoded arguments skip formatting altogether
+    [[nodiscard]] virtual auto WantsText() const -> bool { return true; }
+
+    void SetLevels(LogLevelFlag levels) { m_levels = levels; }
+    [[nodiscard]] auto Accepts(LogLevelFlag level) const -> bool { return static_cast<bool>(level & m_levels); }
+private:
+    LogLevelFlag m_levels{ LogLevelFlagBits::All };
+};
+
+class ConsoleSink : public LogSink
+{
+public:
+    void Write(LogRecord const& record) override;
+    void Flush() override;
+};
+
+class FileSink : public LogSink
+{
+public:
+    explicit FileSink(std::filesystem::path const& path);
+
+    void Write(LogRecord const& record) override;
+    void Flush() override;
+protected:
+    std::filesystem::path m_path;
+    std::ofstream         m_file;
+};
+
+// Starts over once the file reaches `max_bytes`, keeping up to `max_files`
+// older logs as path.1 (newest) .. path.N
+class RotatingFileSink : public FileSink
+{
+public:
+    RotatingFileSink(std::filesystem::path const& path, uint64_t max_bytes, uint32_t max_files);
+
+    void Write(LogRecord const& record) override;
+private:
+    void Rotate();
+private:
+    uint64_t m_max_bytes;
+    uint32_t m_max_files;
+    uint64_t m_bytes{ 0 };
+};
+
+// Compact log of call site ids and encoded arguments, see LogEncoding.hpp
+// for the layout. Decode with the logdecode tool.
+class BinaryLogSink : public LogSink
+{
+public:
+    explicit BinaryLogSink(std::filesystem::path const& path);
+
+    void Write(LogRecord const& record) override;
+    void Flush() override;
+    [[nodiscard]] auto WantsText() const -> bool override { return false; }
+private:
+    auto SiteID(LogSite const& site) -> uint64_t;
+private:
+    std::ofstream                    m_file;
+    LogArgBuffer                     m_buffer;
+    FlatHashMap<uint64_t>            m_sites; // by site address
+    uint64_t                         m_last_time{ 0 };
+};
+
+[[nodiscard]] auto FormatLogLine(LogRecord const& record) -> std::string;
\ No newline at end of file
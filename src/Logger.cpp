@@ -1,22 +1,210 @@
-#include <iostream>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <condition_variable>
 #include "Logger.hpp"
+#include "LogSinks.hpp"
 
 namespace {
-    Logger*      s_instance{ nullptr };
+    constexpr size_t s_queue_capacity{ 1 << 13 };
+    constexpr auto s_idle_wait{ std::chrono::milliseconds(5) };
+
+    // Bounded multi producer queue (Vyukov). Each cell carries a sequence
+    // number telling producers and the consumer whose turn it is.
+    class LogQueue
+    {
+    public:
+        explicit LogQueue(size_t capacity)
+            : m_cells(std::make_unique<Cell[]>(capacity))
+            , m_mask(capacity - 1)
+        {
+            for (size_t i{ 0 }; i < capacity; ++i)
+            {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        auto TryPush(LogRecord& record) -> bool
+        {
+            size_t position = m_tail.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell& cell = m_cells[position & m_mask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (diff == 0)
+                {
+                    if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        cell.record = std::move(record);
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false; // full
+                }
+                else
+                {
+                    position = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Logger thread only
+        auto TryPop(LogRecord& record) -> bool
+        {
+            Cell& cell = m_cells[m_head & m_mask];
+            if (cell.sequence.load(std::memory_order_acquire) != m_head + 1)
+            {
+                return false;
+            }
+            record = std::move(cell.record);
+            cell.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+            ++m_head;
+            return true;
+        }
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            LogRecord           record;
+        };
+
+        std::unique_ptr<Cell[]>          m_cells;
+        size_t                           m_mask;
+        alignas(64) std::atomic<size_t>  m_tail{ 0 };
+        alignas(64) size_t               m_head{ 0 };
+    };
+
+    struct Backend
+    {
+        LogOverflow                           overflow{ LogOverflow::Drop };
+        LogQueue                              queue{ s_queue_capacity };
+        std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+        std::atomic<uint64_t>                 dropped{ 0 };
+
+        // Producers only touch the condition variable while the thread sleeps
+        std::atomic<bool>                     sleeping{ false };
+        std::atomic<bool>                     stop{ false };
+        std::mutex                            wake_mutex;
+        std::condition_variable               wake;
+
+        std::mutex                            sinks_mutex;
+        std::vector<std::unique_ptr<LogSink>> sinks;
+        std::thread                           thread;
+    };
+
+    Backend*     s_instance{ nullptr };
     LogLevelFlag s_Filter{ LogLevelFlagBits::None };
+    std::atomic<uint32_t> s_next_thread{ 0 };
+    thread_local uint32_t const s_thread{ s_next_thread++ };
+
+    auto Elapsed(Backend const& backend) -> uint64_t
+    {
+        auto elapsed = std::chrono::steady_clock::now() - backend.start;
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    // Formats the message the first time a text sink takes the record
+    void Deliver(Backend& backend, LogRecord& record)
+    {
+        bool formatted{ false };
+        for (auto& sink : backend.sinks)
+        {
+            if (!sink->Accepts(record.site->level))
+            {
+                continue;
+            }
+            if (sink->WantsText() && !formatted)
+            {
+                record.message = FormatLogMessage(record.site->format, record.args.View());
+                formatted = true;
+            }
+            sink->Write(record);
+        }
+    }
+
+    void Drain(Backend& backend)
+    {
+        LogRecord record;
+        while (true)
+        {
+            bool wrote{ false };
+            {
+                std::lock_guard lock(backend.sinks_mutex);
+                while (backend.queue.TryPop(record))
+                {
+                    Deliver(backend, record);
+                    wrote = true;
+                }
+
+                if (uint64_t dropped = backend.dropped.exchange(0, std::memory_order_relaxed))
+                {
+                    static LogSite const site{
+                        LogLevelFlagBits::Warn, __FILE__, __FUNCTION__, __LINE__,
+                        "{} log records dropped, queue full",
+                    };
+                    LogRecord notice{ .site = &site, .time = Elapsed(backend), .thread = s_thread };
+                    EncodeLogArg(notice.args, dropped);
+                    Deliver(backend, notice);
+                    wrote = true;
+                }
+                if (wrote)
+                {
+                    for (auto& sink : backend.sinks)
+                    {
+                        sink->Flush();
+                    }
+                }
+            }
+
+            if (backend.stop.load(std::memory_order_acquire))
+            {
+                if (!wrote)
+                {
+                    break; // stopping and drained
+                }
+                continue;
+            }
+            if (!wrote)
+            {
+                // A push racing with this still lands within the timeout
+                std::unique_lock lock(backend.wake_mutex);
+                backend.sleeping.store(true, std::memory_order_seq_cst);
+                backend.wake.wait_for(lock, s_idle_wait);
+                backend.sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
 }
 
-void Logger::Initialize()
+void Logger::Initialize(LogOverflow overflow, LogLevelFlag console_levels)
 {
-    s_instance = new Logger();
+    if (s_instance)
+    {
+        return;
+    }
+    s_instance = new Backend();
+    s_instance->overflow = overflow;
+    s_instance->sinks.push_back(std::make_unique<ConsoleSink>());
+    s_instance->sinks.back()->SetLevels(console_levels);
+    s_instance->thread = std::thread([backend = s_instance]() { Drain(*backend); });
 }
 
 void Logger::Destroy()
 {
     if (s_instance)
     {
-        delete s_instance;
-        s_instance = nullptr;
+        Backend* backend = std::exchange(s_instance, nullptr);
+        backend->stop.store(true, std::memory_order_release);
+        backend->wake.notify_one();
+        backend->thread.join();
+        delete backend;
     }
 }
 
@@ -25,20 +213,36 @@ void Logger::SetFilter(LogLevelFlag filter)
     s_Filter = filter;
 }
 
-void Logger::LogF(
-    LogLevelFlag level,
-    std::string_view file,
-    std::string_view function,
-    int line,
-    std::string_view fmt, std::format_args args)
+void Logger::AddSink(std::unique_ptr<LogSink> sink)
+{
+    if (!s_instance)
+    {
+        return;
+    }
+    std::lock_guard lock(s_instance->sinks_mutex);
+    s_instance->sinks.push_back(std::move(sink));
+}
+
+void Logger::Push(LogRecord& record)
 {
-    if (ShouldLog(level))
+    Backend& backend = *s_instance;
+    record.time = Elapsed(backend);
+    record.thread = s_thread;
+
+    while (!backend.queue.TryPush(record))
+    {
+        if (backend.overflow == LogOverflow::Drop && !(record.site->level & LogLevelFlagBits::Error))
+        {
+            backend.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        backend.wake.notify_one();
+        std::this_thread::yield();
+    }
+
+    if (backend.sleeping.load(std::memory_order_seq_cst))
     {
-        std::cout << std::format(
-            "󱞩[ {}:{} ({}) ] {}\n",
-            file, line, function,
-            std::vformat(fmt, args)
-        );
+        backend.wake.notify_one();
     }
 }
 
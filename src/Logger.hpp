@@ -1,6 +1,11 @@
 #pragma once
+#include <memory>
 #include <format>
+#include <string_view>
 #include "Types.hpp"
+#include "LogEncoding.hpp"
+
+class LogSink;
 
 struct LogLevel
 {
@@ -16,35 +21,72 @@ struct LogLevelFlagBits
     static constexpr LogLevelFlag All  { BIT(5) - 1};
 };
 
+enum class LogOverflow
+{
+    // Records that do not fit are counted and dropped, errors still wait
+    Drop,
+    // Callers wait for the logger thread to make room
+    Block
+};
+
+// Everything about a log statement known at compile time, one static
+// instance per SO_LOG
+struct LogSite
+{
+    LogLevelFlag     level;
+    std::string_view file;
+    std::string_view function;
+    int              line;
+    std::string_view format;
+};
+
+struct LogRecord
+{
+    LogSite const* site{ nullptr };
+    uint64_t       time{ 0 };   // nanoseconds since Logger::Initialize
+    uint32_t       thread{ 0 }; // in order of the first log call
+    LogArgBuffer   args;
+    std::string    message;     // filled by the logger thread for text sinks
+};
+
+// Call sites only encode their arguments and queue them without locks, a
+// background thread formats them for the sinks that want text. Initialize
+// adds a console sink. Destroy writes out everything still queued, call it
+// once no other thread logs anymore.
 class Logger
 {
 public:
-    static void Initialize();
+    // Levels outside `console_levels` only reach the sinks added later
+    static void Initialize(
+        LogOverflow overflow = LogOverflow::Drop,
+        LogLevelFlag console_levels = LogLevelFlagBits::All);
     static void Destroy();
     static void SetFilter(LogLevelFlag filter);
-
-    static void LogF(
-        LogLevelFlag level,
-        std::string_view file,
-        std::string_view function,
-        int line,
-        std::string_view fmt, std::format_args args);
+    static void AddSink(std::unique_ptr<LogSink> sink);
 
     template<typename... Args>
-    static void Log(
-        LogLevelFlag level,
-        std::string_view file,
-        std::string_view function,
-        int line,
-        std::format_string<Args...> fmt, Args&&... args)
+    static void Log(LogSite const& site, std::format_string<Args...>, Args&&... args)
     {
-        LogF(level, file, function, line, fmt.get(), std::make_format_args(args...));
+        if (!ShouldLog(site.level))
+        {
+            return;
+        }
+        LogRecord record{ .site = &site };
+        (EncodeLogArg(record.args, args), ...);
+        Push(record);
     }
 private:
     static auto ShouldLog(LogLevelFlag level) -> bool;
+    static void Push(LogRecord& record);
 };
 
-#define SO_LOG(level, ...) Logger::Log(level, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+// The format string is still checked against the arguments at compile time
+#define SO_LOG(level, fmt, ...) \
+    do \
+    { \
+        static LogSite const so_log_site{ level, __FILE__, __FUNCTION__, __LINE__, fmt }; \
+        Logger::Log(so_log_site, fmt __VA_OPT__(,) __VA_ARGS__); \
+    } while (false)
 #define SO_INFO(...)  SO_LOG(LogLevelFlagBits::Info,  __VA_ARGS__)
 #define SO_WARN(...) SO_LOG(LogLevelFlagBits::Warn,  __VA_ARGS__)
 #define SO_ERROR(...) SO_LOG(LogLevelFlagBits::Error, __VA_ARGS__)
\ No newline at end of file
@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "LuaAllocator.hpp"
+#include "Logger.hpp"
+
+namespace {
+    auto AlignUp(size_t size, size_t alignment) -> size_t
+    {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    auto Panic(lua_State* L) -> int
+    {
+        SO_ERROR("Lua panic: {}", lua_tostring(L, -1));
+        return 0;
+    }
+}
+
+LuaAllocator::LuaAllocator(std::string name, LuaAllocatorMode mode)
+    : m_name(std::move(name))
+    , m_mode(mode)
+{
+}
+
+LuaAllocator::~LuaAllocator()
+{
+    for (uint8_t* chunk : m_chunks)
+    {
+        std::free(chunk);
+    }
+}
+
+auto LuaAllocator::NewState() -> lua_State*
+{
+    lua_State* L = lua_newstate(Alloc, this);
+    if (L)
+    {
+        lua_atpanic(L, Panic);
+    }
+    return L;
+}
+
+void LuaAllocator::UpdateRate()
+{
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - m_rate_time).count();
+    if (seconds <= 0.0)
+    {
+        return;
+    }
+    m_stats.allocation_rate = static_cast<double>(m_stats.allocated_bytes - m_rate_bytes) / seconds;
+    m_rate_bytes = m_stats.allocated_bytes;
+    m_rate_time = now;
+}
+
+void LuaAllocator::LogStats() const
+{
+    SO_INFO("Lua memory {}: {} KB live, {} KB peak, {} KB reserved, {} allocations, {:.1f} KB/s",
+        m_name,
+        m_stats.live_bytes >> 10,
+        m_stats.peak_bytes >> 10,
+        m_stats.reserved_bytes >> 10,
+        m_stats.allocations,
+        m_stats.allocation_rate / 1024.0);
+}
+
+auto LuaAllocator::Alloc(void* ud, void* ptr, size_t osize, size_t nsize) -> void*
+{
+    auto* self = static_cast<LuaAllocator*>(ud);
+    LuaMemoryStats& stats = self->m_stats;
+
+    if (nsize == 0)
+    {
+        if (ptr)
+        {
+            self->Free(ptr, osize);
+            stats.live_bytes -= osize;
+        }
+        return nullptr;
+    }
+
+    // Without a block osize is the object type, not a size
+    size_t old_size = ptr ? osize : 0;
+    void* block = ptr ? self->Reallocate(ptr, osize, nsize) : self->Allocate(nsize);
+    if (!block)
+    {
+        return nullptr;
+    }
+
+    stats.live_bytes = stats.live_bytes - old_size + nsize;
+    stats.peak_bytes = std::max(stats.peak_bytes, stats.live_bytes);
+    if (nsize > old_size)
+    {
+        ++stats.allocations;
+        stats.allocated_bytes += nsize - old_size;
+    }
+    return block;
+}
+
+auto LuaAllocator::SizeClass(size_t size) -> size_t
+{
+    for (size_t i{ 0 }; i < s_class_count; ++i)
+    {
+        if (size <= s_class_sizes[i])
+        {
+            return i;
+        }
+    }
+    return s_class_count;
+}
+
+auto LuaAllocator::Allocate(size_t size) -> void*
+{
+    if (m_mode == LuaAllocatorMode::Arena)
+    {
+        return ArenaAllocate(size);
+    }
+
+    size_t size_class = SizeClass(size);
+    if (size_class == s_class_count)
+    {
+        void* block = std::malloc(size);
+        if (block)
+        {
+            m_stats.reserved_bytes += size;
+        }
+        return block;
+    }
+
+    FreeBlock*& free_list = m_free_lists[size_class];
+    if (!free_list)
+    {
+        // Carve a fresh chunk into blocks of this class
+        uint8_t* chunk = NewChunk(s_chunk_size);
+        if (!chunk)
+        {
+            return nullptr;
+        }
+        size_t block_size = s_class_sizes[size_class];
+        for (size_t offset = s_chunk_size - s_chunk_size % block_size; offset >= block_size; offset -= block_size)
+        {
+            auto* block = reinterpret_cast<FreeBlock*>(chunk + offset - block_size);
+            block->next = free_list;
+            free_list = block;
+        }
+    }
+
+    FreeBlock* block = free_list;
+    free_list = block->next;
+    return block;
+}
+
+void LuaAllocator::Free(void* ptr, size_t size)
+{
+    if (m_mode == LuaAllocatorMode::Arena)
+    {
+        if (ptr == m_arena_last)
+        {
+            m_arena_cursor = m_arena_last;
+            m_arena_last = nullptr;
+        }
+        return;
+    }
+
+    size_t size_class = SizeClass(size);
+    if (size_class == s_class_count)
+    {
+        std::free(ptr);
+        m_stats.reserved_bytes -= size;
+        return;
+    }
+
+    auto* block = static_cast<FreeBlock*>(ptr);
+    block->next = m_free_lists[size_class];
+    m_free_lists[size_class] = block;
+}
+
+auto LuaAllocator::Reallocate(void* ptr, size_t osize, size_t nsize) -> void*
+{
+    if (m_mode == LuaAllocatorMode::Arena)
+    {
+        auto* last = static_cast<uint8_t*>(ptr);
+        if (last == m_arena_last && last + AlignUp(nsize, s_alignment) <= m_arena_end)
+        {
+            m_arena_cursor = last + AlignUp(nsize, s_alignment);
+            return ptr;
+        }
+    }
+    else
+    {
+        size_t old_class = SizeClass(osize);
+        size_t new_class = SizeClass(nsize);
+        if (old_class == new_class && old_class != s_class_count)
+        {
+            return ptr;
+        }
+        if (old_class == s_class_count && new_class == s_class_count)
+        {
+            void* block = std::realloc(ptr, nsize);
+            if (block)
+            {
+                m_stats.reserved_bytes = m_stats.reserved_bytes - osize + nsize;
+            }
+            return block;
+        }
+    }
+
+    void* block = Allocate(nsize);
+    if (!block)
+    {
+        return nullptr;
+    }
+    std::memcpy(block, ptr, std::min(osize, nsize));
+    Free(ptr, osize);
+    return block;
+}
+
+auto LuaAllocator::NewChunk(size_t size) -> uint8_t*
+{
+    auto* chunk = static_cast<uint8_t*>(std::malloc(size));
+    if (chunk)
+    {
+        m_chunks.push_back(chunk);
+        m_stats.reserved_bytes += size;
+    }
+    return chunk;
+}
+
+auto LuaAllocator::ArenaAllocate(size_t size) -> void*
+{
+    size = AlignUp(size, s_alignment);
+    if (!m_arena_cursor || m_arena_cursor + size > m_arena_end)
+    {
+        // Oversized blocks get a chunk of their own
+        size_t chunk_size = std::max(size, s_chunk_size);
+        uint8_t* chunk = NewChunk(chunk_size);
+        if (!chunk)
+        {
+            return nullptr;
+        }
+        m_arena_cursor = chunk;
+        m_arena_end = chunk + chunk_size;
+    }
+
+    m_arena_last = m_arena_cursor;
+    m_arena_cursor += size;
+    return m_arena_last;
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <lua.hpp>
+
+struct LuaMemoryStats
+{
+    size_t   live_bytes{ 0 };      // as seen by Lua
+    size_t   peak_bytes{ 0 };
+    size_t   reserved_bytes{ 0 };  // taken from the system: chunks and large blocks
+    uint64_t allocations{ 0 };
+    uint64_t allocated_bytes{ 0 }; // running total
+    double   allocation_rate{ 0.0 }; // bytes per second between UpdateRate calls
+};
+
+enum class LuaAllocatorMode
+{
+    // Size-class free lists for small blocks, malloc for the rest
+    Pooled,
+    // Bump allocation, individual frees are dropped and everything is
+    // returned at once when the allocator goes away. For short lived
+    // states such as config parsing.
+    Arena
+};
+
+// lua_Alloc for one state, owns all memory of states created by NewState
+// and must outlive them. Not thread safe, neither is the state.
+class LuaAllocator
+{
+public:
+    explicit LuaAllocator(std::string name, LuaAllocatorMode mode = LuaAllocatorMode::Pooled);
+    ~LuaAllocator();
+    LuaAllocator(LuaAllocator const&) = delete;
+    auto operator = (LuaAllocator const&) -> LuaAllocator& = delete;
+
+    [[nodiscard]] auto NewState() -> lua_State*;
+
+    void UpdateRate();
+    [[nodiscard]] auto GetStats() const -> LuaMemoryStats const& { return m_stats; }
+    void LogStats() const;
+
+    static auto Alloc(void* ud, void* ptr, size_t osize, size_t nsize) -> void*;
+private:
+    static constexpr size_t s_class_count{ 8 };
+    static constexpr std::array<size_t, s_class_count> s_class_sizes{ 16, 32, 48, 64, 96, 128, 192, 256 };
+    static constexpr size_t s_chunk_size{ 64 * 1024 };
+    static constexpr size_t s_alignment{ 16 };
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    [[nodiscard]] static auto SizeClass(size_t size) -> size_t;
+
+    auto Allocate(size_t size) -> void*;
+    void Free(void* ptr, size_t size);
+    auto Reallocate(void* ptr, size_t osize, size_t nsize) -> void*;
+    auto NewChunk(size_t size) -> uint8_t*;
+    auto ArenaAllocate(size_t size) -> void*;
+private:
+    std::string                               m_name;
+    LuaAllocatorMode                          m_mode;
+    std::array<FreeBlock*, s_class_count>     m_free_lists{};
+    std::vector<uint8_t*>                     m_chunks;
+    // Arena cursor, the last block can still grow or shrink in place
+    uint8_t*                                  m_arena_cursor{ nullptr };
+    uint8_t*                                  m_arena_end{ nullptr };
+    uint8_t*                                  m_arena_last{ nullptr };
+
+    LuaMemoryStats                            m_stats;
+    uint64_t                                  m_rate_bytes{ 0 };
+    std::chrono::steady_clock::time_point     m_rate_time{ std::chrono::steady_clock::now() };
+};
\ No newline at end of file
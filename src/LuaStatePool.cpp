@@ -0,0 +1,113 @@
+#include <format>
+#include <algorithm>
+#include "LuaStatePool.hpp"
+#include "Logger.hpp"
+#include "Profiler.hpp"
+
+LuaStatePool::LuaStatePool(std::string const& name, size_t threads, LuaAllocatorMode mode, Setup setup)
+    : m_setup(std::move(setup))
+{
+    threads = std::max<size_t>(threads, 1);
+    m_workers.reserve(threads);
+    for (size_t i{ 0 }; i < threads; ++i)
+    {
+        auto worker = std::make_unique<Worker>();
+        worker->allocator = std::make_unique<LuaAllocator>(std::format("{} {}", name, i), mode);
+        m_workers.push_back(std::move(worker));
+    }
+    // Started once every worker exists, Run indexes m_workers
+    for (size_t i{ 0 }; i < threads; ++i)
+    {
+        m_workers[i]->thread = std::thread([this, i]() { Run(i); });
+    }
+}
+
+LuaStatePool::~LuaStatePool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers)
+    {
+        worker->thread.join();
+    }
+}
+
+auto LuaStatePool::GetMemoryStats(size_t worker) const -> LuaMemoryStats const&
+{
+    return m_workers[worker]->allocator->GetStats();
+}
+
+void LuaStatePool::UpdateRates()
+{
+    for (auto& worker : m_workers)
+    {
+        worker->allocator->UpdateRate();
+    }
+}
+
+void LuaStatePool::LogStats() const
+{
+    for (auto const& worker : m_workers)
+    {
+        worker->allocator->LogStats();
+    }
+}
+
+void LuaStatePool::Enqueue(size_t worker, Job job)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        if (worker == s_any_worker)
+        {
+            m_shared.push_back(std::move(job));
+        }
+        else
+        {
+            m_workers[worker]->inbox.push_back(std::move(job));
+        }
+    }
+    // A targeted job must reach its worker, not just any sleeper
+    if (worker == s_any_worker)
+    {
+        m_wake.notify_one();
+    }
+    else
+    {
+        m_wake.notify_all();
+    }
+}
+
+void LuaStatePool::Run(size_t index)
+{
+    Worker& worker = *m_workers[index];
+    SO_PROFILE_THREAD(std::format("lua {}", index));
+    lua_State* L = worker.allocator->NewState();
+    luaL_openlibs(L);
+    m_setup(L);
+
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this, &worker]()
+            {
+                return m_stop || !worker.inbox.empty() || !m_shared.empty();
+            });
+            // Own messages first, they may depend on state in this VM
+            std::deque<Job>& queue = !worker.inbox.empty() ? worker.inbox : m_shared;
+            if (queue.empty())
+            {
+                break; // stopping and drained
+            }
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        job(L);
+    }
+
+    lua_close(L);
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+#include <lua.hpp>
+#include "LuaAllocator.hpp"
+
+// Worker threads that each own an independent Lua state, prepared by the
+// same setup function (libs, preludes). Work is sent as messages: a job
+// receives the worker's state and hands its result back through a future.
+// Lua values never cross states, jobs capture and return plain C++ data.
+class LuaStatePool
+{
+public:
+    using Setup = std::function<void(lua_State*)>;
+
+    LuaStatePool(std::string const& name, size_t threads, LuaAllocatorMode mode, Setup setup);
+    ~LuaStatePool();
+    LuaStatePool(LuaStatePool const&) = delete;
+    auto operator = (LuaStatePool const&) -> LuaStatePool& = delete;
+
+    // Runs on whichever worker is free first
+    template <typename Fn>
+    auto Submit(Fn&& fn) -> std::future<std::invoke_result_t<Fn&, lua_State*>>
+    {
+        return Push(s_any_worker, std::forward<Fn>(fn));
+    }
+
+    // Runs on one worker, for state that lives in that VM (coroutines,
+    // loaded chunks). Jobs to the same worker run in submission order.
+    template <typename Fn>
+    auto SubmitTo(size_t worker, Fn&& fn) -> std::future<std::invoke_result_t<Fn&, lua_State*>>
+    {
+        return Push(worker % m_workers.size(), std::forward<Fn>(fn));
+    }
+
+    [[nodiscard]] auto Size() const -> size_t { return m_workers.size(); }
+    // Only while no job runs on the workers
+    [[nodiscard]] auto GetMemoryStats(size_t worker) const -> LuaMemoryStats const&;
+    void UpdateRates();
+    void LogStats() const;
+private:
+    using Job = std::function<void(lua_State*)>;
+    static constexpr size_t s_any_worker{ ~size_t{ 0 } };
+
+    struct Worker
+    {
+        std::unique_ptr<LuaAllocator> allocator;
+        std::deque<Job>               inbox;
+        std::thread                   thread;
+    };
+
+    template <typename Fn>
+    auto Push(size_t worker, Fn&& fn) -> std::future<std::invoke_result_t<Fn&, lua_State*>>
+    {
+        using Result = std::invoke_result_t<Fn&, lua_State*>;
+        // std::function needs a copyable target
+        auto task = std::make_shared<std::packaged_task<Result(lua_State*)>>(std::forward<Fn>(fn));
+        std::future<Result> future = task->get_future();
+        Enqueue(worker, [task](lua_State* L) { (*task)(L); });
+        return future;
+    }
+
+    void Enqueue(size_t worker, Job job);
+    void Run(size_t worker);
+private:
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::deque<Job>                      m_shared;
+    std::mutex                           m_mutex;
+    std::condition_variable              m_wake;
+    bool                                 m_stop{ false };
+    Setup                                m_setup;
+};
\ No newline at end of file
@@ -0,0 +1,213 @@
+#ifdef SO_PROFILE
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <utility>
+#include <algorithm>
+#include "Profiler.hpp"
+#include "Logger.hpp"
+
+namespace {
+    enum class EventType : uint8_t
+    {
+        Zone,
+        Counter,
+    };
+
+    struct Event
+    {
+        char const* name;
+        uint64_t    start;
+        uint64_t    end;
+        double      value;
+        EventType   type;
+    };
+
+    // Single writer ring, the owning thread. Readers copy a window and drop
+    // whatever the writer may have overwritten meanwhile.
+    struct ThreadBuffer
+    {
+        static constexpr uint64_t s_capacity{ 1 << 15 };
+
+        std::string                        name;
+        uint32_t                           id{ 0 };
+        std::array<Event, s_capacity>      events;
+        std::atomic<uint64_t>              head{ 0 };
+
+        void Push(Event const& event)
+        {
+            uint64_t index = head.load(std::memory_order_relaxed);
+            events[index & (s_capacity - 1)] = event;
+            head.store(index + 1, std::memory_order_release);
+        }
+
+        auto Snapshot() const -> std::vector<Event>
+        {
+            uint64_t end = head.load(std::memory_order_acquire);
+            uint64_t begin = end > s_capacity ? end - s_capacity : 0;
+            std::vector<Event> copy;
+            copy.reserve(end - begin);
+            for (uint64_t i{ begin }; i < end; ++i)
+            {
+                copy.push_back(events[i & (s_capacity - 1)]);
+            }
+
+            // The slot after head may be half written as well
+            uint64_t after = head.load(std::memory_order_acquire);
+            uint64_t valid = after + 1 > s_capacity ? after + 1 - s_capacity : 0;
+            if (valid > begin)
+            {
+                copy.erase(copy.begin(), copy.begin() + static_cast<ptrdiff_t>(std::min(valid - begin, end - begin)));
+            }
+            return copy;
+        }
+    };
+
+    std::mutex s_buffers_mutex;
+    // Never freed, threads that exited still show up in traces
+    std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+
+    thread_local ThreadBuffer* s_thread_buffer{ nullptr };
+
+    constexpr size_t s_frame_capacity{ 1024 };
+    std::array<uint64_t, s_frame_capacity> s_frame_starts{};
+    uint64_t s_frame_count{ 0 };
+
+    auto ThreadBufferOf() -> ThreadBuffer&
+    {
+        if (!s_thread_buffer)
+        {
+            std::lock_guard lock(s_buffers_mutex);
+            auto buffer = std::make_unique<ThreadBuffer>();
+            buffer->id = static_cast<uint32_t>(s_buffers.size());
+            buffer->name = std::format("thread {}", buffer->id);
+            s_thread_buffer = buffer.get();
+            s_buffers.push_back(std::move(buffer));
+        }
+        return *s_thread_buffer;
+    }
+
+    auto Escape(std::string_view text) -> std::string
+    {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+}
+
+void Profiler::SetThreadName(std::string name)
+{
+    ThreadBuffer& buffer = ThreadBufferOf();
+    std::lock_guard lock(s_buffers_mutex);
+    buffer.name = std::move(name);
+}
+
+void Profiler::Frame()
+{
+    uint64_t now = Now();
+    if (s_frame_count > 0)
+    {
+        uint64_t last = s_frame_starts[(s_frame_count - 1) % s_frame_capacity];
+        Counter("frame_ms", static_cast<double>(now - last) / 1e6);
+    }
+    s_frame_starts[s_frame_count % s_frame_capacity] = now;
+    ++s_frame_count;
+}
+
+void Profiler::Counter(char const* name, double value)
+{
+    uint64_t now = Now();
+    ThreadBufferOf().Push({ .name = name, .start = now, .end = now, .value = value, .type = EventType::Counter });
+}
+
+auto Profiler::Now() -> uint64_t
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::Zone(char const* name, uint64_t start, uint64_t end)
+{
+    ThreadBufferOf().Push({ .name = name, .start = start, .end = end, .value = 0.0, .type = EventType::Zone });
+}
+
+auto Profiler::WriteTrace(std::filesystem::path const& path, uint32_t frames) -> bool
+{
+    uint64_t window_end = Now();
+    uint64_t available = std::min<uint64_t>(s_frame_count, s_frame_capacity);
+    frames = static_cast<uint32_t>(std::min<uint64_t>(std::max<uint32_t>(frames, 1), available));
+    uint64_t first_frame = s_frame_count - frames;
+    uint64_t window_start = frames > 0 ? s_frame_starts[first_frame % s_frame_capacity] : 0;
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+    {
+        SO_ERROR("Failed to write trace: {}", path.string());
+        return false;
+    }
+
+    // Microseconds relative to the window, Chrome wants small numbers
+    auto us = [window_start](uint64_t ns) { return static_cast<double>(ns - window_start) / 1000.0; };
+    bool first = true;
+    auto separator = [&first]() { return std::exchange(first, false) ? "\n" : ",\n"; };
+
+    file << "{\"traceEvents\":[";
+    size_t event_count{ 0 };
+    {
+        std::lock_guard lock(s_buffers_mutex);
+        for (auto const& buffer : s_buffers)
+        {
+            file << separator() << std::format(
+                R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})",
+                buffer->id, Escape(buffer->name));
+
+            for (Event const& event : buffer->Snapshot())
+            {
+                if (event.end < window_start || event.start > window_end)
+                {
+                    continue;
+                }
+                ++event_count;
+                if (event.type == EventType::Zone)
+                {
+                    file << separator() << std::format(
+                        R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                        Escape(event.name), buffer->id, us(std::max(event.start, window_start)),
+                        static_cast<double>(event.end - std::max(event.start, window_start)) / 1000.0);
+                }
+                else
+                {
+                    file << separator() << std::format(
+                        R"({{"name":"{}","ph":"C","pid":1,"tid":{},"ts":{:.3f},"args":{{"value":{}}}}})",
+                        Escape(event.name), buffer->id, us(event.start), event.value);
+                }
+            }
+        }
+    }
+    for (uint64_t frame{ first_frame }; frame < s_frame_count; ++frame)
+    {
+        file << separator() << std::format(
+            R"({{"name":"Frame {}","ph":"i","s":"g","pid":1,"tid":0,"ts":{:.3f}}})",
+            frame, us(s_frame_starts[frame % s_frame_capacity]));
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    SO_INFO("Trace written: {} ({} frames, {} events)", path.string(), frames, event_count);
+    return static_cast<bool>(file);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <filesystem>
+
+// CPU frame profiler. Zones and counters go to a ring buffer owned by the
+// recording thread, written without locks and read back when a trace is
+// dumped. Names must be string literals, only the pointer is stored.
+// Use the SO_PROFILE_* macros below, they compile to nothing unless
+// SO_PROFILE is defined (every build but release).
+class Profiler
+{
+public:
+    static void SetThreadName(std::string name);
+    // Marks the start of a frame, main thread only
+    static void Frame();
+    static void Counter(char const* name, double value);
+    // The last `frames` frames as Chrome / Perfetto trace JSON, main thread only
+    static auto WriteTrace(std::filesystem::path const& path, uint32_t frames) -> bool;
+
+    [[nodiscard]] static auto Now() -> uint64_t; // ns
+    static void Zone(char const* name, uint64_t start, uint64_t end);
+};
+
+class ProfileZone
+{
+public:
+    explicit ProfileZone(char const* name)
+        : m_name(name)
+        , m_start(Profiler::Now())
+    {
+    }
+
+    ~ProfileZone()
+    {
+        Profiler::Zone(m_name, m_start, Profiler::Now());
+    }
+
+    ProfileZone(ProfileZone const&) = delete;
+    auto operator = (ProfileZone const&) -> ProfileZone& = delete;
+private:
+    char const* m_name;
+    uint64_t    m_start;
+};
+
+#ifdef SO_PROFILE
+#define SO_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SO_PROFILE_CONCAT(a, b) SO_PROFILE_CONCAT_IMPL(a, b)
+#define SO_PROFILE_ZONE(name) ProfileZone SO_PROFILE_CONCAT(so_profile_zone_, __LINE__){ name }
+#define SO_PROFILE_FUNCTION() SO_PROFILE_ZONE(__FUNCTION__)
+#define SO_PROFILE_FRAME() Profiler::Frame()
+#define SO_PROFILE_COUNTER(name, value) Profiler::Counter(name, static_cast<double>(value))
+#define SO_PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#define SO_PROFILE_WRITE_TRACE(path, frames) Profiler::WriteTrace(path, frames)
+#else
+#define SO_PROFILE_ZONE(name) ((void)0)
+#define SO_PROFILE_FUNCTION() ((void)0)
+#define SO_PROFILE_FRAME() ((void)0)
+#define SO_PROFILE_COUNTER(name, value) ((void)0)
+#define SO_PROFILE_THREAD(name) ((void)0)
+#define SO_PROFILE_WRITE_TRACE(path, frames) ((void)0)
+#endif
\ No newline at end of file
@@ -0,0 +1,650 @@
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include "Renderer.hpp"
+#include "Logger.hpp"
+#include "Profiler.hpp"
+
+namespace {
+    // [numthreads] of cull.slang
+    constexpr uint32_t s_cull_group_size{ 64 };
+    // How late an idle render thread notices a frame completing
+    constexpr auto     s_fence_poll{ std::chrono::microseconds(250) };
+
+    // Compute uniform slot 0 of cull.slang
+    struct CullConstants
+    {
+        std::array<glm::vec4, 6> planes;
+        uint32_t                 instance_count;
+        uint32_t                 padding[3];
+    };
+}
+
+void FramePacket::Clear()
+{
+    frame = 0;
+    input_ns = 0;
+    render_scale = 1.0f;
+    pipeline = nullptr;
+    constants.clear();
+    objects.clear();
+    bindings.clear();
+    meshes.clear();
+    uploads.clear();
+    dispatches.clear();
+    dispatch_buffers.clear();
+    dispatch_rw_buffers.clear();
+    dispatch_constants.clear();
+    cull_pipeline = nullptr;
+    cull_planes = {};
+    instances.clear();
+    batches.clear();
+    skinned_pipeline = nullptr;
+    skinned_meshes.clear();
+    skins.clear();
+    palettes.clear();
+}
+
+Renderer::Renderer(SDL_GPUDevice* device, SDL_Window* window, Texture offscreen, bool threaded)
+    : m_device(device)
+    , m_window(window)
+    , m_offscreen(offscreen)
+    , m_format(window ? SDL_GetGPUSwapchainTextureFormat(device, window) : s_offscreen_format)
+{
+    if (threaded)
+    {
+        m_thread = std::thread([this]() { Loop(); });
+    }
+}
+
+Renderer::~Renderer()
+{
+    WaitIdle();
+    if (m_thread.joinable())
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_changed.notify_all();
+        m_thread.join();
+    }
+    if (m_scaled.handle)
+    {
+        SDL_ReleaseGPUTexture(m_device, m_scaled.handle);
+    }
+    ReleaseCull();
+    ReleasePalettes();
+}
+
+auto Renderer::BeginPacket() -> FramePacket&
+{
+    SO_PROFILE_FUNCTION();
+    std::unique_lock lock(m_mutex);
+    m_changed.wait(lock, [this]() { return m_states[m_write] == SlotState::Free; });
+    FramePacket& packet = m_packets[m_write];
+    packet.Clear();
+    return packet;
+}
+
+void Renderer::SubmitPacket()
+{
+    if (!m_thread.joinable())
+    {
+        Render(m_packets[m_write]);
+        return;
+    }
+    {
+        std::lock_guard lock(m_mutex);
+        m_states[m_write] = SlotState::Ready;
+    }
+    m_changed.notify_all();
+    m_write ^= 1;
+}
+
+void Renderer::WaitIdle()
+{
+    if (!m_thread.joinable())
+    {
+        while (RetireFrame(true))
+        {
+        }
+        return;
+    }
+    std::unique_lock lock(m_mutex);
+    m_changed.wait(lock, [this]()
+    {
+        return m_states[0] == SlotState::Free && m_states[1] == SlotState::Free && m_pending_fences == 0;
+    });
+}
+
+void Renderer::Loop()
+{
+    SO_PROFILE_THREAD("render");
+    while (true)
+    {
+        bool ready{ false };
+        {
+            std::unique_lock lock(m_mutex);
+            auto has_work = [this]() { return m_stop || m_states[m_read] == SlotState::Ready; };
+            // Frames in flight are polled while waiting, so completion and
+            // GPU time are seen soon after the fence signals
+            if (m_pending_fences > 0)
+            {
+                m_changed.wait_for(lock, s_fence_poll, has_work);
+            }
+            else
+            {
+                m_changed.wait(lock, has_work);
+            }
+            ready = m_states[m_read] == SlotState::Ready;
+            if (ready)
+            {
+                m_states[m_read] = SlotState::Rendering;
+            }
+        }
+
+        if (!ready && m_stop)
+        {
+            // Stopping, nothing left but frames still on the GPU
+            while (RetireFrame(true))
+            {
+            }
+            return;
+        }
+
+        while (RetireFrame(false))
+        {
+        }
+        if (!ready)
+        {
+            continue;
+        }
+        Render(m_packets[m_read]);
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_states[m_read] = SlotState::Free;
+        }
+        m_changed.notify_all();
+        m_read ^= 1;
+    }
+}
+
+void Renderer::Render(FramePacket const& packet)
+{
+    SO_PROFILE_FUNCTION();
+    while (RetireFrame(false))
+    {
+    }
+    // The slot of this submission is reused, its frame has to complete
+    // first. Frames complete in order, so this retires the oldest.
+    while (m_in_flight[m_next_fence].fence && RetireFrame(true))
+    {
+    }
+
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer(m_device);
+    if (!cmd)
+    {
+        return;
+    }
+
+    // Indirect meshes draw nothing when the cull pass cannot run
+    bool indirect = packet.cull_pipeline != nullptr;
+    bool culled = indirect && !packet.instances.empty() && ReserveCull(packet);
+    bool skinned = packet.skinned_pipeline && !packet.skinned_meshes.empty() && ReservePalettes(packet);
+    if (!packet.uploads.empty() || culled || skinned)
+    {
+        SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(cmd);
+        for (auto const& upload : packet.uploads)
+        {
+            SDL_UploadToGPUBuffer(copy_pass, &upload.source, &upload.destination, false);
+        }
+        if (culled)
+        {
+            UploadCull(copy_pass, packet);
+        }
+        if (skinned)
+        {
+            UploadPalettes(copy_pass, packet);
+        }
+        SDL_EndGPUCopyPass(copy_pass);
+    }
+    RunDispatches(cmd, packet);
+    if (culled)
+    {
+        Cull(cmd, packet);
+    }
+
+    Texture target = AcquireTarget(cmd);
+    if (target.handle)
+    {
+        // Scaled frames render into a corner of the scaled target, the blit
+        // below stretches that over the target
+        Texture color = target;
+        float scale = std::clamp(packet.render_scale, 0.1f, 1.0f);
+        SDL_GPUTexture* scaled = scale < 1.0f ? GetScaledTarget(target.width, target.height) : nullptr;
+        if (scaled)
+        {
+            color = {
+                .handle = scaled,
+                .width = std::max(static_cast<uint32_t>(static_cast<float>(target.width) * scale), 1u),
+                .height = std::max(static_cast<uint32_t>(static_cast<float>(target.height) * scale), 1u),
+            };
+        }
+
+        SDL_GPUColorTargetInfo color_target{
+            .texture = color.handle,
+            .clear_color = packet.clear_color,
+            .load_op = SDL_GPU_LOADOP_CLEAR,
+            .store_op = SDL_GPU_STOREOP_STORE,
+            // Cleared anyway, the scaled target of a frame still in flight
+            // need not be waited for
+            .cycle = color.handle != target.handle,
+        };
+        SDL_GPURenderPass* pass = SDL_BeginGPURenderPass(cmd, &color_target, 1, nullptr);
+        SDL_GPUViewport viewport{
+            .x = 0, .y = 0,
+            .w = static_cast<float>(color.width), .h = static_cast<float>(color.height),
+            .min_depth = 0.0f, .max_depth = 1.0f,
+        };
+        SDL_SetGPUViewport(pass, &viewport);
+        SDL_Rect scissor{
+            .x = 0, .y = 0,
+            .w = static_cast<int>(color.width), .h = static_cast<int>(color.height),
+        };
+        SDL_SetGPUScissor(pass, &scissor);
+
+        if (packet.pipeline && indirect == culled)
+        {
+            SDL_BindGPUGraphicsPipeline(pass, packet.pipeline);
+            SDL_PushGPUVertexUniformData(cmd, 0, packet.constants.data(), static_cast<uint32_t>(packet.constants.size()));
+            if (culled)
+            {
+                SDL_GPUBuffer* storage[] = { m_cull.matrices, m_cull.visible };
+                SDL_BindGPUVertexStorageBuffers(pass, 0, storage, 2);
+            }
+
+            uint32_t bound_object = UINT32_MAX;
+            for (size_t i{ 0 }; i < packet.meshes.size(); ++i)
+            {
+                PacketMesh const& mesh = packet.meshes[i];
+                if (mesh.object != bound_object && culled)
+                {
+                    // Where the batch's visible instances start
+                    uint32_t draw[4]{ packet.batches[mesh.object].first_instance, 0, 0, 0 };
+                    SDL_PushGPUVertexUniformData(cmd, 1, draw, sizeof(draw));
+                }
+                else if (mesh.object != bound_object)
+                {
+                    SDL_PushGPUVertexUniformData(cmd, 1, &packet.objects[mesh.object], sizeof(glm::mat4));
+                }
+                bound_object = mesh.object;
+                SDL_BindGPUVertexBuffers(pass, 0, packet.bindings.data() + mesh.first_binding, mesh.binding_count);
+                SDL_BindGPUIndexBuffer(pass, &mesh.index, mesh.index_type);
+                if (culled)
+                {
+                    auto offset = static_cast<uint32_t>(i * sizeof(SDL_GPUIndexedIndirectDrawCommand));
+                    SDL_DrawGPUIndexedPrimitivesIndirect(pass, m_cull.commands, offset, 1);
+                }
+                else
+                {
+                    SDL_DrawGPUIndexedPrimitives(pass, mesh.index_count, 1, 0, 0, 0);
+                }
+            }
+        }
+        if (skinned)
+        {
+            SDL_BindGPUGraphicsPipeline(pass, packet.skinned_pipeline);
+            SDL_PushGPUVertexUniformData(cmd, 0, packet.constants.data(), static_cast<uint32_t>(packet.constants.size()));
+            SDL_BindGPUVertexStorageBuffers(pass, 0, &m_palettes.buffer, 1);
+
+            uint32_t bound_object = UINT32_MAX;
+            for (PacketMesh const& mesh : packet.skinned_meshes)
+            {
+                if (mesh.object != bound_object)
+                {
+                    SDL_PushGPUVertexUniformData(cmd, 1, &packet.skins[mesh.object], sizeof(PacketSkin));
+                    bound_object = mesh.object;
+                }
+                SDL_BindGPUVertexBuffers(pass, 0, packet.bindings.data() + mesh.first_binding, mesh.binding_count);
+                SDL_BindGPUIndexBuffer(pass, &mesh.index, mesh.index_type);
+                SDL_DrawGPUIndexedPrimitives(pass, mesh.index_count, 1, 0, 0, 0);
+            }
+        }
+        SDL_EndGPURenderPass(pass);
+
+        if (color.handle != target.handle)
+        {
+            SDL_GPUBlitInfo blit{
+                .source = { .texture = color.handle, .w = color.width, .h = color.height },
+                .destination = { .texture = target.handle, .w = target.width, .h = target.height },
+                .load_op = SDL_GPU_LOADOP_DONT_CARE,
+                .filter = SDL_GPU_FILTER_LINEAR,
+            };
+            SDL_BlitGPUTexture(cmd, &blit);
+        }
+    }
+
+    uint64_t submit_ns = SDL_GetTicksNS();
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmd);
+    if (!fence)
+    {
+        // Nothing to poll, completed once everything before it has
+        while (RetireFrame(true))
+        {
+        }
+        m_completed.store(packet.frame, std::memory_order_release);
+        return;
+    }
+    m_in_flight[m_next_fence] = {
+        .fence = fence,
+        .frame = packet.frame,
+        .submit_ns = submit_ns,
+        .input_ns = packet.input_ns,
+    };
+    m_next_fence = (m_next_fence + 1) % s_frames_in_flight;
+    std::lock_guard lock(m_mutex);
+    ++m_pending_fences;
+}
+
+auto Renderer::RetireFrame(bool wait) -> bool
+{
+    // Oldest first, from the slot submitted to next
+    InFlight* oldest{ nullptr };
+    for (size_t i{ 0 }; i < s_frames_in_flight && !oldest; ++i)
+    {
+        InFlight& frame = m_in_flight[(m_next_fence + i) % s_frames_in_flight];
+        oldest = frame.fence ? &frame : nullptr;
+    }
+    if (!oldest)
+    {
+        return false;
+    }
+    if (wait)
+    {
+        SO_PROFILE_ZONE("Wait for GPU");
+        SDL_WaitForGPUFences(m_device, true, &oldest->fence, 1);
+    }
+    else if (!SDL_QueryGPUFence(m_device, oldest->fence))
+    {
+        return false;
+    }
+    SDL_ReleaseGPUFence(m_device, oldest->fence);
+
+    // Until the frame before completed, this one only waited in the queue
+    uint64_t now_ns = SDL_GetTicksNS();
+    m_gpu_ns.store(now_ns - std::max(oldest->submit_ns, m_last_completion_ns), std::memory_order_relaxed);
+    m_last_completion_ns = now_ns;
+    m_completed.store(oldest->frame, std::memory_order_release);
+
+    {
+        std::lock_guard lock(m_mutex);
+        if (oldest->input_ns != 0)
+        {
+            double latency_ms = static_cast<double>(now_ns - oldest->input_ns) * 1e-6;
+            SO_PROFILE_COUNTER("input latency ms", latency_ms);
+            m_latency.frames += 1;
+            m_latency.total_ms += latency_ms;
+            m_latency.max_ms = std::max(m_latency.max_ms, latency_ms);
+        }
+        --m_pending_fences;
+    }
+    m_changed.notify_all();
+    *oldest = {};
+    return true;
+}
+
+void Renderer::RunDispatches(SDL_GPUCommandBuffer* cmd, FramePacket const& packet)
+{
+    for (auto const& dispatch : packet.dispatches)
+    {
+        SDL_GPUComputePass* pass = SDL_BeginGPUComputePass(
+            cmd, nullptr, 0,
+            packet.dispatch_rw_buffers.data() + dispatch.first_rw_buffer, dispatch.rw_buffer_count);
+        SDL_BindGPUComputePipeline(pass, dispatch.pipeline);
+        if (dispatch.buffer_count > 0)
+        {
+            SDL_BindGPUComputeStorageBuffers(pass, 0, packet.dispatch_buffers.data() + dispatch.first_buffer, dispatch.buffer_count);
+        }
+        if (dispatch.constants_size > 0)
+        {
+            SDL_PushGPUComputeUniformData(cmd, 0, packet.dispatch_constants.data() + dispatch.constants_offset, dispatch.constants_size);
+        }
+        SDL_DispatchGPUCompute(pass, dispatch.groups_x, dispatch.groups_y, dispatch.groups_z);
+        SDL_EndGPUComputePass(pass);
+    }
+}
+
+auto Renderer::ReserveCull(FramePacket const& packet) -> bool
+{
+    auto instances = static_cast<uint32_t>(packet.instances.size());
+    auto batches = static_cast<uint32_t>(packet.batches.size());
+    auto commands = static_cast<uint32_t>(packet.meshes.size());
+    if (m_cull.staging &&
+        instances <= m_cull.instance_capacity &&
+        batches <= m_cull.batch_capacity &&
+        commands <= m_cull.command_capacity)
+    {
+        return true;
+    }
+
+    // SDL keeps the old ones alive until frames in flight are done with them
+    ReleaseCull();
+    m_cull.instance_capacity = std::bit_ceil(std::max(instances, 256u));
+    m_cull.batch_capacity = std::bit_ceil(std::max(batches, 16u));
+    m_cull.command_capacity = std::bit_ceil(std::max(commands, 16u));
+
+    auto create = [this](SDL_GPUBufferUsageFlags usage, size_t size)
+    {
+        SDL_GPUBufferCreateInfo info{ .usage = usage, .size = static_cast<uint32_t>(size) };
+        return SDL_CreateGPUBuffer(m_device, &info);
+    };
+    size_t instance_bytes = m_cull.instance_capacity * sizeof(PacketInstance);
+    size_t batch_bytes = m_cull.batch_capacity * sizeof(PacketBatch);
+    size_t matrix_bytes = m_cull.instance_capacity * sizeof(glm::mat4);
+    size_t command_bytes = m_cull.command_capacity * sizeof(SDL_GPUIndexedIndirectDrawCommand);
+    m_cull.instances = create(SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ, instance_bytes);
+    m_cull.batches = create(SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ, batch_bytes);
+    m_cull.matrices = create(SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ, matrix_bytes);
+    m_cull.visible = create(SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+        m_cull.instance_capacity * sizeof(uint32_t));
+    m_cull.commands = create(
+        SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_INDIRECT,
+        command_bytes);
+    SDL_GPUTransferBufferCreateInfo staging_info{
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = static_cast<uint32_t>(instance_bytes + batch_bytes + matrix_bytes + command_bytes),
+    };
+    m_cull.staging = SDL_CreateGPUTransferBuffer(m_device, &staging_info);
+
+    if (!m_cull.instances || !m_cull.batches || !m_cull.matrices || !m_cull.visible || !m_cull.commands || !m_cull.staging)
+    {
+        SO_ERROR("Failed to create GPU culling buffers for {} instances, {}", instances, SDL_GetError());
+        ReleaseCull();
+        return false;
+    }
+    return true;
+}
+
+void Renderer::ReleaseCull()
+{
+    for (SDL_GPUBuffer* buffer : { m_cull.instances, m_cull.batches, m_cull.matrices, m_cull.visible, m_cull.commands })
+    {
+        if (buffer)
+        {
+            SDL_ReleaseGPUBuffer(m_device, buffer);
+        }
+    }
+    if (m_cull.staging)
+    {
+        SDL_ReleaseGPUTransferBuffer(m_device, m_cull.staging);
+    }
+    m_cull = {};
+}
+
+void Renderer::UploadCull(SDL_GPUCopyPass* copy_pass, FramePacket const& packet)
+{
+    SO_PROFILE_FUNCTION();
+    // Staging layout: instances, batches, matrices, commands. Buffers are
+    // cycled, frames in flight keep reading what they were given.
+    auto* staging = static_cast<std::byte*>(SDL_MapGPUTransferBuffer(m_device, m_cull.staging, true));
+    if (!staging)
+    {
+        return;
+    }
+    uint32_t offset{ 0 };
+    auto upload = [&](SDL_GPUBuffer* buffer, void const* data, size_t size)
+    {
+        std::memcpy(staging + offset, data, size);
+        SDL_GPUTransferBufferLocation source{ .transfer_buffer = m_cull.staging, .offset = offset };
+        SDL_GPUBufferRegion destination{ .buffer = buffer, .offset = 0, .size = static_cast<uint32_t>(size) };
+        SDL_UploadToGPUBuffer(copy_pass, &source, &destination, true);
+        offset += static_cast<uint32_t>(size);
+    };
+    upload(m_cull.instances, packet.instances.data(), packet.instances.size() * sizeof(PacketInstance));
+    upload(m_cull.batches, packet.batches.data(), packet.batches.size() * sizeof(PacketBatch));
+    upload(m_cull.matrices, packet.objects.data(), packet.objects.size() * sizeof(glm::mat4));
+
+    auto* commands = reinterpret_cast<SDL_GPUIndexedIndirectDrawCommand*>(staging + offset);
+    for (size_t i{ 0 }; i < packet.meshes.size(); ++i)
+    {
+        commands[i] = { .num_indices = packet.meshes[i].index_count, .num_instances = 0 };
+    }
+    SDL_GPUTransferBufferLocation source{ .transfer_buffer = m_cull.staging, .offset = offset };
+    SDL_GPUBufferRegion destination{
+        .buffer = m_cull.commands,
+        .offset = 0,
+        .size = static_cast<uint32_t>(packet.meshes.size() * sizeof(SDL_GPUIndexedIndirectDrawCommand)),
+    };
+    SDL_UploadToGPUBuffer(copy_pass, &source, &destination, true);
+    SDL_UnmapGPUTransferBuffer(m_device, m_cull.staging);
+}
+
+void Renderer::Cull(SDL_GPUCommandBuffer* cmd, FramePacket const& packet)
+{
+    SO_PROFILE_FUNCTION();
+    // The commands were just uploaded and are counted up, not cycled again.
+    // The visible list is rewritten whole.
+    SDL_GPUStorageBufferReadWriteBinding outputs[] = {
+        { .buffer = m_cull.visible, .cycle = true },
+        { .buffer = m_cull.commands, .cycle = false },
+    };
+    SDL_GPUComputePass* pass = SDL_BeginGPUComputePass(cmd, nullptr, 0, outputs, 2);
+    SDL_BindGPUComputePipeline(pass, packet.cull_pipeline);
+    SDL_GPUBuffer* inputs[] = { m_cull.instances, m_cull.batches };
+    SDL_BindGPUComputeStorageBuffers(pass, 0, inputs, 2);
+
+    CullConstants constants{
+        .planes = packet.cull_planes,
+        .instance_count = static_cast<uint32_t>(packet.instances.size()),
+    };
+    SDL_PushGPUComputeUniformData(cmd, 0, &constants, sizeof(constants));
+    SDL_DispatchGPUCompute(pass, (constants.instance_count + s_cull_group_size - 1) / s_cull_group_size, 1, 1);
+    SDL_EndGPUComputePass(pass);
+}
+
+auto Renderer::ReservePalettes(FramePacket const& packet) -> bool
+{
+    auto matrices = static_cast<uint32_t>(packet.palettes.size());
+    if (m_palettes.staging && matrices <= m_palettes.capacity)
+    {
+        return true;
+    }
+
+    // SDL keeps the old ones alive until frames in flight are done with them
+    ReleasePalettes();
+    m_palettes.capacity = std::bit_ceil(std::max(matrices, 256u));
+    auto bytes = static_cast<uint32_t>(m_palettes.capacity * sizeof(glm::mat4));
+    SDL_GPUBufferCreateInfo buffer_info{ .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ, .size = bytes };
+    m_palettes.buffer = SDL_CreateGPUBuffer(m_device, &buffer_info);
+    SDL_GPUTransferBufferCreateInfo staging_info{ .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD, .size = bytes };
+    m_palettes.staging = SDL_CreateGPUTransferBuffer(m_device, &staging_info);
+
+    if (!m_palettes.buffer || !m_palettes.staging)
+    {
+        SO_ERROR("Failed to create the palette buffer for {} joints, {}", matrices, SDL_GetError());
+        ReleasePalettes();
+        return false;
+    }
+    return true;
+}
+
+void Renderer::ReleasePalettes()
+{
+    if (m_palettes.buffer)
+    {
+        SDL_ReleaseGPUBuffer(m_device, m_palettes.buffer);
+    }
+    if (m_palettes.staging)
+    {
+        SDL_ReleaseGPUTransferBuffer(m_device, m_palettes.staging);
+    }
+    m_palettes = {};
+}
+
+void Renderer::UploadPalettes(SDL_GPUCopyPass* copy_pass, FramePacket const& packet)
+{
+    SO_PROFILE_FUNCTION();
+    // Cycled, frames in flight keep reading their own palettes
+    auto* staging = static_cast<std::byte*>(SDL_MapGPUTransferBuffer(m_device, m_palettes.staging, true));
+    if (!staging)
+    {
+        return;
+    }
+    auto size = static_cast<uint32_t>(packet.palettes.size() * sizeof(glm::mat4));
+    std::memcpy(staging, packet.palettes.data(), size);
+    SDL_UnmapGPUTransferBuffer(m_device, m_palettes.staging);
+
+    SDL_GPUTransferBufferLocation source{ .transfer_buffer = m_palettes.staging, .offset = 0 };
+    SDL_GPUBufferRegion destination{ .buffer = m_palettes.buffer, .offset = 0, .size = size };
+    SDL_UploadToGPUBuffer(copy_pass, &source, &destination, true);
+}
+
+auto Renderer::GetLatencyStats() -> LatencyStats
+{
+    std::lock_guard lock(m_mutex);
+    return m_latency;
+}
+
+auto Renderer::AcquireTarget(SDL_GPUCommandBuffer* cmd) -> Texture
+{
+    SO_PROFILE_FUNCTION();
+    if (!m_window)
+    {
+        return m_offscreen;
+    }
+    Texture texture{};
+    SDL_AcquireGPUSwapchainTexture(cmd, m_window, &texture.handle, &texture.width, &texture.height);
+    return texture;
+}
+
+auto Renderer::GetScaledTarget(uint32_t width, uint32_t height) -> SDL_GPUTexture*
+{
+    if (m_scaled.handle && m_scaled.width == width && m_scaled.height == height)
+    {
+        return m_scaled.handle;
+    }
+    // SDL keeps the old one alive until frames in flight are done with it
+    if (m_scaled.handle)
+    {
+        SDL_ReleaseGPUTexture(m_device, m_scaled.handle);
+    }
+    SDL_GPUTextureCreateInfo info{
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = m_format,
+        // Blit sources are sampled
+        .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+        .width = width,
+        .height = height,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+    };
+    m_scaled = {
+        .handle = SDL_CreateGPUTexture(m_device, &info),
+        .width = width,
+        .height = height,
+    };
+    return m_scaled.handle;
+}
\ No newline at end of file
@@ -0,0 +1,243 @@
+#pragma once
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <condition_variable>
+#include <glm/glm.hpp>
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+struct Texture
+{
+    SDL_GPUTexture* handle{ nullptr };
+    uint32_t        width{ 0 };
+    uint32_t        height{ 0 };
+};
+
+struct PacketMesh
+{
+    uint32_t                first_binding; // vertex buffers in FramePacket::bindings
+    uint32_t                binding_count;
+    SDL_GPUBufferBinding    index;
+    SDL_GPUIndexElementSize index_type;
+    uint32_t                index_count;
+    uint32_t                object;        // model matrix in FramePacket::objects, batch with GPU culling
+};
+
+struct PacketUpload
+{
+    SDL_GPUTransferBufferLocation source;
+    SDL_GPUBufferRegion           destination;
+};
+
+// Run in its own compute pass, so every dispatch sees the writes of the
+// ones before
+struct PacketDispatch
+{
+    SDL_GPUComputePipeline* pipeline;
+    uint32_t                first_buffer;     // readonly storage buffers in FramePacket::dispatch_buffers
+    uint32_t                buffer_count;
+    uint32_t                first_rw_buffer;  // in FramePacket::dispatch_rw_buffers
+    uint32_t                rw_buffer_count;
+    uint32_t                constants_offset; // compute uniform slot 0, in FramePacket::dispatch_constants
+    uint32_t                constants_size;
+    uint32_t                groups_x;
+    uint32_t                groups_y;
+    uint32_t                groups_z;
+};
+
+// Instances of one model under GPU culling. Its meshes are consecutive in
+// FramePacket::meshes and share the instances that survive culling.
+// Layout matches Batch in cull.slang.
+struct PacketBatch
+{
+    uint32_t first_mesh;
+    uint32_t mesh_count;
+    uint32_t first_instance; // in FramePacket::objects, also where its visible list starts
+    uint32_t padding;
+};
+
+// Layout matches Instance in cull.slang
+struct PacketInstance
+{
+    glm::vec4 bounds; // world space sphere
+    uint32_t  batch;
+    uint32_t  padding[3];
+};
+
+// Vertex uniform slot 1 of skinned meshes, layout matches SkinCB in
+// skinned_vertex.slang
+struct PacketSkin
+{
+    glm::mat4 model;
+    uint32_t  palette_base; // first joint matrix in FramePacket::palettes
+    uint32_t  padding[3];
+};
+
+// Everything the render thread needs for a frame, resolved to GPU objects
+// by the game thread. GPU objects referenced here are released no earlier
+// than the frame has completed (ResourceManager::ReleaseLater).
+struct FramePacket
+{
+    uint64_t                          frame{ 0 };        // ResourceManager frame it was built in
+    uint64_t                          input_ns{ 0 };     // oldest input it responds to, 0 without
+    float                             render_scale{ 1.0f }; // per axis, below 1 renders smaller and upscales
+    SDL_GPUGraphicsPipeline*          pipeline{ nullptr };
+    SDL_FColor                        clear_color{ 0.2f, 0.2f, 0.2f, 1.0f };
+    std::vector<std::byte>            constants;         // vertex uniform slot 0
+    std::vector<glm::mat4>            objects;           // vertex uniform slot 1, per draw
+    std::vector<SDL_GPUBufferBinding> bindings;
+    std::vector<PacketMesh>           meshes;
+    std::vector<PacketUpload>         uploads;           // copied before drawing
+    std::vector<PacketDispatch>       dispatches;        // run after the copies, in order
+    std::vector<SDL_GPUBuffer*>       dispatch_buffers;
+    std::vector<SDL_GPUStorageBufferReadWriteBinding> dispatch_rw_buffers;
+    std::vector<std::byte>            dispatch_constants;
+    // GPU culling when set. `objects` are per instance, meshes are drawn
+    // indirectly with what survived and `pipeline` reads the matrices from
+    // vertex storage buffers (instanced_vertex.slang).
+    SDL_GPUComputePipeline*           cull_pipeline{ nullptr };
+    std::array<glm::vec4, 6>          cull_planes{};     // as in Frustum, all zero passes everything
+    std::vector<PacketInstance>       instances;
+    std::vector<PacketBatch>          batches;
+    // Drawn after `meshes` with their own pipeline, not GPU culled. Their
+    // `object` is into `skins`, joint matrices are read from a vertex
+    // storage buffer (skinned_vertex.slang).
+    SDL_GPUGraphicsPipeline*          skinned_pipeline{ nullptr };
+    std::vector<PacketMesh>           skinned_meshes;
+    std::vector<PacketSkin>           skins;
+    std::vector<glm::mat4>            palettes;
+
+    // Keeps the capacity, packets are reused
+    void Clear();
+};
+
+// Input timestamp to the frame's completion on the GPU, right before it is
+// shown. Vsync adds up to one refresh on top.
+struct LatencyStats
+{
+    uint64_t frames{ 0 };
+    double   total_ms{ 0.0 };
+    double   max_ms{ 0.0 };
+};
+
+// Records and submits frame packets on its own thread while the game
+// thread builds the next one. Two packets alternate, so the game thread
+// runs at most one frame ahead, and up to s_frames_in_flight submitted
+// frames run on the GPU while the next one is recorded. Without a thread,
+// packets are rendered when submitted.
+class Renderer
+{
+public:
+    // Of the texture rendered to without a window
+    static constexpr SDL_GPUTextureFormat s_offscreen_format{ SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM };
+    static constexpr size_t               s_frames_in_flight{ 2 };
+
+    // `window` null renders into `offscreen`
+    Renderer(SDL_GPUDevice* device, SDL_Window* window, Texture offscreen, bool threaded);
+    // Renders what was submitted, then returns once the GPU is idle
+    ~Renderer();
+    Renderer(Renderer const&) = delete;
+    auto operator = (Renderer const&) -> Renderer& = delete;
+
+    // Game thread. Waits while the render thread still reads the packet.
+    [[nodiscard]] auto BeginPacket() -> FramePacket&;
+    void SubmitPacket();
+    // Blocks until every submitted packet completed on the GPU
+    void WaitIdle();
+
+    // Every packet up to this ResourceManager frame completed on the GPU
+    [[nodiscard]] auto CompletedFrame() const -> uint64_t { return m_completed.load(std::memory_order_acquire); }
+    [[nodiscard]] auto GetLatencyStats() -> LatencyStats;
+    // Submission, or completion of the frame before when it was queued
+    // behind it, to completion of the last completed packet. What
+    // resolution changes act on.
+    [[nodiscard]] auto GpuTimeMs() const -> float { return static_cast<float>(m_gpu_ns.load(std::memory_order_relaxed)) * 1e-6f; }
+private:
+    enum class SlotState
+    {
+        Free,
+        Ready,
+        Rendering
+    };
+
+    // A submitted frame, its fence is polled while the render thread idles
+    // and waited on only when its slot is reused
+    struct InFlight
+    {
+        SDL_GPUFence* fence{ nullptr };
+        uint64_t      frame{ 0 };
+        uint64_t      submit_ns{ 0 };
+        uint64_t      input_ns{ 0 };
+    };
+
+    // Persistent buffers of GPU culling, grown to the largest frame
+    struct CullBuffers
+    {
+        SDL_GPUBuffer*         instances{ nullptr };
+        SDL_GPUBuffer*         batches{ nullptr };
+        SDL_GPUBuffer*         matrices{ nullptr };
+        SDL_GPUBuffer*         visible{ nullptr };  // instance indices, each batch from its first_instance
+        SDL_GPUBuffer*         commands{ nullptr }; // one indexed indirect draw per mesh
+        SDL_GPUTransferBuffer* staging{ nullptr };
+        uint32_t               instance_capacity{ 0 };
+        uint32_t               batch_capacity{ 0 };
+        uint32_t               command_capacity{ 0 };
+    };
+
+    // Joint matrices of skinned meshes, grown to the largest frame
+    struct PaletteBuffer
+    {
+        SDL_GPUBuffer*         buffer{ nullptr };
+        SDL_GPUTransferBuffer* staging{ nullptr };
+        uint32_t               capacity{ 0 }; // matrices
+    };
+
+    void Loop();
+    void Render(FramePacket const& packet);
+    // Render thread. Retires the oldest submitted frame once its fence
+    // signalled, `wait` blocks until it does. False when none was retired.
+    auto RetireFrame(bool wait) -> bool;
+    void RunDispatches(SDL_GPUCommandBuffer* cmd, FramePacket const& packet);
+    // Render thread. False when the buffers could not be created.
+    auto ReserveCull(FramePacket const& packet) -> bool;
+    void ReleaseCull();
+    // Instances, batches and matrices plus the draw commands with no
+    // instances yet, for the cull pass to count up
+    void UploadCull(SDL_GPUCopyPass* copy_pass, FramePacket const& packet);
+    void Cull(SDL_GPUCommandBuffer* cmd, FramePacket const& packet);
+    // Render thread. False when the buffers could not be created.
+    auto ReservePalettes(FramePacket const& packet) -> bool;
+    void ReleasePalettes();
+    void UploadPalettes(SDL_GPUCopyPass* copy_pass, FramePacket const& packet);
+    auto AcquireTarget(SDL_GPUCommandBuffer* cmd) -> Texture;
+    // Render thread. Sized like the target, scaled frames use a corner.
+    auto GetScaledTarget(uint32_t width, uint32_t height) -> SDL_GPUTexture*;
+private:
+    SDL_GPUDevice*                m_device;
+    SDL_Window*                   m_window;
+    Texture                       m_offscreen;
+    SDL_GPUTextureFormat          m_format;
+    Texture                       m_scaled{};
+    CullBuffers                   m_cull{};
+    PaletteBuffer                 m_palettes{};
+    std::array<InFlight, s_frames_in_flight> m_in_flight{}; // render thread
+    size_t                        m_next_fence{ 0 };          // slot of the next submission
+    uint64_t                      m_last_completion_ns{ 0 };
+
+    std::array<FramePacket, 2>    m_packets;
+    std::array<SlotState, 2>      m_states{ SlotState::Free, SlotState::Free };
+    size_t                        m_write{ 0 }; // game thread
+    size_t                        m_read{ 0 };  // render thread
+    std::mutex                    m_mutex;
+    std::condition_variable       m_changed;
+    bool                          m_stop{ false };
+    uint32_t                      m_pending_fences{ 0 }; // under m_mutex
+    std::atomic<uint64_t>         m_completed{ 0 };
+    std::atomic<uint64_t>         m_gpu_ns{ 0 };
+    LatencyStats                  m_latency{};  // under m_mutex
+    std::thread                   m_thread;
+};
\ No newline at end of file
@@ -1,69 +1,207 @@
+#include <set>
+#include <algorithm>
+#include <cstring>
 #include "ResourceManager.hpp"
+#include "HotReload.hpp"
+#include "ConfigSnapshot.hpp"
+#include "GLTFHelper.hpp"
+#include "JobSystem.hpp"
+#include "LuaStatePool.hpp"
 #include "Logger.hpp"
+#include "Profiler.hpp"
 
 namespace {
     ResourceManager*       s_instance{ nullptr };
-    lua_State*             s_lua_state{ nullptr };
-    std::hash<std::string> s_hasher{};
+
+    // GPU buffers plus the staging copy while it is alive
+    auto ResidentBytes(ModelInfo const& model) -> uint64_t
+    {
+        if (!model.resident)
+        {
+            return 0;
+        }
+        return model.cpu_data.size() * (model.transfer_buffer ? 2 : 1);
+    }
 }
 
-void ResourceManager::Initialize(std::filesystem::path const& root, SDL_GPUDevice* device)
+void ResourceManager::Initialize(std::filesystem::path const& root, SDL_GPUDevice* device, JobSystem& jobs)
 {
+    SO_PROFILE_FUNCTION();
     if (s_instance)
     {
         return;
     }
     s_instance = new ResourceManager();
 
-    s_lua_state = luaL_newstate();
-    luaL_openlibs(s_lua_state);
-
     s_instance->m_root_dir = root;
     s_instance->m_device = device;
+    s_instance->m_shader_formats = SDL_GetGPUShaderFormats(device);
+    s_instance->m_jobs = &jobs;
+    s_instance->m_shader_cache = std::make_unique<ShaderCache>((root/".."/"build"/"shaders").lexically_normal());
 
-    std::filesystem::path prelude_files = root/"preludes";
-    for (auto& entry : std::filesystem::directory_iterator(prelude_files))
+    // Lua only runs when a script changed since the snapshot was written
+    std::filesystem::path snapshot_path = (root/".."/"build"/"config.bin").lexically_normal();
+    uint64_t input_hash = ConfigSnapshot::InputHash(root);
+    std::optional<ConfigSnapshot> config = ConfigSnapshot::Load(snapshot_path, input_hash);
+    if (config)
     {
-        std::filesystem::path path = entry.path();
-        if (path.extension().string() == ".lua")
+        SO_INFO("Config snapshot loaded: {}", snapshot_path.string());
+    }
+    else
+    {
+        config = s_instance->LoadConfig(root);
+        config->Save(snapshot_path, input_hash);
+    }
+    s_instance->ApplyConfig(*config);
+}
+
+auto ResourceManager::LoadConfig(std::filesystem::path const& root) -> ConfigSnapshot
+{
+    SO_PROFILE_FUNCTION();
+    // Sorted, so the snapshot does not depend on directory order
+    auto scripts = [](std::filesystem::path const& dir)
+    {
+        std::vector<std::filesystem::path> paths;
+        std::error_code error;
+        for (auto& entry : std::filesystem::directory_iterator(dir, error))
         {
-            if (luaL_dofile(s_lua_state, path.c_str()))
+            if (entry.path().extension().string() == ".lua")
             {
-                SO_ERROR("Error loading prelude: {}", lua_tostring(s_lua_state, -1));
-                lua_pop(s_lua_state, 1);
+                paths.push_back(entry.path());
             }
         }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    };
+    std::vector<std::filesystem::path> shader_scripts = scripts(root/"shaders");
+    std::vector<std::filesystem::path> pipeline_scripts = scripts(root/"pipelines");
+    std::vector<std::filesystem::path> model_scripts = scripts(root/"models");
+    // Optional, a config without compute pipelines has no such directory
+    std::vector<std::filesystem::path> compute_scripts = scripts(root/"compute");
+
+    // Scripts are independent and parsed in parallel. The states only live
+    // for parsing, their arenas drop everything at once.
+    size_t script_count = shader_scripts.size() + pipeline_scripts.size() + model_scripts.size() + compute_scripts.size() + 1;
+    size_t threads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), script_count);
+    LuaStatePool pool("config", threads, LuaAllocatorMode::Arena, [&root](lua_State* L)
+    {
+        lua_gc(L, LUA_GCSTOP);
+        LoadPreludes(L, root);
+    });
+
+    std::future<std::optional<EngineConfig>> engine_config;
+    if (std::filesystem::exists(root/"engine.lua"))
+    {
+        engine_config = pool.Submit([this, path = root/"engine.lua"](lua_State* L) { return LoadEngineConfig(L, path); });
+    }
+    std::vector<std::future<std::optional<ShaderInfo>>> shader_infos;
+    for (auto const& path : shader_scripts)
+    {
+        shader_infos.push_back(pool.Submit([this, path](lua_State* L) { return LoadShaderInfo(L, path); }));
+    }
+    std::vector<std::future<std::optional<PipelineInfo>>> pipeline_infos;
+    for (auto const& path : pipeline_scripts)
+    {
+        pipeline_infos.push_back(pool.Submit([this, path](lua_State* L) { return LoadPipelineInfo(L, path); }));
+    }
+    std::vector<std::future<std::optional<ComputePipelineInfo>>> compute_infos;
+    for (auto const& path : compute_scripts)
+    {
+        compute_infos.push_back(pool.Submit([this, path](lua_State* L) { return LoadComputePipelineInfo(L, path); }));
+    }
+    std::vector<std::future<std::optional<std::vector<ModelSource>>>> model_groups;
+    for (auto const& path : model_scripts)
+    {
+        model_groups.push_back(pool.Submit([this, path](lua_State* L) { return LoadModelGroupInfo(L, path); }));
     }
 
-    // Shaders - load shader scripts
-    std::filesystem::path shaders_dir = root/"shaders";
-    for (auto& entry : std::filesystem::directory_iterator(shaders_dir))
+    ConfigSnapshot config{};
+    if (engine_config.valid())
     {
-        std::filesystem::path path = entry.path();
-        if (path.extension().string() == ".lua")
+        config.engine = engine_config.get().value_or(EngineConfig{});
+    }
+    for (size_t i{ 0 }; i < shader_scripts.size(); ++i)
+    {
+        if (auto shader_info = shader_infos[i].get())
         {
-            s_instance->LoadShader(s_lua_state, path);
+            config.shaders.push_back({shader_scripts[i].stem().string(), std::move(*shader_info)});
         }
     }
-    
-    // Graphics Pipelines - load graphics pipeline scripts
-    std::filesystem::path pipelines_dir = root/"pipelines";
-    for (auto& entry : std::filesystem::directory_iterator(pipelines_dir))
+    for (size_t i{ 0 }; i < pipeline_scripts.size(); ++i)
     {
-        std::filesystem::path path = entry.path();
-        if (path.extension().string() == ".lua")
+        if (auto pipeline_info = pipeline_infos[i].get())
         {
-            s_instance->LoadPipeline(s_lua_state, path);
+            config.pipelines.push_back({pipeline_scripts[i].stem().string(), std::move(*pipeline_info)});
+        }
+    }
+    for (size_t i{ 0 }; i < compute_scripts.size(); ++i)
+    {
+        if (auto compute_info = compute_infos[i].get())
+        {
+            config.compute_pipelines.push_back({compute_scripts[i].stem().string(), std::move(*compute_info)});
+        }
+    }
+    for (auto& model_group : model_groups)
+    {
+        if (auto sources = model_group.get())
+        {
+            config.models.insert(config.models.end(), sources->begin(), sources->end());
         }
     }
 
-    std::filesystem::path models_dir = root/"models";
-    for (auto& entry : std::filesystem::directory_iterator(models_dir))
+    pool.LogStats();
+    return config;
+}
+
+void ResourceManager::ApplyConfig(ConfigSnapshot const& config)
+{
+    SO_PROFILE_FUNCTION();
+    m_engine_config = config.engine;
+    if (config.engine.model_budget > 0)
+    {
+        SetModelBudget(config.engine.model_budget);
+    }
+
+    // Every shader at once so dirty shaders compile together
+    CreateShaders(config.shaders);
+    m_shader_cache->LogStats();
+
+    for (auto const& [name, info] : config.pipelines)
+    {
+        CreatePipeline(name, info);
+    }
+    CreateComputePipelines(config.compute_pipelines);
+
+    // Parsing dominates, GPU side objects are created in order afterwards
+    std::vector<GLTFHelper> gltf_helpers(config.models.size());
+    m_jobs->ParallelFor(config.models.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t i{ begin }; i < end; ++i)
+        {
+            SO_PROFILE_ZONE("Parse glTF");
+            gltf_helpers[i].Load(config.models[i].path, config.models[i].clips);
+        }
+    });
+    for (size_t i{ 0 }; i < config.models.size(); ++i)
+    {
+        CreateModel(config.models[i].name, gltf_helpers[i]);
+        gltf_helpers[i].Clear();
+    }
+}
+
+void ResourceManager::LoadPreludes(lua_State* L, std::filesystem::path const& root)
+{
+    std::filesystem::path prelude_files = root/"preludes";
+    for (auto& entry : std::filesystem::directory_iterator(prelude_files))
     {
         std::filesystem::path path = entry.path();
         if (path.extension().string() == ".lua")
         {
-            s_instance->LoadModelGroup(s_lua_state, path);
+            if (luaL_dofile(L, path.c_str()))
+            {
+                SO_ERROR("Error loading prelude: {}", lua_tostring(L, -1));
+                lua_pop(L, 1);
+            }
         }
     }
 }
@@ -75,73 +213,732 @@ auto ResourceManager::Instance() -> ResourceManager&
 
 void ResourceManager::Destroy()
 {
-    for (auto& [_, shader] : s_instance->m_shaders)
+    if (!s_instance)
+    {
+        return;
+    }
+    s_instance->m_hot_reloader.reset();
+
+    // Everything goes, regardless of outstanding handles
+    SDL_WaitForGPUIdle(s_instance->m_device);
+    for (auto& pending : s_instance->m_pending_releases)
+    {
+        pending.release();
+    }
+    s_instance->m_shaders.ForEach([](ShaderHandle, ShaderSlot& shader)
     {
         SDL_ReleaseGPUShader(s_instance->m_device, shader.second);
+    });
+    s_instance->m_pipelines.ForEach([](PipelineHandle, PipelineSlot& pipeline)
+    {
+        SDL_ReleaseGPUGraphicsPipeline(s_instance->m_device, pipeline.second);
+    });
+    s_instance->m_compute_pipelines.ForEach([](ComputePipelineHandle, ComputePipelineSlot& pipeline)
+    {
+        SDL_ReleaseGPUComputePipeline(s_instance->m_device, pipeline.second);
+    });
+    s_instance->m_models.ForEach([](ModelHandle, ModelInfo& model)
+    {
+        s_instance->DestroyModel(model);
+    });
+
+    s_instance->m_root_dir.clear();
+    s_instance->m_pending_releases.clear();
+    s_instance->m_shaders.Clear();
+    s_instance->m_pipelines.Clear();
+    s_instance->m_compute_pipelines.Clear();
+    s_instance->m_models.Clear();
+    s_instance->m_device = nullptr;
+
+    delete s_instance;
+    s_instance = nullptr;
+}
+
+auto ResourceManager::CreateShaders(std::vector<PendingShader> const& shaders) -> uint32_t
+{
+    std::vector<std::filesystem::path> code_paths = CompileShaders(shaders);
+
+    // SDL_CreateGPUShader is kept on this thread
+    uint32_t created{ 0 };
+    for (size_t i{ 0 }; i < shaders.size(); ++i)
+    {
+        if (!code_paths[i].empty() && CreateShader(shaders[i], code_paths[i]))
+        {
+            ++created;
+        }
     }
+    return created;
+}
 
-    for (auto& [_, pipeline] : s_instance->m_pipelines)
+auto ResourceManager::CompileShaders(std::vector<PendingShader> const& shaders) -> std::vector<std::filesystem::path>
+{
+    SO_PROFILE_FUNCTION();
+    std::vector<std::filesystem::path> code_paths(shaders.size());
+    std::vector<ShaderCompileJob> jobs;
+    std::vector<size_t> job_shaders;
+    for (size_t i{ 0 }; i < shaders.size(); ++i)
     {
-        SDL_ReleaseGPUGraphicsPipeline(s_instance->m_device, pipeline);
+        ShaderInfo const& info = shaders[i].info;
+        if (info.is_byte_code)
+        {
+            code_paths[i] = info.source_path;
+            continue;
+        }
+
+        SlangcCompileOption option{
+            .input_file = info.source_path,
+            .entry_point = info.entry_point,
+            .stage = info.stage,
+            .compute = shaders[i].compute,
+            .format = CodeFormat(info),
+        };
+        std::filesystem::path entry = m_shader_cache->EntryPath(option, m_shader_cache->Key(option));
+        if (m_shader_cache->Contains(entry))
+        {
+            m_shader_cache->RecordHit();
+            code_paths[i] = entry;
+            continue;
+        }
+
+        m_shader_cache->RecordMiss();
+        jobs.push_back({ .option = option, .entry = entry });
+        job_shaders.push_back(i);
     }
 
-    if (s_instance)
+    m_shader_cache->CompileAll(jobs);
+    for (size_t i{ 0 }; i < jobs.size(); ++i)
     {
-        s_instance->m_root_dir.clear();
-        s_instance->m_shaders.clear();
-        s_instance->m_pipelines.clear();
-        s_instance->m_device = nullptr;
+        if (jobs[i].succeeded)
+        {
+            code_paths[job_shaders[i]] = jobs[i].entry;
+        }
+    }
+    return code_paths;
+}
+
+auto ResourceManager::ResolvePath(std::string const& path) const -> std::filesystem::path
+{
+    std::filesystem::path resolved{ path };
+    if (resolved.empty() || resolved.is_absolute())
+    {
+        return resolved;
+    }
+    return (std::filesystem::path(m_root_dir)/resolved).lexically_normal();
+}
+
+auto ResourceManager::CodeFormat(ShaderInfo const& info) const -> SDL_GPUShaderFormat
+{
+    if (info.is_byte_code || (info.format & m_shader_formats))
+    {
+        return info.format;
+    }
+    for (SDL_GPUShaderFormat format : { SDL_GPU_SHADERFORMAT_SPIRV, SDL_GPU_SHADERFORMAT_MSL })
+    {
+        if (format & m_shader_formats)
+        {
+            return format;
+        }
+    }
+    return info.format;
+}
+
+auto ResourceManager::CreateShader(PendingShader const& shader, std::filesystem::path const& code_path) -> bool
+{
+    ShaderInfo const& shader_info = shader.info;
+
+    std::size_t code_size{ 0 };
+    void* code = SDL_LoadFile(code_path.c_str(), &code_size);
+    if (!code)
+    {
+        SO_ERROR("Failed to read shader byte code, {}", SDL_GetError());
+        return false;
+    }
+
+    SDL_GPUShaderCreateInfo shader_create_info{
+        .code_size           = code_size,
+        .code                = static_cast<uint8_t*>(code),
+        .entrypoint          = shader_info.entry_point.c_str(),
+        .format              = CodeFormat(shader_info),
+        .stage               = shader_info.stage,
+        .num_samplers        = shader_info.num_samplers,
+        .num_storage_buffers = shader_info.num_storage_buffers,
+        .num_uniform_buffers = shader_info.num_uniform_buffers,
+    };
+    SDL_GPUShader* gpu_shader = SDL_CreateGPUShader(m_device, &shader_create_info);
+    SDL_free(code);
+    if (!gpu_shader)
+    {
+        SO_ERROR("Failed to create shader, {}", SDL_GetError());
+        return false;
+    }
 
-        delete s_instance;
-        lua_close(s_lua_state);
-        s_instance = nullptr;
-        s_lua_state = nullptr;
+    // Replaced in place, existing handles see the new shader
+    ResouceID id = Hash(shader.name);
+    ShaderSlot* slot = nullptr;
+    if (ShaderHandle const* handle = m_shader_names.Find(id))
+    {
+        slot = m_shaders.Get(*handle);
+    }
+    if (slot)
+    {
+        ReleaseLater([device = m_device, old = slot->second]() { SDL_ReleaseGPUShader(device, old); });
+        *slot = {shader_info, gpu_shader};
     }
+    else
+    {
+        m_shader_names.Assign(id, m_shaders.Insert({shader_info, gpu_shader}));
+    }
+    SO_INFO("Shader loaded: {}", shader.name);
+
+    return true;
 }
 
-auto ResourceManager::GetShader(std::string const& name) -> SDL_GPUShader*
+auto ResourceManager::CreatePipeline(std::string const& name, PipelineInfo info) -> bool
 {
-    return m_shaders[Hash(name)].second;
+    info.name = name;
+    SDL_GPUGraphicsPipelineCreateInfo& create_info = info.create_info;
+    create_info.vertex_shader = GetShader(info.vertex_shader);
+    if (!create_info.vertex_shader)
+    {
+        SO_ERROR("Vertex shader not found: {}", info.vertex_shader);
+        return false;
+    }
+    create_info.fragment_shader = GetShader(info.fragment_shader);
+    if (!create_info.fragment_shader)
+    {
+        SO_ERROR("Fragment shader not found: {}", info.fragment_shader);
+        return false;
+    }
+    create_info.vertex_input_state.vertex_buffer_descriptions = info.vertex_buffer_descriptions.data();
+    create_info.vertex_input_state.num_vertex_buffers = static_cast<uint32_t>(info.vertex_buffer_descriptions.size());
+    create_info.vertex_input_state.vertex_attributes = info.vertex_attributes.data();
+    create_info.vertex_input_state.num_vertex_attributes = static_cast<uint32_t>(info.vertex_attributes.size());
+    create_info.target_info.color_target_descriptions = info.color_target_descriptions.data();
+    create_info.target_info.num_color_targets = static_cast<uint32_t>(info.color_target_descriptions.size());
+
+    SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(m_device, &create_info);
+    if (!pipeline)
+    {
+        SO_ERROR("Failed to create graphics pipeline, {}", SDL_GetError());
+        return false;
+    }
+    ResouceID id = Hash(name);
+    PipelineSlot* slot = nullptr;
+    if (PipelineHandle const* handle = m_pipeline_names.Find(id))
+    {
+        slot = m_pipelines.Get(*handle);
+    }
+    if (slot)
+    {
+        ReleaseLater([device = m_device, old = slot->second]() { SDL_ReleaseGPUGraphicsPipeline(device, old); });
+        *slot = {std::move(info), pipeline};
+    }
+    else
+    {
+        m_pipeline_names.Assign(id, m_pipelines.Insert({std::move(info), pipeline}));
+    }
+    SO_INFO("Pipeline loaded: {}", name);
+
+    return true;
 }
 
-auto ResourceManager::GetPipeline(std::string const& name) -> SDL_GPUGraphicsPipeline*
+auto ResourceManager::CreateComputePipelines(std::vector<std::pair<std::string, ComputePipelineInfo>> const& pipelines) -> uint32_t
 {
-    return m_pipelines[Hash(name)];
+    std::vector<PendingShader> shaders;
+    for (auto const& [name, info] : pipelines)
+    {
+        shaders.push_back({ .name = name, .info = info.shader, .compute = true });
+    }
+    std::vector<std::filesystem::path> code_paths = CompileShaders(shaders);
+
+    uint32_t created{ 0 };
+    for (size_t i{ 0 }; i < pipelines.size(); ++i)
+    {
+        if (!code_paths[i].empty() && CreateComputePipeline(pipelines[i].first, pipelines[i].second, code_paths[i]))
+        {
+            ++created;
+        }
+    }
+    return created;
 }
 
-auto ResourceManager::GetModel(std::string const& name) -> ModelInfo const&
+auto ResourceManager::CreateComputePipeline(std::string const& name, ComputePipelineInfo info, std::filesystem::path const& code_path) -> bool
 {
-    return m_models[Hash(name)];
+    info.name = name;
+    ShaderInfo const& shader_info = info.shader;
+
+    std::size_t code_size{ 0 };
+    void* code = SDL_LoadFile(code_path.c_str(), &code_size);
+    if (!code)
+    {
+        SO_ERROR("Failed to read compute shader byte code, {}", SDL_GetError());
+        return false;
+    }
+
+    SDL_GPUComputePipelineCreateInfo create_info{
+        .code_size                      = code_size,
+        .code                           = static_cast<uint8_t*>(code),
+        .entrypoint                     = shader_info.entry_point.c_str(),
+        .format                         = CodeFormat(shader_info),
+        .num_samplers                   = shader_info.num_samplers,
+        .num_readonly_storage_textures  = info.num_readonly_storage_textures,
+        .num_readonly_storage_buffers   = shader_info.num_storage_buffers,
+        .num_readwrite_storage_textures = info.num_readwrite_storage_textures,
+        .num_readwrite_storage_buffers  = info.num_readwrite_storage_buffers,
+        .num_uniform_buffers            = shader_info.num_uniform_buffers,
+        .threadcount_x                  = info.threadcount_x,
+        .threadcount_y                  = info.threadcount_y,
+        .threadcount_z                  = info.threadcount_z,
+    };
+    SDL_GPUComputePipeline* pipeline = SDL_CreateGPUComputePipeline(m_device, &create_info);
+    SDL_free(code);
+    if (!pipeline)
+    {
+        SO_ERROR("Failed to create compute pipeline, {}", SDL_GetError());
+        return false;
+    }
+
+    ResouceID id = Hash(name);
+    ComputePipelineSlot* slot = nullptr;
+    if (ComputePipelineHandle const* handle = m_compute_pipeline_names.Find(id))
+    {
+        slot = m_compute_pipelines.Get(*handle);
+    }
+    if (slot)
+    {
+        ReleaseLater([device = m_device, old = slot->second]() { SDL_ReleaseGPUComputePipeline(device, old); });
+        *slot = {std::move(info), pipeline};
+    }
+    else
+    {
+        m_compute_pipeline_names.Assign(id, m_compute_pipelines.Insert({std::move(info), pipeline}));
+    }
+    SO_INFO("Compute pipeline loaded: {}", name);
+
+    return true;
 }
 
-void ResourceManager::SetModelStatus(std::string const& name, bool status)
+void ResourceManager::StoreModel(std::string const& name, ModelInfo model)
 {
-    m_models[Hash(name)].active = status;
+    ResouceID id = Hash(name);
+    ModelInfo* slot = nullptr;
+    if (ModelHandle const* handle = m_model_names.Find(id))
+    {
+        slot = m_models.Get(*handle);
+    }
+    if (slot)
+    {
+        m_residency.resident_bytes -= ResidentBytes(*slot);
+        ReleaseLater([this, old = std::move(*slot)]() { DestroyModel(old); });
+        *slot = std::move(model);
+    }
+    else
+    {
+        m_model_names.Assign(id, m_models.Insert(std::move(model)));
+    }
 }
 
-auto ResourceManager::Hash(const std::string &str) -> ResouceID
+void ResourceManager::DestroyModel(ModelInfo const& model)
 {
-    return s_hasher(str);
+    for (auto const& mesh : model.meshes)
+    {
+        for (auto const& buffer : mesh.buffers)
+        {
+            if (buffer.first)
+            {
+                SDL_ReleaseGPUBuffer(m_device, buffer.first);
+            }
+        }
+    }
+    if (model.transfer_buffer)
+    {
+        SDL_ReleaseGPUTransferBuffer(m_device, model.transfer_buffer);
+    }
 }
 
-auto ResourceManager::Slangc(SlangcCompileOption const& option) -> bool
+auto ResourceManager::MakeResident(ModelInfo& model) -> bool
+{
+    uint32_t size = static_cast<uint32_t>(model.cpu_data.size());
+    EnforceBudget(uint64_t{ size } * 2);
+
+    SDL_GPUTransferBufferCreateInfo transfer_buffer_info{
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = size,
+    };
+    model.transfer_buffer = SDL_CreateGPUTransferBuffer(m_device, &transfer_buffer_info);
+    bool created = model.transfer_buffer != nullptr;
+    if (created)
+    {
+        void* transfer_buffer_data = SDL_MapGPUTransferBuffer(m_device, model.transfer_buffer, false);
+        std::memcpy(transfer_buffer_data, model.cpu_data.data(), size);
+        SDL_UnmapGPUTransferBuffer(m_device, model.transfer_buffer);
+    }
+
+    for (auto& mesh : model.meshes)
+    {
+        for (size_t i{ 0 }; i < mesh.buffers.size() && created; ++i)
+        {
+            SDL_GPUBufferCreateInfo buffer_info{
+                .usage = i + 1 == mesh.buffers.size() ? SDL_GPU_BUFFERUSAGE_INDEX : SDL_GPU_BUFFERUSAGE_VERTEX,
+                .size = mesh.buffers[i].second,
+            };
+            mesh.buffers[i].first = SDL_CreateGPUBuffer(m_device, &buffer_info);
+            created = mesh.buffers[i].first != nullptr;
+            if (created)
+            {
+                SDL_SetGPUBufferName(m_device, mesh.buffers[i].first, model.name.c_str());
+            }
+        }
+    }
+
+    if (!created)
+    {
+        SO_ERROR("Failed to create model buffers: {}, {}", model.name, SDL_GetError());
+        DestroyModel(model);
+        for (auto& mesh : model.meshes)
+        {
+            for (auto& buffer : mesh.buffers)
+            {
+                buffer.first = nullptr;
+            }
+        }
+        model.transfer_buffer = nullptr;
+        return false;
+    }
+
+    model.resident = true;
+    m_residency.resident_bytes += ResidentBytes(model);
+    ++m_residency.uploads;
+    return true;
+}
+
+void ResourceManager::Evict(ModelInfo& model)
+{
+    m_residency.resident_bytes -= ResidentBytes(model);
+    ++m_residency.evictions;
+
+    // Only the GPU side goes, the CPU copy stays for the next upload
+    ModelInfo buffers{};
+    buffers.meshes = model.meshes;
+    buffers.transfer_buffer = model.transfer_buffer;
+    ReleaseLater([this, buffers = std::move(buffers)]() { DestroyModel(buffers); });
+
+    for (auto& mesh : model.meshes)
+    {
+        for (auto& buffer : mesh.buffers)
+        {
+            buffer.first = nullptr;
+        }
+    }
+    model.transfer_buffer = nullptr;
+    model.resident = false;
+    model.active = false;
+    SO_INFO("Model evicted: {}", model.name);
+}
+
+void ResourceManager::EnforceBudget(uint64_t incoming_bytes)
+{
+    uint64_t budget = m_residency.budget;
+    if (budget == 0 || m_residency.resident_bytes + incoming_bytes <= budget)
+    {
+        return;
+    }
+
+    // Models used this frame may already be recorded, leave them alone
+    std::vector<ModelInfo*> candidates;
+    m_models.ForEach([this, &candidates](ModelHandle, ModelInfo& model)
+    {
+        if (model.resident && model.last_used_frame < m_frame)
+        {
+            candidates.push_back(&model);
+        }
+    });
+    std::sort(candidates.begin(), candidates.end(), [](ModelInfo const* lhs, ModelInfo const* rhs)
+    {
+        return lhs->last_used_frame < rhs->last_used_frame;
+    });
+
+    for (ModelInfo* model : candidates)
+    {
+        if (m_residency.resident_bytes + incoming_bytes <= budget)
+        {
+            return;
+        }
+        Evict(*model);
+    }
+    if (m_residency.resident_bytes + incoming_bytes > budget)
+    {
+        SO_WARN("Model budget exceeded: {} of {} bytes in use this frame",
+            m_residency.resident_bytes + incoming_bytes, budget);
+    }
+}
+
+auto ResourceManager::UseModel(ModelHandle handle) -> ModelInfo const*
+{
+    ModelInfo* model = m_models.Get(handle);
+    if (!model)
+    {
+        return nullptr;
+    }
+    model->last_used_frame = m_frame;
+    if (!model->resident && MakeResident(*model))
+    {
+        m_pending_uploads.push_back(handle);
+    }
+    return model;
+}
+
+auto ResourceManager::TakePendingUploads() -> std::vector<ModelHandle>
+{
+    return std::exchange(m_pending_uploads, {});
+}
+
+void ResourceManager::MarkUploaded(ModelHandle handle)
+{
+    ModelInfo* model = m_models.Get(handle);
+    if (!model || !model->resident)
+    {
+        return;
+    }
+    model->active = true;
+
+    // Staging is not needed anymore, eviction re-creates it from cpu_data
+    if (model->transfer_buffer)
+    {
+        m_residency.resident_bytes -= model->cpu_data.size();
+        ReleaseLater([device = m_device, old = model->transfer_buffer]() { SDL_ReleaseGPUTransferBuffer(device, old); });
+        model->transfer_buffer = nullptr;
+    }
+}
+
+void ResourceManager::SetModelBudget(uint64_t bytes)
+{
+    m_residency.budget = bytes;
+    SO_INFO("Model budget: {} MiB", bytes >> 20);
+}
+
+void ResourceManager::UnloadModel(ResouceID id)
+{
+    ModelHandle const* handle = m_model_names.Find(id);
+    if (!handle)
+    {
+        return;
+    }
+    ModelHandle model = *handle;
+    m_model_names.Erase(id);
+    Release(model);
+}
+
+void ResourceManager::ReleaseLater(std::function<void()> release)
+{
+    m_pending_releases.push_back({ m_frame, std::move(release) });
+}
+
+void ResourceManager::BeginFrame(uint64_t completed_frame)
+{
+    SO_PROFILE_FUNCTION();
+    std::erase_if(m_pending_releases, [completed_frame](PendingRelease& pending)
+    {
+        if (pending.frame > completed_frame)
+        {
+            return false;
+        }
+        pending.release();
+        return true;
+    });
+    ++m_frame;
+}
+
+void ResourceManager::EnableHotReload()
+{
+    if (!m_hot_reloader)
+    {
+        m_hot_reloader = std::make_unique<HotReloader>(m_root_dir, *this);
+    }
+}
+
+void ResourceManager::ApplyReloads()
+{
+    SO_PROFILE_FUNCTION();
+    if (!m_hot_reloader)
+    {
+        return;
+    }
+
+    // Old objects are released only once their replacement was created,
+    // a failed rebuild keeps the previous version alive. Replaced objects
+    // wait in the release queue until the GPU is done with them.
+    for (auto& batch : m_hot_reloader->TakeReady())
+    {
+        std::map<std::string, PipelineInfo> pipelines;
+        for (auto& [name, info] : batch.pipelines)
+        {
+            pipelines[name] = std::move(info);
+        }
+
+        for (auto const& [shader, code_path] : batch.shaders)
+        {
+            if (!CreateShader(shader, code_path))
+            {
+                continue;
+            }
+            m_pipelines.ForEach([&](PipelineHandle, PipelineSlot& pipeline)
+            {
+                PipelineInfo const& info = pipeline.first;
+                if (!pipelines.contains(info.name) &&
+                    (info.vertex_shader == shader.name || info.fragment_shader == shader.name))
+                {
+                    pipelines[info.name] = info;
+                }
+            });
+        }
+
+        for (auto& [name, info] : pipelines)
+        {
+            CreatePipeline(name, std::move(info));
+        }
+
+        for (auto& [name, info, code_path] : batch.compute_pipelines)
+        {
+            CreateComputePipeline(name, std::move(info), code_path);
+        }
+
+        for (auto const& [name, gltf_helper] : batch.models)
+        {
+            CreateModel(name, *gltf_helper);
+        }
+
+        // Held handles keep the model alive, only the name goes
+        for (auto const& name : batch.removed_models)
+        {
+            UnloadModel(Hash(name));
+            SO_INFO("Model unloaded: {}", name);
+        }
+    }
+}
+
+auto ResourceManager::AcquireShader(ResouceID id) -> ShaderHandle
+{
+    ShaderHandle const* handle = m_shader_names.Find(id);
+    return handle && m_shaders.AddRef(*handle) ? *handle : ShaderHandle{};
+}
+
+auto ResourceManager::AcquirePipeline(ResouceID id) -> PipelineHandle
+{
+    PipelineHandle const* handle = m_pipeline_names.Find(id);
+    return handle && m_pipelines.AddRef(*handle) ? *handle : PipelineHandle{};
+}
+
+auto ResourceManager::AcquireModel(ResouceID id) -> ModelHandle
+{
+    ModelHandle const* handle = m_model_names.Find(id);
+    return handle && m_models.AddRef(*handle) ? *handle : ModelHandle{};
+}
+
+auto ResourceManager::AcquireComputePipeline(ResouceID id) -> ComputePipelineHandle
+{
+    ComputePipelineHandle const* handle = m_compute_pipeline_names.Find(id);
+    return handle && m_compute_pipelines.AddRef(*handle) ? *handle : ComputePipelineHandle{};
+}
+
+void ResourceManager::Release(ShaderHandle handle)
+{
+    if (auto shader = m_shaders.Release(handle))
+    {
+        ReleaseLater([device = m_device, old = shader->second]() { SDL_ReleaseGPUShader(device, old); });
+    }
+}
+
+void ResourceManager::Release(PipelineHandle handle)
+{
+    if (auto pipeline = m_pipelines.Release(handle))
+    {
+        ReleaseLater([device = m_device, old = pipeline->second]() { SDL_ReleaseGPUGraphicsPipeline(device, old); });
+    }
+}
+
+void ResourceManager::Release(ModelHandle handle)
+{
+    if (auto model = m_models.Release(handle))
+    {
+        m_residency.resident_bytes -= ResidentBytes(*model);
+        ReleaseLater([this, old = std::move(*model)]() { DestroyModel(old); });
+    }
+}
+
+void ResourceManager::Release(ComputePipelineHandle handle)
+{
+    if (auto pipeline = m_compute_pipelines.Release(handle))
+    {
+        ReleaseLater([device = m_device, old = pipeline->second]() { SDL_ReleaseGPUComputePipeline(device, old); });
+    }
+}
+
+auto ResourceManager::GetShader(ShaderHandle handle) const -> SDL_GPUShader*
+{
+    auto const* shader = m_shaders.Get(handle);
+    return shader ? shader->second : nullptr;
+}
+
+auto ResourceManager::GetPipeline(PipelineHandle handle) const -> SDL_GPUGraphicsPipeline*
+{
+    auto const* pipeline = m_pipelines.Get(handle);
+    return pipeline ? pipeline->second : nullptr;
+}
+
+auto ResourceManager::GetModel(ModelHandle handle) const -> ModelInfo const*
+{
+    return m_models.Get(handle);
+}
+
+auto ResourceManager::GetComputePipeline(ComputePipelineHandle handle) const -> SDL_GPUComputePipeline*
+{
+    auto const* pipeline = m_compute_pipelines.Get(handle);
+    return pipeline ? pipeline->second : nullptr;
+}
+
+auto ResourceManager::GetShader(ResouceID id) const -> SDL_GPUShader*
+{
+    ShaderHandle const* handle = m_shader_names.Find(id);
+    return handle ? GetShader(*handle) : nullptr;
+}
+
+auto ResourceManager::GetPipeline(ResouceID id) const -> SDL_GPUGraphicsPipeline*
+{
+    PipelineHandle const* handle = m_pipeline_names.Find(id);
+    return handle ? GetPipeline(*handle) : nullptr;
+}
+
+auto ResourceManager::GetModel(ResouceID id) const -> ModelInfo const*
+{
+    ModelHandle const* handle = m_model_names.Find(id);
+    return handle ? GetModel(*handle) : nullptr;
+}
+
+auto ResourceManager::GetComputePipeline(ResouceID id) const -> SDL_GPUComputePipeline*
+{
+    ComputePipelineHandle const* handle = m_compute_pipeline_names.Find(id);
+    return handle ? GetComputePipeline(*handle) : nullptr;
+}
+
+auto ResourceManager::SlangcCommand(SlangcCompileOption const& option) -> std::optional<std::string>
 {
     if (option.input_file.empty())
     {
         SO_ERROR("Input file is empty");
-        return false;
+        return std::nullopt;
     }
 
     if (!std::filesystem::exists(option.input_file))
     {
         SO_ERROR("File not found: {}", option.input_file.string());
-        return false;
+        return std::nullopt;
     }
 
     if (option.output_file.empty())
     {
         SO_ERROR("Output directory is empty");
-        return false;
+        return std::nullopt;
     }
 
     std::string shader_format_str{ "" };
@@ -155,7 +952,7 @@ auto ResourceManager::Slangc(SlangcCompileOption const& option) -> bool
             break;
         default:
             SO_ERROR("Unsupported shader format");
-            return false;
+            return std::nullopt;
     }
 
     std::string profile = std::format(
@@ -179,6 +976,10 @@ auto ResourceManager::Slangc(SlangcCompileOption const& option) -> bool
         shader_stage_str = "fragment";
         break;
     };
+    if (option.compute)
+    {
+        shader_stage_str = "compute";
+    }
 
     std::string options = std::format(
         "-stage {} -O{} -g{}",
@@ -186,14 +987,7 @@ auto ResourceManager::Slangc(SlangcCompileOption const& option) -> bool
         static_cast<uint32_t>(option.optimization_level),
         static_cast<uint32_t>(option.debug_level));
 
-    std::string command = std::format("{} {} {}", profile, io, options);
-    int result = std::system(command.c_str());
-    if (result != 0)
-    {
-        SO_ERROR("Failed to compile: {}", option.input_file.string());
-    }
-    SO_INFO("Shader compiled: {}", option.output_file.string());
-    return result == 0;
+    return std::format("{} {} {}", profile, io, options);
 }
 
 void ResourceManager::DebugLuaStack(lua_State* L)
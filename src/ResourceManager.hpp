@@ -1,35 +1,37 @@
 #pragma once
-#include <map>
+#include <memory>
+#include <functional>
+#include <string_view>
 #include <utility>
 #include <filesystem>
 #include <lua.hpp>
+#include <glm/glm.hpp>
 #include <SDL3/SDL_gpu.h>
+#include "ShaderCache.hpp"
+#include "FlatHashMap.hpp"
+#include "Handle.hpp"
+#include "Hash.hpp"
 
-enum class ShaderOptimizationLevel
-{
-    None    = 0,
-    Default = 1,
-    High    = 2,
-    Maximal = 3
-};
-
-enum class ShaderDebugLevel
-{
-    None     = 0,
-    Minimal  = 1,
-    Standard = 2,
-    Maximal  = 3
-};
+class GLTFHelper;
+struct SkinInfo;
+class JobSystem;
+class HotReloader;
+struct ConfigSnapshot;
 
-struct SlangcCompileOption
+struct EngineConfig
 {
-    std::filesystem::path   input_file;
-    std::filesystem::path   output_file;
-    std::string             entry_point;
-    SDL_GPUShaderStage      stage;
-    SDL_GPUShaderFormat     format;
-    ShaderOptimizationLevel optimization_level{ ShaderOptimizationLevel::Default };
-    ShaderDebugLevel        debug_level{ ShaderDebugLevel::None };
+    uint64_t model_budget{ 0 };          // bytes, 0 means unlimited
+    float    script_gc_budget_ms{ 0.5f }; // per frame
+    uint32_t script_threads{ 0 };        // script lanes, 0 means one per core
+    uint32_t sim_rate{ 60 };             // simulation steps per second
+    uint32_t max_sim_steps{ 4 };         // per frame, later steps are dropped
+    SDL_GPUPresentMode present_mode{ SDL_GPU_PRESENTMODE_VSYNC };
+    uint32_t max_fps{ 0 };               // 0 means unlimited
+    uint32_t background_fps{ 15 };       // minimized or unfocused, 0 means unlimited
+    float    gpu_budget_ms{ 0.0f };      // dynamic resolution target, 0 disables it
+    float    min_render_scale{ 0.5f };
+    float    max_render_scale{ 1.0f };   // also the scale without dynamic resolution
+    bool     gpu_culling{ false };       // needs the cull and instanced pipelines
 };
 
 struct ShaderInfo
@@ -44,6 +46,46 @@ struct ShaderInfo
     uint32_t              num_uniform_buffers;
 };
 
+struct PendingShader
+{
+    std::string name;
+    ShaderInfo  info;
+    bool        compute{ false }; // compiled for the compute stage, `info.stage` is ignored
+};
+
+struct PipelineInfo
+{
+    std::string                                 name; // set on creation
+    std::string                                 vertex_shader;
+    std::string                                 fragment_shader;
+    // Array pointers are patched to the vectors below on creation
+    SDL_GPUGraphicsPipelineCreateInfo           create_info;
+    std::vector<SDL_GPUVertexBufferDescription> vertex_buffer_descriptions;
+    std::vector<SDL_GPUVertexAttribute>         vertex_attributes;
+    std::vector<SDL_GPUColorTargetDescription>  color_target_descriptions;
+};
+
+// Compute shaders are not shared, the pipeline carries its own. The shader's
+// num_storage_buffers counts the readonly ones.
+struct ComputePipelineInfo
+{
+    std::string name; // set on creation
+    ShaderInfo  shader;
+    uint32_t    num_readonly_storage_textures;
+    uint32_t    num_readwrite_storage_textures;
+    uint32_t    num_readwrite_storage_buffers;
+    uint32_t    threadcount_x;
+    uint32_t    threadcount_y;
+    uint32_t    threadcount_z;
+};
+
+struct ModelSource
+{
+    std::string           name;
+    std::filesystem::path path;
+    std::filesystem::path clips; // compact clip file, optional, see GLTFHelper::Load
+};
+
 struct MeshInfo
 {
     std::vector<std::pair<SDL_GPUBuffer*, uint32_t>> buffers;
@@ -53,37 +95,163 @@ struct MeshInfo
 
 struct ModelInfo
 {
-    std::vector<MeshInfo>  meshes;
-    SDL_GPUTransferBuffer* transfer_buffer;
-    bool                   active;
+    std::string            name;
+    std::vector<MeshInfo>  meshes;          // buffers are null while evicted
+    SDL_GPUTransferBuffer* transfer_buffer; // alive until the upload finished
+    bool                   active;          // uploaded and drawable
+    glm::vec4              bounds;          // model space sphere, center and radius
+    std::shared_ptr<SkinInfo const> skin;   // skeleton and clips, null for static models
+    // Residency
+    std::vector<uint8_t>   cpu_data;        // buffer contents in upload order
+    uint64_t               last_used_frame;
+    bool                   resident;
+};
+
+struct ResidencyStats
+{
+    uint64_t budget;         // 0 means unlimited
+    uint64_t resident_bytes; // vertex, index and staging buffers
+    uint64_t uploads;
+    uint64_t evictions;
 };
 
-using ResouceID = std::size_t;
+using ResouceID = uint64_t;
+
+// Compile time resource id, `"default"_rid == ResourceManager::Hash("default")`
+consteval auto operator ""_rid(char const* str, size_t size) -> ResouceID
+{
+    return Fnv1a::Hash({ str, size });
+}
+
+using ShaderHandle          = Handle<struct ShaderTag>;
+using PipelineHandle        = Handle<struct PipelineTag>;
+using ModelHandle           = Handle<struct ModelTag>;
+using ComputePipelineHandle = Handle<struct ComputePipelineTag>;
 
 class ResourceManager
 {
 public:
-    static void Initialize(std::filesystem::path const& root, SDL_GPUDevice* device);
+    // Jobs must outlive the manager
+    static void Initialize(std::filesystem::path const& root, SDL_GPUDevice* device, JobSystem& jobs);
     [[nodiscard]] static auto Instance() -> ResourceManager&;
+    static void LoadPreludes(lua_State* L, std::filesystem::path const& root);
     static void Destroy();
 
     auto LoadShader(lua_State* L, std::filesystem::path const& path) -> bool;
+    auto LoadShaderInfo(lua_State* L, std::filesystem::path const& path) -> std::optional<ShaderInfo>;
+    // Compile dirty shaders in parallel, then create GPU shaders one by one.
+    auto CreateShaders(std::vector<PendingShader> const& shaders) -> uint32_t;
+    // Resolve byte code paths through the cache, empty on failure. Thread agnostic.
+    auto CompileShaders(std::vector<PendingShader> const& shaders) -> std::vector<std::filesystem::path>;
     auto LoadPipeline(lua_State* L, std::filesystem::path const& path) -> bool;
+    auto LoadPipelineInfo(lua_State* L, std::filesystem::path const& path) -> std::optional<PipelineInfo>;
+    auto CreatePipeline(std::string const& name, PipelineInfo info) -> bool;
+    auto LoadComputePipelineInfo(lua_State* L, std::filesystem::path const& path) -> std::optional<ComputePipelineInfo>;
+    // Compiles like CreateShaders, then creates the pipelines one by one
+    auto CreateComputePipelines(std::vector<std::pair<std::string, ComputePipelineInfo>> const& pipelines) -> uint32_t;
+    auto CreateComputePipeline(std::string const& name, ComputePipelineInfo info, std::filesystem::path const& code_path) -> bool;
     auto LoadModelGroup(lua_State* L, std::filesystem::path const& path) -> bool;
+    auto LoadModelGroupInfo(lua_State* L, std::filesystem::path const& path) -> std::optional<std::vector<ModelSource>>;
+    auto LoadEngineConfig(lua_State* L, std::filesystem::path const& path) -> std::optional<EngineConfig>;
+    auto CreateModel(std::string const& name, GLTFHelper const& gltf_helper) -> bool;
+    // Drop the references held by the manager, objects go away once no
+    // handle refers to them.
+    auto UnloadModelGroup(lua_State* L, std::filesystem::path const& path) -> bool;
+    void UnloadModel(ResouceID id);
 
-    [[nodiscard]] auto GetShader(std::string const& name) -> SDL_GPUShader*;
-    [[nodiscard]] auto GetPipeline(std::string const& name) -> SDL_GPUGraphicsPipeline*;
-    [[nodiscard]] auto GetModel(std::string const& name) -> ModelInfo const&;
-    void SetModelStatus(std::string const& name, bool status);
+    // Watch config and assets, rebuilt objects are swapped in by ApplyReloads.
+    void EnableHotReload();
+    // Call at a frame boundary. Objects are replaced in place so handles
+    // stay valid, reloaded models upload again when next used.
+    void ApplyReloads();
 
-    [[nodiscard]] static auto Hash(std::string const& str) -> ResouceID;
-    static auto Slangc(SlangcCompileOption const& option) -> bool;
+    // Released GPU objects are kept until the frame they were released in
+    // has completed on the GPU. Models are evicted only to make room for an
+    // upload, so a working set over budget is not re-uploaded every frame.
+    void BeginFrame(uint64_t completed_frame);
+    [[nodiscard]] auto GetFrame() const -> uint64_t { return m_frame; }
+
+    // Handles keep the object alive until released, lookups by name do not
+    [[nodiscard]] auto AcquireShader(ResouceID id) -> ShaderHandle;
+    [[nodiscard]] auto AcquirePipeline(ResouceID id) -> PipelineHandle;
+    [[nodiscard]] auto AcquireModel(ResouceID id) -> ModelHandle;
+    [[nodiscard]] auto AcquireComputePipeline(ResouceID id) -> ComputePipelineHandle;
+    void Release(ShaderHandle handle);
+    void Release(PipelineHandle handle);
+    void Release(ModelHandle handle);
+    void Release(ComputePipelineHandle handle);
+    [[nodiscard]] auto GetShader(ShaderHandle handle) const -> SDL_GPUShader*;
+    [[nodiscard]] auto GetPipeline(PipelineHandle handle) const -> SDL_GPUGraphicsPipeline*;
+    [[nodiscard]] auto GetModel(ModelHandle handle) const -> ModelInfo const*;
+    [[nodiscard]] auto GetComputePipeline(ComputePipelineHandle handle) const -> SDL_GPUComputePipeline*;
+
+    // Lookups never insert, a miss returns nullptr
+    [[nodiscard]] auto GetShader(ResouceID id) const -> SDL_GPUShader*;
+    [[nodiscard]] auto GetPipeline(ResouceID id) const -> SDL_GPUGraphicsPipeline*;
+    [[nodiscard]] auto GetModel(ResouceID id) const -> ModelInfo const*;
+    [[nodiscard]] auto GetComputePipeline(ResouceID id) const -> SDL_GPUComputePipeline*;
+    [[nodiscard]] auto GetShader(std::string_view name) const -> SDL_GPUShader* { return GetShader(Hash(name)); }
+    [[nodiscard]] auto GetPipeline(std::string_view name) const -> SDL_GPUGraphicsPipeline* { return GetPipeline(Hash(name)); }
+    [[nodiscard]] auto GetModel(std::string_view name) const -> ModelInfo const* { return GetModel(Hash(name)); }
+    [[nodiscard]] auto GetComputePipeline(std::string_view name) const -> SDL_GPUComputePipeline* { return GetComputePipeline(Hash(name)); }
+
+    // Model buffers are created on first use and evicted least recently
+    // used first when the budget is exceeded. UseModel marks the model as
+    // drawn this frame and queues an upload if it is not resident, it
+    // draws once that upload finished.
+    [[nodiscard]] auto UseModel(ModelHandle handle) -> ModelInfo const*;
+    [[nodiscard]] auto TakePendingUploads() -> std::vector<ModelHandle>;
+    void MarkUploaded(ModelHandle handle);
+    void SetModelBudget(uint64_t bytes);
+    [[nodiscard]] auto GetResidencyStats() const -> ResidencyStats const& { return m_residency; }
+    [[nodiscard]] auto GetEngineConfig() const -> EngineConfig const& { return m_engine_config; }
+
+    [[nodiscard]] static constexpr auto Hash(std::string_view str) -> ResouceID { return Fnv1a::Hash(str); }
+    static auto SlangcCommand(SlangcCompileOption const& option) -> std::optional<std::string>;
     static void DebugLuaStack(lua_State* L);
     static void DebugLuaShowTable(lua_State *L);
 private:
+    auto CreateShader(PendingShader const& shader, std::filesystem::path const& code_path) -> bool;
+    // Relative config paths are relative to the config root
+    [[nodiscard]] auto ResolvePath(std::string const& path) const -> std::filesystem::path;
+    // Source shaders are compiled for the device, the configured format is a preference
+    [[nodiscard]] auto CodeFormat(ShaderInfo const& info) const -> SDL_GPUShaderFormat;
+    auto LoadConfig(std::filesystem::path const& root) -> ConfigSnapshot;
+    void ApplyConfig(ConfigSnapshot const& config);
+    void StoreModel(std::string const& name, ModelInfo model);
+    void DestroyModel(ModelInfo const& model);
+    auto MakeResident(ModelInfo& model) -> bool;
+    void Evict(ModelInfo& model);
+    void EnforceBudget(uint64_t incoming_bytes);
+    void ReleaseLater(std::function<void()> release);
+private:
+    struct PendingRelease
+    {
+        uint64_t              frame;
+        std::function<void()> release;
+    };
+
+    using ShaderSlot          = std::pair<ShaderInfo, SDL_GPUShader*>;
+    using PipelineSlot        = std::pair<PipelineInfo, SDL_GPUGraphicsPipeline*>;
+    using ComputePipelineSlot = std::pair<ComputePipelineInfo, SDL_GPUComputePipeline*>;
+
     std::string                                                m_root_dir;
     SDL_GPUDevice*                                             m_device;
-    std::map<ResouceID, std::pair<ShaderInfo, SDL_GPUShader*>> m_shaders;
-    std::map<ResouceID, SDL_GPUGraphicsPipeline*>              m_pipelines;
-    std::map<ResouceID, ModelInfo>                             m_models;
+    SDL_GPUShaderFormat                                        m_shader_formats{ SDL_GPU_SHADERFORMAT_INVALID };
+    JobSystem*                                                 m_jobs{ nullptr };
+    std::unique_ptr<ShaderCache>                               m_shader_cache;
+    SlotArray<ShaderSlot, ShaderHandle>                        m_shaders;
+    SlotArray<PipelineSlot, PipelineHandle>                    m_pipelines;
+    SlotArray<ModelInfo, ModelHandle>                          m_models;
+    SlotArray<ComputePipelineSlot, ComputePipelineHandle>      m_compute_pipelines;
+    FlatHashMap<ShaderHandle>                                  m_shader_names;
+    FlatHashMap<PipelineHandle>                                m_pipeline_names;
+    FlatHashMap<ModelHandle>                                   m_model_names;
+    FlatHashMap<ComputePipelineHandle>                         m_compute_pipeline_names;
+    std::vector<PendingRelease>                                m_pending_releases;
+    uint64_t                                                   m_frame{ 0 };
+    std::vector<ModelHandle>                                   m_pending_uploads;
+    ResidencyStats                                             m_residency{};
+    EngineConfig                                               m_engine_config{};
+    std::unique_ptr<HotReloader>                               m_hot_reloader;
 };
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include <cmath>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Scene.hpp"
+#include "Profiler.hpp"
+
+namespace {
+    auto ComposeMatrix(Transform const& transform) -> glm::mat4
+    {
+        glm::mat4 matrix = glm::translate(glm::mat4(1.0f), transform.position) * glm::mat4_cast(transform.rotation);
+        return glm::scale(matrix, transform.scale);
+    }
+
+    auto MakeDraw(ResourceManager const& mgr, ModelHandle handle, glm::mat4 const& matrix) -> DrawItem
+    {
+        ModelInfo const* model = mgr.GetModel(handle);
+        glm::vec4 local = model ? model->bounds : glm::vec4(0.0f);
+        float scale = std::max({
+            glm::length(glm::vec3(matrix[0])),
+            glm::length(glm::vec3(matrix[1])),
+            glm::length(glm::vec3(matrix[2])),
+        });
+        glm::vec4 center = matrix * glm::vec4(glm::vec3(local), 1.0f);
+        return { handle, matrix, glm::vec4(glm::vec3(center), local.w * scale) };
+    }
+
+    void AdvanceClip(SkinInfo const& skin, uint32_t clip, bool loop, float delta_time, float& time)
+    {
+        if (clip >= skin.clips.size())
+        {
+            return;
+        }
+        float duration = skin.clips[clip].duration;
+        time += delta_time;
+        if (loop && duration > 0.0f)
+        {
+            time = std::fmod(time, duration);
+            time = time < 0.0f ? time + duration : time;
+        }
+        else
+        {
+            time = std::clamp(time, 0.0f, duration);
+        }
+    }
+}
+
+void Animator::Play(uint32_t next, float fade_seconds)
+{
+    if (fade_seconds > 0.0f && clip != s_no_clip)
+    {
+        fade_clip = clip;
+        fade_time = time;
+        fade_duration = fade_seconds;
+        fade_elapsed = 0.0f;
+    }
+    else
+    {
+        fade_clip = s_no_clip;
+    }
+    clip = next;
+    time = 0.0f;
+}
+
+void SnapshotTransforms(World& world, JobSystem& jobs)
+{
+    SO_PROFILE_FUNCTION();
+    world.ParallelEach<Transform const, PreviousTransform>(jobs, [](Entity, Transform const& transform, PreviousTransform& previous)
+    {
+        previous.value = transform;
+    });
+}
+
+void IntegrateVelocities(World& world, JobSystem& jobs, float delta_time)
+{
+    SO_PROFILE_FUNCTION();
+    world.ParallelEach<Transform, Velocity const>(jobs, [delta_time](Entity, Transform& transform, Velocity const& velocity)
+    {
+        transform.position += velocity.linear * delta_time;
+    });
+}
+
+void UpdateTransforms(World& world, JobSystem& jobs, float alpha)
+{
+    SO_PROFILE_FUNCTION();
+    world.ParallelEach<Transform const, WorldTransform>(jobs, [](Entity, Transform const& transform, WorldTransform& world_transform)
+    {
+        world_transform.matrix = ComposeMatrix(transform);
+    }, World::MaskOf<PreviousTransform>());
+
+    world.ParallelEach<Transform const, PreviousTransform const, WorldTransform>(jobs,
+        [alpha](Entity, Transform const& transform, PreviousTransform const& previous, WorldTransform& world_transform)
+    {
+        world_transform.matrix = ComposeMatrix({
+            .position = glm::mix(previous.value.position, transform.position, alpha),
+            .rotation = glm::slerp(previous.value.rotation, transform.rotation, alpha),
+            .scale = glm::mix(previous.value.scale, transform.scale, alpha),
+        });
+    });
+}
+
+void AdvanceAnimators(World& world, JobSystem& jobs, float delta_time)
+{
+    SO_PROFILE_FUNCTION();
+    auto& mgr = ResourceManager::Instance();
+    world.ParallelEach<Renderable const, Animator>(jobs, [&mgr, delta_time](Entity, Renderable const& renderable, Animator& animator)
+    {
+        ModelInfo const* model = mgr.GetModel(renderable.model);
+        if (!model || !model->skin)
+        {
+            return;
+        }
+        AdvanceClip(*model->skin, animator.clip, animator.loop, delta_time * animator.speed, animator.time);
+        if (animator.fade_clip != Animator::s_no_clip)
+        {
+            AdvanceClip(*model->skin, animator.fade_clip, animator.loop, delta_time * animator.speed, animator.fade_time);
+            animator.fade_elapsed += delta_time;
+            if (animator.fade_elapsed >= animator.fade_duration)
+            {
+                animator.fade_clip = Animator::s_no_clip;
+            }
+        }
+    });
+}
+
+void EvaluatePoses(World& world, JobSystem& jobs, float alpha, float step_seconds)
+{
+    SO_PROFILE_FUNCTION();
+    auto& mgr = ResourceManager::Instance();
+    float ahead = alpha * step_seconds;
+    world.ParallelEach<Renderable const, Animator const, SkinPalette>(jobs,
+        [&mgr, ahead](Entity, Renderable const& renderable, Animator const& animator, SkinPalette& palette)
+    {
+        ModelInfo const* model = mgr.GetModel(renderable.model);
+        if (!model || !model->skin)
+        {
+            palette.joints.clear();
+            return;
+        }
+        SkinInfo const& skin = *model->skin;
+        uint32_t joint_count = skin.skeleton.JointCount();
+
+        // Scratch per worker, kept between frames to skip the allocations
+        thread_local Pose pose;
+        thread_local Pose faded;
+        if (animator.clip < skin.clips.size())
+        {
+            pose.Resize(joint_count);
+            SampleClip(skin.clips[animator.clip], animator.time + ahead * animator.speed, animator.loop, pose);
+        }
+        else
+        {
+            pose = skin.skeleton.rest;
+        }
+        if (animator.fade_clip < skin.clips.size() && animator.fade_duration > 0.0f)
+        {
+            faded.Resize(joint_count);
+            SampleClip(skin.clips[animator.fade_clip], animator.fade_time + ahead * animator.speed, animator.loop, faded);
+            float weight = std::clamp((animator.fade_elapsed + ahead) / animator.fade_duration, 0.0f, 1.0f);
+            BlendPoses(faded, pose, weight, pose);
+        }
+
+        palette.joints.resize(joint_count);
+        ComputePalette(skin.skeleton, pose, palette.joints);
+    });
+}
+
+void CollectDraws(World& world, std::vector<DrawItem>& draws)
+{
+    SO_PROFILE_FUNCTION();
+    draws.clear();
+    auto& mgr = ResourceManager::Instance();
+    world.EachChunk<Renderable const, WorldTransform const>([&draws, &mgr](size_t count, Entity const*, Renderable const* renderables, WorldTransform const* transforms)
+    {
+        for (size_t i{ 0 }; i < count; ++i)
+        {
+            draws.push_back(MakeDraw(mgr, renderables[i].model, transforms[i].matrix));
+        }
+    }, World::MaskOf<SkinPalette>());
+
+    world.EachChunk<Renderable const, WorldTransform const, SkinPalette const>(
+        [&draws, &mgr](size_t count, Entity const*, Renderable const* renderables, WorldTransform const* transforms, SkinPalette const* palettes)
+    {
+        for (size_t i{ 0 }; i < count; ++i)
+        {
+            DrawItem& draw = draws.emplace_back(MakeDraw(mgr, renderables[i].model, transforms[i].matrix));
+            draw.palette = palettes[i].joints.empty() ? nullptr : &palettes[i];
+        }
+    });
+}
+
+void CullDraws(std::vector<DrawItem>& draws, ViewSet const& views, JobSystem& jobs)
+{
+    SO_PROFILE_FUNCTION();
+    jobs.ParallelFor(draws.size(), 256, [&draws, &views](size_t begin, size_t end)
+    {
+        for (size_t i{ begin }; i < end; ++i)
+        {
+            draws[i].views = views.Cull(draws[i].bounds);
+        }
+    });
+}
\ No newline at end of file
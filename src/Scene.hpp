@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "World.hpp"
+#include "Frustum.hpp"
+#include "ResourceManager.hpp"
+#include "Animation.hpp"
+
+struct Transform
+{
+    glm::vec3 position{ 0.0f };
+    glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+    glm::vec3 scale{ 1.0f };
+};
+
+// Transform at the start of the last simulation step. Entities holding it
+// are drawn between that and Transform, so motion stays smooth whatever
+// the frame rate; others are drawn where they are.
+struct PreviousTransform
+{
+    Transform value;
+};
+
+// Written by UpdateTransforms from Transform
+struct WorldTransform
+{
+    glm::mat4 matrix{ 1.0f };
+};
+
+struct Velocity
+{
+    glm::vec3 linear{ 0.0f };
+};
+
+// Does not hold a reference, whoever spawns the entity keeps the model alive
+struct Renderable
+{
+    ModelHandle model{};
+};
+
+// Plays clips of the Renderable's skin, see ModelInfo::skin. Advanced per
+// simulation step, posed per frame between steps.
+struct Animator
+{
+    static constexpr uint32_t s_no_clip{ ~0u };
+
+    uint32_t clip{ s_no_clip };      // into SkinInfo::clips, rest pose without
+    float    time{ 0.0f };           // seconds into the clip
+    float    speed{ 1.0f };
+    bool     loop{ true };
+    // Clip faded out, blended into `clip` until the fade elapsed
+    uint32_t fade_clip{ s_no_clip };
+    float    fade_time{ 0.0f };
+    float    fade_duration{ 0.0f };
+    float    fade_elapsed{ 0.0f };
+
+    // Starts `next` from its beginning, crossfading from the current clip
+    // over `fade_seconds`
+    void Play(uint32_t next, float fade_seconds = 0.0f);
+};
+
+// Skinning matrices of the frame's pose, written by EvaluatePoses. Entities
+// holding it are drawn with the skinned pipeline.
+struct SkinPalette
+{
+    std::vector<glm::mat4> joints;
+};
+
+struct DrawItem
+{
+    ModelHandle        model;
+    glm::mat4          world;
+    glm::vec4          bounds;                  // world space sphere
+    ViewMask           views{ ~ViewMask{ 0 } }; // visible in, all until culled
+    SkinPalette const* palette{ nullptr };      // skinned draws, valid until the world's next Flush
+};
+
+// Systems, parallel over chunks
+// Once per simulation step, before anything moves
+void SnapshotTransforms(World& world, JobSystem& jobs);
+void IntegrateVelocities(World& world, JobSystem& jobs, float delta_time);
+// `alpha` is how far rendering is between the previous and the current
+// step, from 0 to 1
+void UpdateTransforms(World& world, JobSystem& jobs, float alpha = 1.0f);
+// Once per simulation step, moves clips and fades along
+void AdvanceAnimators(World& world, JobSystem& jobs, float delta_time);
+// Once per frame, samples clips `alpha` of a step ahead of the animators
+// and fills the palettes
+void EvaluatePoses(World& world, JobSystem& jobs, float alpha, float step_seconds);
+// Refills `draws` with every renderable entity
+void CollectDraws(World& world, std::vector<DrawItem>& draws);
+// One pass over the draws for all views, parallel over ranges
+void CullDraws(std::vector<DrawItem>& draws, ViewSet const& views, JobSystem& jobs);
\ No newline at end of file
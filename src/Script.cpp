@@ -1,5 +1,6 @@
 #include <SDL3/SDL_gpu.h>
 #include <cstdint>
+#include <algorithm>
 #include "ResourceManager.hpp"
 #include "Logger.hpp"
 #include "Script.hpp"
@@ -132,21 +133,33 @@ auto ResourceManager::LoadShader(
     lua_State* L, 
     std::filesystem::path const& path) -> bool
 {
-    if (!Script::Load(L, path))
+    std::optional<ShaderInfo> shader_info = LoadShaderInfo(L, path);
+    if (!shader_info)
     {
         return false;
     }
+    return CreateShaders({{path.stem().string(), std::move(*shader_info)}}) == 1;
+}
+
+auto ResourceManager::LoadShaderInfo(
+    lua_State* L,
+    std::filesystem::path const& path) -> std::optional<ShaderInfo>
+{
+    if (!Script::Load(L, path))
+    {
+        return std::nullopt;
+    }
 
     ShaderInfo shader_info{};
     {   
         LuaTableScope shader_scope(L, "shader");
         if (!shader_scope.IsValid())
         {
-            return false;
+            return std::nullopt;
         }
 
         shader_info.is_byte_code = Script::ReadBooleanField(L, "is_byte_code").value_or(false);
-        shader_info.source_path = Script::ReadStringField(L, "source_path").value_or("");
+        shader_info.source_path = ResolvePath(Script::ReadStringField(L, "source_path").value_or(""));
         shader_info.stage = static_cast<SDL_GPUShaderStage>(Script::ReadIntegerField(L, "stage").value_or(0));
         shader_info.format = static_cast<uint32_t>(Script::ReadIntegerField(L, "format").value_or(0));
         shader_info.entry_point = Script::ReadStringField(L, "entry_point").value_or("main");
@@ -155,107 +168,46 @@ auto ResourceManager::LoadShader(
         shader_info.num_uniform_buffers = static_cast<uint32_t>(Script::ReadIntegerField(L, "num_uniform_buffers").value_or(0));
     } // shader_scope
 
-    std::size_t code_size{ 0 };
-    void* code{ nullptr };
-    if (shader_info.is_byte_code)
-    {
-        code = SDL_LoadFile(shader_info.source_path.c_str(), &code_size);
-    }
-    else
-    {
-        std::string format_suffix{ "" };
-        switch (shader_info.format)
-        {
-            case SDL_GPU_SHADERFORMAT_SPIRV:    
-                format_suffix = "spv";
-                break;
-            case SDL_GPU_SHADERFORMAT_MSL:
-                format_suffix = "metal";
-                break;
-            default:
-                SO_ERROR("Unsupported shader format");
-                return false;
-        }
-
-        std::filesystem::path output_path = std::format(
-            "/Users/w6rsty/dev/Cpp/soulike/build/shaders/metal/{}.{}",
-            path.stem().string(),
-            format_suffix);
-        std::filesystem::create_directories(output_path.parent_path());
-
-        ResourceManager::Slangc({
-            .input_file = shader_info.source_path,
-            .output_file = output_path,
-            .entry_point = shader_info.entry_point,
-            .stage = shader_info.stage,
-            .format = shader_info.format,
-        });
-
-        code = SDL_LoadFile(output_path.c_str(), &code_size);
-    }
+    return shader_info;
+}
 
-    SDL_GPUShaderCreateInfo shader_create_info{
-        .code_size           = code_size,
-        .code                = static_cast<uint8_t*>(code),
-        .entrypoint          = shader_info.entry_point.c_str(),
-        .format              = shader_info.format,
-        .stage               = shader_info.stage,
-        .num_samplers        = shader_info.num_samplers,
-        .num_storage_buffers = shader_info.num_storage_buffers,
-        .num_uniform_buffers = shader_info.num_uniform_buffers,
-    };
-    SDL_GPUShader* shader = SDL_CreateGPUShader(m_device, &shader_create_info);
-    SDL_free(code);
-    if (!shader)
+auto ResourceManager::LoadPipeline(
+    lua_State* L, 
+    std::filesystem::path const& path) -> bool
+{
+    std::optional<PipelineInfo> pipeline_info = LoadPipelineInfo(L, path);
+    if (!pipeline_info)
     {
-        SO_ERROR("Failed to create shader, {}", SDL_GetError());
         return false;
     }
-
-    std::string shader_name = path.stem().string();
-    m_shaders[ResourceManager::Hash(shader_name)] = {shader_info, shader};
-    SO_INFO("Shader loaded: {}", shader_name);
-
-    return true;
+    return CreatePipeline(path.stem().string(), std::move(*pipeline_info));
 }
 
-auto ResourceManager::LoadPipeline(
-    lua_State* L, 
-    std::filesystem::path const& path) -> bool
+auto ResourceManager::LoadPipelineInfo(
+    lua_State* L,
+    std::filesystem::path const& path) -> std::optional<PipelineInfo>
 {
     if (!Script::Load(L, path))
     {
-        return false;
+        return std::nullopt;
     }
 
-    SDL_GPUGraphicsPipelineCreateInfo info{};
-    std::vector<SDL_GPUVertexBufferDescription> vertex_buffer_descriptions;
-    std::vector<SDL_GPUVertexAttribute> vertex_attributes;
-    std::vector<SDL_GPUColorTargetDescription> color_target_descriptions;
+    PipelineInfo pipeline_info{};
+    SDL_GPUGraphicsPipelineCreateInfo& info = pipeline_info.create_info;
+    std::vector<SDL_GPUVertexBufferDescription>& vertex_buffer_descriptions = pipeline_info.vertex_buffer_descriptions;
+    std::vector<SDL_GPUVertexAttribute>& vertex_attributes = pipeline_info.vertex_attributes;
+    std::vector<SDL_GPUColorTargetDescription>& color_target_descriptions = pipeline_info.color_target_descriptions;
     
     {   
         LuaTableScope pipeline_scope(L, "pipeline");
         if (!pipeline_scope.IsValid())
         {
-            return false;
+            return std::nullopt;
         }
 
-        std::string vertex_shader_name = Script::ReadStringField(L, "vertex_shader").value_or("");
-        std::string fragment_shader_name = Script::ReadStringField(L, "fragment_shader").value_or("");
-        SDL_GPUShader* vertex_shader = m_shaders[ResourceManager::Hash(vertex_shader_name)].second;
-        if (!vertex_shader)
-        {
-            SO_ERROR("Vertex shader not found: {}", vertex_shader_name);
-            return false;
-        }
-        info.vertex_shader = vertex_shader;
-        SDL_GPUShader* fragment_shader = m_shaders[ResourceManager::Hash(fragment_shader_name)].second;
-        if (!fragment_shader)
-        {
-            SO_ERROR("Fragment shader not found: {}", fragment_shader_name);
-            return false;
-        }
-        info.fragment_shader = fragment_shader;
+        // Shaders are resolved by name when the pipeline is created
+        pipeline_info.vertex_shader = Script::ReadStringField(L, "vertex_shader").value_or("");
+        pipeline_info.fragment_shader = Script::ReadStringField(L, "fragment_shader").value_or("");
 
         {   
             LuaTableScope vertex_input_state_scope(L, "vertex_input_state", false, false);
@@ -324,7 +276,7 @@ auto ResourceManager::LoadPipeline(
             LuaTableScope rasterizer_state_scope(L, "rasterizer_state", false);
             if (!rasterizer_state_scope.IsValid())
             {
-                return false;
+                return std::nullopt;
             }
 
             info.rasterizer_state.fill_mode = static_cast<SDL_GPUFillMode>(Script::ReadIntegerField(L, "fill_mode").value_or(0));
@@ -350,7 +302,7 @@ auto ResourceManager::LoadPipeline(
             LuaTableScope depth_stencil_state_scope(L, "depth_stencil_state", false, false);
             if (!depth_stencil_state_scope.IsValid())
             {
-                return false;
+                return std::nullopt;
             }
 
             info.depth_stencil_state.compare_op = static_cast<SDL_GPUCompareOp>(Script::ReadIntegerField(L, "compare_op").value_or(0));
@@ -433,115 +385,202 @@ auto ResourceManager::LoadPipeline(
         } // target_info_scope
     } // pipeline_scope
 
-    SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(m_device, &info);
-    if (!pipeline)
+    return pipeline_info;
+}
+
+auto ResourceManager::LoadComputePipelineInfo(
+    lua_State* L,
+    std::filesystem::path const& path) -> std::optional<ComputePipelineInfo>
+{
+    if (!Script::Load(L, path))
+    {
+        return std::nullopt;
+    }
+
+    ComputePipelineInfo pipeline_info{};
+    ShaderInfo& shader_info = pipeline_info.shader;
+    {
+        LuaTableScope pipeline_scope(L, "compute_pipeline");
+        if (!pipeline_scope.IsValid())
+        {
+            return std::nullopt;
+        }
+
+        shader_info.is_byte_code = Script::ReadBooleanField(L, "is_byte_code").value_or(false);
+        shader_info.source_path = ResolvePath(Script::ReadStringField(L, "source_path").value_or(""));
+        shader_info.format = static_cast<uint32_t>(Script::ReadIntegerField(L, "format").value_or(0));
+        shader_info.entry_point = Script::ReadStringField(L, "entry_point").value_or("main");
+        shader_info.num_samplers = static_cast<uint32_t>(Script::ReadIntegerField(L, "num_samplers").value_or(0));
+        shader_info.num_storage_buffers = static_cast<uint32_t>(Script::ReadIntegerField(L, "num_readonly_storage_buffers").value_or(0));
+        shader_info.num_uniform_buffers = static_cast<uint32_t>(Script::ReadIntegerField(L, "num_uniform_buffers").value_or(0));
+        pipeline_info.num_readonly_storage_textures = static_cast<uint32_t>(Script::ReadIntegerField(L, "num_readonly_storage_textures").value_or(0));
+        pipeline_info.num_readwrite_storage_textures = static_cast<uint32_t>(Script::ReadIntegerField(L, "num_readwrite_storage_textures").value_or(0));
+        pipeline_info.num_readwrite_storage_buffers = static_cast<uint32_t>(Script::ReadIntegerField(L, "num_readwrite_storage_buffers").value_or(0));
+        // Must match [numthreads] in the shader
+        pipeline_info.threadcount_x = static_cast<uint32_t>(std::max(Script::ReadIntegerField(L, "threadcount_x").value_or(1), 1));
+        pipeline_info.threadcount_y = static_cast<uint32_t>(std::max(Script::ReadIntegerField(L, "threadcount_y").value_or(1), 1));
+        pipeline_info.threadcount_z = static_cast<uint32_t>(std::max(Script::ReadIntegerField(L, "threadcount_z").value_or(1), 1));
+    } // pipeline_scope
+
+    return pipeline_info;
+}
+
+auto ResourceManager::LoadEngineConfig(lua_State* L, std::filesystem::path const& path) -> std::optional<EngineConfig>
+{
+    if (!Script::Load(L, path))
+    {
+        return std::nullopt;
+    }
+
+    EngineConfig engine_config{};
+    {
+        LuaTableScope engine_scope(L, "engine");
+        if (!engine_scope.IsValid())
+        {
+            return std::nullopt;
+        }
+        int budget_mb = Script::ReadIntegerField(L, "model_budget_mb").value_or(0);
+        engine_config.model_budget = static_cast<uint64_t>(std::max(budget_mb, 0)) << 20;
+        engine_config.script_gc_budget_ms = Script::ReadFloatingField(L, "script_gc_budget_ms").value_or(engine_config.script_gc_budget_ms);
+        int script_threads = Script::ReadIntegerField(L, "script_threads").value_or(0);
+        engine_config.script_threads = static_cast<uint32_t>(std::max(script_threads, 0));
+        int sim_rate = Script::ReadIntegerField(L, "sim_rate").value_or(static_cast<int>(engine_config.sim_rate));
+        engine_config.sim_rate = static_cast<uint32_t>(std::max(sim_rate, 1));
+        int max_sim_steps = Script::ReadIntegerField(L, "max_sim_steps").value_or(static_cast<int>(engine_config.max_sim_steps));
+        engine_config.max_sim_steps = static_cast<uint32_t>(std::max(max_sim_steps, 1));
+        engine_config.present_mode = static_cast<SDL_GPUPresentMode>(Script::ReadIntegerField(L, "present_mode").value_or(engine_config.present_mode));
+        int max_fps = Script::ReadIntegerField(L, "max_fps").value_or(0);
+        engine_config.max_fps = static_cast<uint32_t>(std::max(max_fps, 0));
+        int background_fps = Script::ReadIntegerField(L, "background_fps").value_or(static_cast<int>(engine_config.background_fps));
+        engine_config.background_fps = static_cast<uint32_t>(std::max(background_fps, 0));
+        engine_config.gpu_budget_ms = Script::ReadFloatingField(L, "gpu_budget_ms").value_or(engine_config.gpu_budget_ms);
+        engine_config.min_render_scale = Script::ReadFloatingField(L, "min_render_scale").value_or(engine_config.min_render_scale);
+        engine_config.max_render_scale = Script::ReadFloatingField(L, "max_render_scale").value_or(engine_config.max_render_scale);
+        engine_config.gpu_culling = Script::ReadBooleanField(L, "gpu_culling").value_or(engine_config.gpu_culling);
+    } // engine_scope
+
+    return engine_config;
+}
+
+auto ResourceManager::LoadModelGroup(lua_State* L, std::filesystem::path const& path) -> bool
+{
+    std::optional<std::vector<ModelSource>> sources = LoadModelGroupInfo(L, path);
+    if (!sources)
     {
-        SO_ERROR("Failed to create graphics pipeline, {}", SDL_GetError());
         return false;
     }
-    m_pipelines[ResourceManager::Hash(path.stem().string())] = pipeline;
-    SO_INFO("Pipeline loaded: {}", path.stem().string());
 
+    GLTFHelper gltf_helper{};
+    for (auto const& source : *sources)
+    {
+        gltf_helper.Load(source.path, source.clips);
+        CreateModel(source.name, gltf_helper);
+        gltf_helper.Clear();
+    }
     return true;
 }
 
-auto ResourceManager::LoadModelGroup(lua_State* L, std::filesystem::path const& path) -> bool
+auto ResourceManager::UnloadModelGroup(lua_State* L, std::filesystem::path const& path) -> bool
 {
-    if (!Script::Load(L, path))
+    std::optional<std::vector<ModelSource>> sources = LoadModelGroupInfo(L, path);
+    if (!sources)
     {
         return false;
     }
 
+    for (auto const& source : *sources)
+    {
+        UnloadModel(Hash(source.name));
+    }
+    return true;
+}
+
+auto ResourceManager::LoadModelGroupInfo(lua_State* L, std::filesystem::path const& path) -> std::optional<std::vector<ModelSource>>
+{
+    if (!Script::Load(L, path))
+    {
+        return std::nullopt;
+    }
+
+    std::vector<ModelSource> sources;
     {
         LuaTableScope model_scope(L, "model_group");
         if (!model_scope.IsValid())
         {
-            return false;
+            return std::nullopt;
         }
 
-        GLTFHelper gltf_helper{};
-
         uint32_t model_count = Script::ReadArrayLength(L);
+        sources.reserve(model_count);
         for (uint32_t i{ 0 }; i < model_count; ++i)
         {
             {   
                 LuaTableScope i_scope(L, i + 1);
                 if (i_scope.IsValid())
                 {
-                    std::string model_name = Script::ReadStringField(L, "name").value_or("");
-                    std::filesystem::path model_path = Script::ReadStringField(L, "path").value_or("");
-                    
-                    auto const& [model_size, meshes] = gltf_helper.Load(model_path);
-
-                    // prepare transfer buffer
-                    SDL_GPUTransferBufferCreateInfo transfer_buffer_info{
-                        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-                        .size = model_size,
-                    };
-                    SDL_GPUTransferBuffer* transfer_buffer = SDL_CreateGPUTransferBuffer(m_device, &transfer_buffer_info);
-                    void* transfer_buffer_data = SDL_MapGPUTransferBuffer(m_device, transfer_buffer, false);
-                    size_t transfer_buffer_offset{ 0 };
-                    
-                    ModelInfo model_info{};
-                    model_info.meshes.reserve(meshes.size());
-                    for (auto const& mesh : meshes)
-                    {
-                        MeshInfo mesh_info{};
-                        for (size_t i{ 0 }; i < mesh.attributes.size() - 1; ++i)
-                        {
-                            auto const& attribute = mesh.attributes[i];
-                            SDL_GPUBufferCreateInfo buffer_info{
-                                .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
-                                .size = static_cast<uint32_t>(attribute.byte_size),
-                            };
-                            SDL_GPUBuffer* buffer = SDL_CreateGPUBuffer(m_device, &buffer_info);
-                            mesh_info.buffers.push_back({
-                                buffer,
-                                static_cast<uint32_t>(attribute.byte_size),
-                            });
-                            SDL_SetGPUBufferName(m_device, buffer, model_name.c_str());
-                            std::memcpy(
-                                static_cast<uint8_t*>(transfer_buffer_data) + transfer_buffer_offset,
-                                attribute.data_section + attribute.byte_offset,
-                                attribute.byte_size
-                            );
-                            transfer_buffer_offset += attribute.byte_size;
-                        }
-
-                        auto const& index_buffer_attribute = mesh.attributes[2];
-                        SDL_GPUBufferCreateInfo index_buffer_info{
-                            .usage = SDL_GPU_BUFFERUSAGE_INDEX,
-                            .size = static_cast<uint32_t>(index_buffer_attribute.byte_size),
-                        };
-                        SDL_GPUBuffer* index_buffer = SDL_CreateGPUBuffer(m_device, &index_buffer_info);
-                        assert(index_buffer);
-                        mesh_info.buffers.push_back({
-                            index_buffer,
-                            static_cast<uint32_t>(index_buffer_attribute.byte_size),
-                        });
-                        mesh_info.index_count = mesh.index_count;
-                        mesh_info.index_type = mesh.index_type;
-                        SDL_SetGPUBufferName(m_device, index_buffer, model_name.c_str());
-                        std::memcpy(
-                            static_cast<uint8_t*>(transfer_buffer_data) + transfer_buffer_offset,
-                            index_buffer_attribute.data_section + index_buffer_attribute.byte_offset,
-                            index_buffer_attribute.byte_size
-                        );
-                        transfer_buffer_offset += index_buffer_attribute.byte_size;
-
-                        model_info.meshes.push_back(mesh_info);
-                    }
-
-                    SDL_UnmapGPUTransferBuffer(m_device, transfer_buffer);
-                    model_info.transfer_buffer = transfer_buffer;
-
-                    m_models[ResourceManager::Hash(model_name)] = model_info;
-                    
-                    gltf_helper.Clear();
+                    sources.push_back({
+                        .name = Script::ReadStringField(L, "name").value_or(""),
+                        .path = ResolvePath(Script::ReadStringField(L, "path").value_or("")),
+                        .clips = ResolvePath(Script::ReadStringField(L, "clips").value_or("")),
+                    });
                 }
             } // i_scope
         }
     } // model_scope
     
+    return sources;
+}
+
+auto ResourceManager::CreateModel(std::string const& model_name, GLTFHelper const& gltf_helper) -> bool
+{
+    uint32_t model_size = gltf_helper.GetTotalSize();
+    auto const& meshes = gltf_helper.GetMeshes();
+    if (model_size == 0)
+    {
+        SO_ERROR("Model has no mesh data: {}", model_name);
+        return false;
+    }
+
+    // Only the CPU side copy is made here, GPU buffers are created when the
+    // model is first used and again after every eviction.
+    ModelInfo model_info{};
+    model_info.name = model_name;
+    model_info.bounds = gltf_helper.GetBounds();
+    model_info.skin = gltf_helper.GetSkin();
+    model_info.cpu_data.reserve(model_size);
+    model_info.meshes.reserve(meshes.size());
+    auto append = [&model_info](auto const& attribute)
+    {
+        auto const* data = attribute.data_section + attribute.byte_offset;
+        model_info.cpu_data.insert(model_info.cpu_data.end(), data, data + attribute.byte_size);
+    };
+    for (auto const& mesh : meshes)
+    {
+        MeshInfo mesh_info{};
+        for (size_t i{ 0 }; i < mesh.attributes.size() - 1; ++i)
+        {
+            auto const& attribute = mesh.attributes[i];
+            mesh_info.buffers.push_back({
+                nullptr,
+                static_cast<uint32_t>(attribute.byte_size),
+            });
+            append(attribute);
+        }
+
+        // Index buffer is always last
+        auto const& index_buffer_attribute = mesh.attributes.back();
+        mesh_info.buffers.push_back({
+            nullptr,
+            static_cast<uint32_t>(index_buffer_attribute.byte_size),
+        });
+        mesh_info.index_count = mesh.index_count;
+        mesh_info.index_type = mesh.index_type;
+        append(index_buffer_attribute);
+
+        model_info.meshes.push_back(mesh_info);
+    }
+
+    StoreModel(model_name, std::move(model_info));
+
     return true;
 }
\ No newline at end of file
@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <chrono>
+#include "ScriptRuntime.hpp"
+#include "Logger.hpp"
+#include "Profiler.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    auto ElapsedMs(Clock::time_point start) -> double
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+ScriptRuntime::ScriptRuntime(std::filesystem::path const& dir, size_t lanes)
+    : m_pool("scripts", lanes, LuaAllocatorMode::Pooled, [](lua_State* L)
+    {
+        // Incremental mode, but only StepGC drives it
+        lua_gc(L, LUA_GCINC, 0, 0, 0);
+        lua_gc(L, LUA_GCSTOP);
+
+        lua_register(L, "wait", LuaWait);
+        lua_register(L, "wait_event", LuaWaitEvent);
+        lua_register(L, "log", LuaLog);
+    })
+{
+    m_lanes.resize(m_pool.Size());
+    for (auto& lane : m_lanes)
+    {
+        lane = std::make_unique<Lane>();
+        lane->dir = dir;
+    }
+}
+
+ScriptRuntime::~ScriptRuntime() = default;
+
+auto ScriptRuntime::Spawn(std::string const& script, uint64_t entity) -> TaskID
+{
+    // The lane is encoded in the id so Kill can route it
+    auto lane_count = static_cast<TaskID>(m_lanes.size());
+    auto lane = static_cast<TaskID>(entity % lane_count);
+    TaskID id = m_next_id++ * lane_count + lane;
+    m_lanes[lane]->spawns.push_back({ id, script, entity });
+    return id;
+}
+
+void ScriptRuntime::Kill(TaskID id)
+{
+    m_lanes[id % m_lanes.size()]->kills.push_back(id);
+}
+
+void ScriptRuntime::Emit(std::string const& event)
+{
+    for (auto& lane : m_lanes)
+    {
+        lane->events.push_back(event);
+    }
+}
+
+void ScriptRuntime::Update()
+{
+    SO_PROFILE_ZONE("Scripts");
+    RunLanes([](Lane& lane) { lane.Update(); });
+
+    // Every lane sees emit() from any lane, next frame
+    for (auto& lane : m_lanes)
+    {
+        for (auto const& event : lane->outbox)
+        {
+            Emit(event);
+        }
+        lane->outbox.clear();
+    }
+}
+
+void ScriptRuntime::StepGC(double budget_ms)
+{
+    SO_PROFILE_ZONE("Script GC");
+    RunLanes([budget_ms](Lane& lane) { lane.StepGC(budget_ms); });
+    m_pool.UpdateRates();
+}
+
+auto ScriptRuntime::TaskCount() const -> size_t
+{
+    size_t count{ 0 };
+    for (auto const& lane : m_lanes)
+    {
+        count += lane->tasks.size() + lane->spawns.size();
+    }
+    return count;
+}
+
+auto ScriptRuntime::GetStats() const -> std::map<std::string, ScriptStats>
+{
+    std::map<std::string, ScriptStats> merged;
+    for (auto const& lane : m_lanes)
+    {
+        for (auto const& [script, stats] : lane->stats)
+        {
+            ScriptStats& total = merged[script];
+            total.resumes += stats.resumes;
+            total.total_ms += stats.total_ms;
+            total.frame_ms += stats.frame_ms;
+            total.peak_frame_ms = std::max(total.peak_frame_ms, stats.peak_frame_ms);
+        }
+    }
+    return merged;
+}
+
+auto ScriptRuntime::GetGCStats() const -> ScriptGCStats
+{
+    ScriptGCStats total{};
+    for (auto const& lane : m_lanes)
+    {
+        total.step_ms = std::max(total.step_ms, lane->gc.step_ms);
+        total.cycles += lane->gc.cycles;
+        total.memory_kb += lane->gc.memory_kb;
+    }
+    return total;
+}
+
+void ScriptRuntime::LogStats() const
+{
+    for (auto const& [script, stats] : GetStats())
+    {
+        SO_INFO("Script {}: {} resumes, {:.3f} ms total, {:.3f} ms peak frame",
+            script, stats.resumes, stats.total_ms, stats.peak_frame_ms);
+    }
+    ScriptGCStats gc = GetGCStats();
+    SO_INFO("Script GC: {} cycles, {} KB in use over {} lanes", gc.cycles, gc.memory_kb, m_lanes.size());
+    m_pool.LogStats();
+}
+
+void ScriptRuntime::RunLanes(std::function<void(Lane&)> const& fn)
+{
+    std::vector<std::future<void>> done;
+    done.reserve(m_lanes.size());
+    for (size_t i{ 0 }; i < m_lanes.size(); ++i)
+    {
+        Lane* lane = m_lanes[i].get();
+        done.push_back(m_pool.SubmitTo(i, [lane, &fn](lua_State* L)
+        {
+            lane->Bind(L);
+            fn(*lane);
+        }));
+    }
+    for (auto& lane_done : done)
+    {
+        lane_done.get();
+    }
+}
+
+void ScriptRuntime::Lane::Bind(lua_State* L)
+{
+    if (lua)
+    {
+        return;
+    }
+    lua = L;
+    lua_pushlightuserdata(lua, this);
+    lua_pushcclosure(lua, LuaEmit, 1);
+    lua_setglobal(lua, "emit");
+}
+
+void ScriptRuntime::Lane::Update()
+{
+    SO_PROFILE_ZONE("Script lane");
+    for (auto& [_, script_stats] : stats)
+    {
+        script_stats.frame_ms = 0.0;
+    }
+
+    for (auto const& spawn : spawns)
+    {
+        Start(spawn);
+    }
+    spawns.clear();
+    for (TaskID id : kills)
+    {
+        if (tasks.contains(id))
+        {
+            Finish(id);
+        }
+    }
+    kills.clear();
+    for (auto const& event : events)
+    {
+        Deliver(event);
+    }
+    events.clear();
+
+    while (!wakes.empty() && wakes.top().first <= frame)
+    {
+        auto [wake_frame, id] = wakes.top();
+        wakes.pop();
+
+        // Killed, or rescheduled since this entry was pushed
+        auto task = tasks.find(id);
+        if (task == tasks.end() || task->second.wake_frame != wake_frame || !task->second.event.empty())
+        {
+            continue;
+        }
+        Resume(id);
+    }
+
+    for (auto& [_, script_stats] : stats)
+    {
+        script_stats.peak_frame_ms = std::max(script_stats.peak_frame_ms, script_stats.frame_ms);
+    }
+    ++frame;
+}
+
+void ScriptRuntime::Lane::StepGC(double budget_ms)
+{
+    SO_PROFILE_ZONE("Script lane GC");
+    auto start = Clock::now();
+    do
+    {
+        if (lua_gc(lua, LUA_GCSTEP, 0))
+        {
+            ++gc.cycles;
+            break;
+        }
+    } while (ElapsedMs(start) < budget_ms);
+
+    gc.step_ms = ElapsedMs(start);
+    gc.memory_kb = static_cast<uint32_t>(lua_gc(lua, LUA_GCCOUNT));
+}
+
+void ScriptRuntime::Lane::Deliver(std::string const& event)
+{
+    auto event_waiters = waiters.find(event);
+    if (event_waiters == waiters.end())
+    {
+        return;
+    }
+    std::vector<TaskID> ids = std::move(event_waiters->second);
+    waiters.erase(event_waiters);
+
+    for (TaskID id : ids)
+    {
+        auto task = tasks.find(id);
+        if (task != tasks.end() && task->second.event == event)
+        {
+            task->second.event.clear();
+            Schedule(id, task->second, frame);
+        }
+    }
+}
+
+auto ScriptRuntime::Lane::LoadScript(std::string const& script) -> int
+{
+    if (auto loaded = scripts.find(script); loaded != scripts.end())
+    {
+        return loaded->second;
+    }
+
+    std::filesystem::path path = dir/(script + ".lua");
+    if (luaL_loadfile(lua, path.c_str()) || lua_pcall(lua, 0, 1, 0))
+    {
+        SO_ERROR("Error loading script: {}", lua_tostring(lua, -1));
+        lua_pop(lua, 1);
+        return LUA_NOREF;
+    }
+    if (!lua_isfunction(lua, -1))
+    {
+        SO_ERROR("Script does not return a function: {}", path.string());
+        lua_pop(lua, 1);
+        return LUA_NOREF;
+    }
+
+    int function_ref = luaL_ref(lua, LUA_REGISTRYINDEX);
+    scripts[script] = function_ref;
+    return function_ref;
+}
+
+void ScriptRuntime::Lane::Start(SpawnMessage const& spawn)
+{
+    int function_ref = LoadScript(spawn.script);
+    if (function_ref == LUA_NOREF)
+    {
+        return;
+    }
+
+    lua_State* thread = lua_newthread(lua);
+    int thread_ref = luaL_ref(lua, LUA_REGISTRYINDEX);
+    lua_rawgeti(lua, LUA_REGISTRYINDEX, function_ref);
+    lua_xmove(lua, thread, 1);
+    lua_pushinteger(thread, static_cast<lua_Integer>(spawn.entity));
+
+    Task& task = tasks[spawn.id];
+    task = {
+        .script = spawn.script,
+        .thread = thread,
+        .thread_ref = thread_ref,
+        .wake_frame = 0,
+        .event = {},
+        .started = false,
+    };
+    Schedule(spawn.id, task, frame);
+}
+
+void ScriptRuntime::Lane::Resume(TaskID id)
+{
+    Task& task = tasks.at(id);
+    int nargs = task.started ? 0 : 1;
+    task.started = true;
+
+    int nresults{ 0 };
+    auto start = Clock::now();
+    int status = lua_resume(task.thread, lua, nargs, &nresults);
+    double ms = ElapsedMs(start);
+
+    ScriptStats& script_stats = stats[task.script];
+    ++script_stats.resumes;
+    script_stats.total_ms += ms;
+    script_stats.frame_ms += ms;
+
+    if (status == LUA_OK)
+    {
+        Finish(id);
+        return;
+    }
+    if (status != LUA_YIELD)
+    {
+        luaL_traceback(lua, task.thread, lua_tostring(task.thread, -1), 0);
+        SO_ERROR("Script {} failed: {}", task.script, lua_tostring(lua, -1));
+        lua_pop(lua, 1);
+        Finish(id);
+        return;
+    }
+
+    if (nresults > 0 && lua_type(task.thread, -1) == LUA_TSTRING)
+    {
+        task.event = lua_tostring(task.thread, -1);
+        waiters[task.event].push_back(id);
+    }
+    else
+    {
+        lua_Integer frames = nresults > 0 && lua_isinteger(task.thread, -1) ? lua_tointeger(task.thread, -1) : 1;
+        Schedule(id, task, frame + static_cast<uint64_t>(std::max<lua_Integer>(frames, 1)));
+    }
+    lua_pop(task.thread, nresults);
+}
+
+void ScriptRuntime::Lane::Finish(TaskID id)
+{
+    auto task = tasks.find(id);
+    lua_closethread(task->second.thread, lua);
+    luaL_unref(lua, LUA_REGISTRYINDEX, task->second.thread_ref);
+    tasks.erase(task);
+}
+
+void ScriptRuntime::Lane::Schedule(TaskID id, Task& task, uint64_t wake_frame)
+{
+    task.wake_frame = wake_frame;
+    wakes.push({ wake_frame, id });
+}
+
+auto ScriptRuntime::LuaWait(lua_State* L) -> int
+{
+    lua_Integer frames = luaL_optinteger(L, 1, 1);
+    lua_settop(L, 0);
+    lua_pushinteger(L, frames);
+    return lua_yield(L, 1);
+}
+
+auto ScriptRuntime::LuaWaitEvent(lua_State* L) -> int
+{
+    luaL_checkstring(L, 1);
+    lua_settop(L, 1);
+    return lua_yield(L, 1);
+}
+
+auto ScriptRuntime::LuaEmit(lua_State* L) -> int
+{
+    auto* lane = static_cast<Lane*>(lua_touserdata(L, lua_upvalueindex(1)));
+    lane->outbox.push_back(luaL_checkstring(L, 1));
+    return 0;
+}
+
+auto ScriptRuntime::LuaLog(lua_State* L) -> int
+{
+    SO_INFO("[lua] {}", luaL_tolstring(L, 1, nullptr));
+    lua_pop(L, 1);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+#include <map>
+#include <queue>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <unordered_map>
+#include <lua.hpp>
+#include "LuaStatePool.hpp"
+
+struct ScriptStats
+{
+    uint64_t resumes{ 0 };
+    double   total_ms{ 0.0 };
+    double   frame_ms{ 0.0 }; // current frame
+    double   peak_frame_ms{ 0.0 };
+};
+
+struct ScriptGCStats
+{
+    double   step_ms{ 0.0 }; // last StepGC, slowest lane
+    uint32_t cycles{ 0 };
+    uint32_t memory_kb{ 0 };
+};
+
+// Gameplay scripts running as coroutines. A script in `dir` returns a
+// function that receives the entity id, and may call
+//   wait(n)            resume after n frames, 1 by default
+//   wait_event(name)   resume after the next emit(name) / Emit(name)
+//   emit(name)         wake every task waiting for name, next frame
+//   log(message)
+// Tasks are spread over lanes by entity. Each lane is a Lua state on its
+// own pool worker and lanes update in parallel, sharing nothing: spawns,
+// kills and events reach a lane as messages at the start of Update.
+// Only due tasks are resumed. The collector never runs on its own,
+// StepGC advances it within a time budget once per frame.
+class ScriptRuntime
+{
+public:
+    using TaskID = uint32_t;
+
+    ScriptRuntime(std::filesystem::path const& dir, size_t lanes);
+    ~ScriptRuntime();
+    ScriptRuntime(ScriptRuntime const&) = delete;
+    auto operator = (ScriptRuntime const&) -> ScriptRuntime& = delete;
+
+    // Starts on the next Update, tasks of one entity share a lane
+    auto Spawn(std::string const& script, uint64_t entity) -> TaskID;
+    void Kill(TaskID task);
+    void Emit(std::string const& event);
+
+    void Update();
+    void StepGC(double budget_ms);
+
+    [[nodiscard]] auto LaneCount() const -> size_t { return m_lanes.size(); }
+    [[nodiscard]] auto TaskCount() const -> size_t;
+    [[nodiscard]] auto GetStats() const -> std::map<std::string, ScriptStats>;
+    [[nodiscard]] auto GetGCStats() const -> ScriptGCStats;
+    [[nodiscard]] auto GetMemoryStats(size_t lane) const -> LuaMemoryStats const& { return m_pool.GetMemoryStats(lane); }
+    void LogStats() const;
+private:
+    struct Task
+    {
+        std::string script;
+        lua_State*  thread;
+        int         thread_ref;
+        uint64_t    wake_frame;
+        std::string event; // waited for, empty when waiting on frames
+        bool        started;
+    };
+
+    struct SpawnMessage
+    {
+        TaskID      id;
+        std::string script;
+        uint64_t    entity;
+    };
+
+    // Everything living in one Lua state. Only its pool worker touches it
+    // during Update and StepGC, the main thread in between.
+    struct Lane
+    {
+        using Wake = std::pair<uint64_t, TaskID>; // frame, task
+
+        std::filesystem::path                                 dir;
+        lua_State*                                            lua{ nullptr };
+        std::unordered_map<std::string, int>                  scripts; // name -> function ref
+        std::unordered_map<TaskID, Task>                      tasks;
+        std::priority_queue<Wake, std::vector<Wake>, std::greater<Wake>> wakes;
+        std::unordered_map<std::string, std::vector<TaskID>>  waiters;
+        uint64_t                                              frame{ 0 };
+
+        // Inbox, filled by the main thread
+        std::vector<SpawnMessage>                             spawns;
+        std::vector<TaskID>                                   kills;
+        std::vector<std::string>                              events;
+        // emit() calls, broadcast after the update
+        std::vector<std::string>                              outbox;
+
+        std::map<std::string, ScriptStats>                    stats;
+        ScriptGCStats                                         gc;
+
+        void Bind(lua_State* L);
+        void Update();
+        void StepGC(double budget_ms);
+        void Deliver(std::string const& event);
+        auto LoadScript(std::string const& script) -> int;
+        void Start(SpawnMessage const& spawn);
+        void Resume(TaskID id);
+        void Finish(TaskID id);
+        void Schedule(TaskID id, Task& task, uint64_t wake_frame);
+    };
+
+    void RunLanes(std::function<void(Lane&)> const& fn);
+
+    static auto LuaWait(lua_State* L) -> int;
+    static auto LuaWaitEvent(lua_State* L) -> int;
+    static auto LuaEmit(lua_State* L) -> int;
+    static auto LuaLog(lua_State* L) -> int;
+private:
+    // Declared first, the pool closes the states before lanes go away
+    std::vector<std::unique_ptr<Lane>> m_lanes;
+    LuaStatePool                       m_pool;
+    TaskID                             m_next_id{ 1 };
+};
\ No newline at end of file
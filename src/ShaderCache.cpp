@@ -0,0 +1,360 @@
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+#include "ShaderCache.hpp"
+#include "ResourceManager.hpp"
+#include "Logger.hpp"
+#include "Hash.hpp"
+
+namespace {
+    // Bump when the slangc command line changes in a way that affects output.
+    constexpr uint32_t s_cache_version{ 1 };
+
+    auto ReadText(std::filesystem::path const& path) -> std::optional<std::string>
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return std::nullopt;
+        }
+        std::stringstream stream;
+        stream << file.rdbuf();
+        return stream.str();
+    }
+
+    auto Trim(std::string_view str) -> std::string_view
+    {
+        size_t begin = str.find_first_not_of(" \t\r");
+        if (begin == std::string_view::npos)
+        {
+            return {};
+        }
+        size_t end = str.find_last_not_of(" \t\r;");
+        return str.substr(begin, end - begin + 1);
+    }
+
+    auto Unquote(std::string_view str) -> std::string_view
+    {
+        if (str.size() >= 2 && str.front() == '"' && str.back() == '"')
+        {
+            return str.substr(1, str.size() - 2);
+        }
+        return str;
+    }
+
+    // Collect `import a.b;`, `__include a;` and `#include "a.slang"` references.
+    auto ParseDependencies(std::string const& source, std::filesystem::path const& dir) -> std::vector<std::filesystem::path>
+    {
+        std::vector<std::filesystem::path> dependencies;
+        std::istringstream stream(source);
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            std::string_view statement = Trim(line);
+            if (statement.starts_with("#include"))
+            {
+                statement = Trim(statement.substr(8));
+                dependencies.push_back(dir/Unquote(statement));
+            }
+            else if (statement.starts_with("import ") || statement.starts_with("__include "))
+            {
+                statement = Unquote(Trim(statement.substr(statement.find(' '))));
+                std::string module{ statement };
+                if (!module.ends_with(".slang"))
+                {
+                    std::replace(module.begin(), module.end(), '.', '/');
+                    module += ".slang";
+                }
+                std::filesystem::path candidate = dir/module;
+                if (!std::filesystem::exists(candidate))
+                {
+                    // slangc also resolves `a_b` as `a-b.slang`
+                    std::replace(module.begin(), module.end(), '_', '-');
+                    candidate = dir/module;
+                }
+                dependencies.push_back(candidate);
+            }
+        }
+        return dependencies;
+    }
+
+    // Run a shell command, capturing stdout and stderr into `output`.
+    auto RunProcess(std::string const& command, std::string& output) -> int
+    {
+#ifdef _WIN32
+        FILE* pipe = _popen((command + " 2>&1").c_str(), "r");
+#else
+        FILE* pipe = popen((command + " 2>&1").c_str(), "r");
+#endif
+        if (!pipe)
+        {
+            output = "Failed to spawn process";
+            return -1;
+        }
+
+        char buffer[512];
+        size_t count{ 0 };
+        while ((count = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+        {
+            output.append(buffer, count);
+        }
+
+#ifdef _WIN32
+        return _pclose(pipe);
+#else
+        int status = pclose(pipe);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+    }
+}
+
+ShaderCache::ShaderCache(std::filesystem::path const& cache_dir)
+    : m_cache_dir(cache_dir)
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_cache_dir, error);
+    if (error)
+    {
+        SO_WARN("Failed to create shader cache directory {}: {}", m_cache_dir.string(), error.message());
+    }
+}
+
+auto ShaderCache::Key(SlangcCompileOption const& option) const -> uint64_t
+{
+    std::set<std::filesystem::path> visited;
+    uint64_t key = Fnv1a::HashValue(s_cache_version);
+    key = HashFileTree(option.input_file, key, visited);
+    key = Fnv1a::Hash(option.entry_point, key);
+    key = Fnv1a::HashValue(option.stage, key);
+    key = Fnv1a::HashValue(option.compute, key);
+    key = Fnv1a::HashValue(option.format, key);
+    key = Fnv1a::HashValue(option.optimization_level, key);
+    key = Fnv1a::HashValue(option.debug_level, key);
+    return key;
+}
+
+auto ShaderCache::EntryPath(SlangcCompileOption const& option, uint64_t key) const -> std::filesystem::path
+{
+    return m_cache_dir/std::format(
+        "{}.{}.{:016x}.{}",
+        option.input_file.stem().string(),
+        option.entry_point,
+        key,
+        FormatSuffix(option.format));
+}
+
+auto ShaderCache::Contains(std::filesystem::path const& entry) const -> bool
+{
+    std::error_code error;
+    return std::filesystem::is_regular_file(entry, error) && std::filesystem::file_size(entry, error) > 0;
+}
+
+void ShaderCache::CompileAll(std::vector<ShaderCompileJob>& jobs)
+{
+    if (jobs.empty())
+    {
+        return;
+    }
+
+    // Jobs with the same cache entry would write and rename the same temp
+    // file at once, only the first one runs and the others take its result
+    std::vector<size_t> first_job(jobs.size());
+    std::map<std::filesystem::path, size_t> entries;
+    for (size_t i{ 0 }; i < jobs.size(); ++i)
+    {
+        first_job[i] = entries.try_emplace(jobs[i].entry, i).first->second;
+    }
+
+    // Commands are built up front, slangc option validation logs on this thread.
+    std::vector<std::optional<std::string>> commands(jobs.size());
+    for (size_t i{ 0 }; i < jobs.size(); ++i)
+    {
+        if (first_job[i] != i)
+        {
+            continue;
+        }
+        std::filesystem::path temp_path = jobs[i].entry;
+        temp_path += ".tmp";
+        jobs[i].option.output_file = temp_path;
+        commands[i] = ResourceManager::SlangcCommand(jobs[i].option);
+    }
+
+    uint32_t max_processes = m_max_processes;
+    if (max_processes == 0)
+    {
+        max_processes = std::max(1u, std::thread::hardware_concurrency());
+    }
+    uint32_t worker_count = std::min(max_processes, static_cast<uint32_t>(entries.size()));
+
+    auto begin = std::chrono::steady_clock::now();
+    std::atomic<size_t> next_job{ 0 };
+    auto worker = [&]()
+    {
+        for (size_t i = next_job++; i < jobs.size(); i = next_job++)
+        {
+            if (commands[i])
+            {
+                RunJob(jobs[i], *commands[i]);
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(worker_count - 1);
+    for (uint32_t i{ 1 }; i < worker_count; ++i)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    for (size_t i{ 0 }; i < jobs.size(); ++i)
+    {
+        ShaderCompileJob& job = jobs[i];
+        if (first_job[i] != i)
+        {
+            ShaderCompileJob const& first = jobs[first_job[i]];
+            job.output = first.output;
+            job.milliseconds = first.milliseconds;
+            job.succeeded = first.succeeded;
+            continue;
+        }
+        if (job.succeeded)
+        {
+            SO_INFO("Shader compiled: {} [{}] ({:.1f} ms)",
+                job.option.input_file.string(),
+                job.option.entry_point,
+                job.milliseconds);
+            if (!job.output.empty())
+            {
+                SO_WARN("slangc output for {}:\n{}", job.option.input_file.string(), job.output);
+            }
+        }
+        else
+        {
+            RecordFailure();
+            SO_ERROR("Failed to compile: {} [{}]\n{}",
+                job.option.input_file.string(),
+                job.option.entry_point,
+                job.output);
+        }
+    }
+    SO_INFO("Compiled {} shaders on {} processes in {:.1f} ms", entries.size(), worker_count, total_ms);
+}
+
+auto ShaderCache::GetStats() const -> ShaderCacheStats
+{
+    return {
+        .hits = m_hits.load(std::memory_order_relaxed),
+        .misses = m_misses.load(std::memory_order_relaxed),
+        .failures = m_failures.load(std::memory_order_relaxed),
+    };
+}
+
+void ShaderCache::LogStats() const
+{
+    ShaderCacheStats stats = GetStats();
+    SO_INFO("Shader cache: {} hits, {} misses, {} failed ({})",
+        stats.hits,
+        stats.misses,
+        stats.failures,
+        m_cache_dir.string());
+}
+
+auto ShaderCache::FormatSuffix(SDL_GPUShaderFormat format) -> char const*
+{
+    switch (format)
+    {
+    case SDL_GPU_SHADERFORMAT_SPIRV:
+        return "spv";
+    case SDL_GPU_SHADERFORMAT_MSL:
+        return "metal";
+    default:
+        return "bin";
+    }
+}
+
+auto ShaderCache::Dependencies(std::filesystem::path const& file) -> std::vector<std::filesystem::path>
+{
+    std::vector<std::filesystem::path> files{ file.lexically_normal() };
+    std::set<std::filesystem::path> visited{ files.front() };
+    for (size_t i{ 0 }; i < files.size(); ++i)
+    {
+        std::optional<std::string> source = ReadText(files[i]);
+        if (!source)
+        {
+            continue;
+        }
+        for (auto const& dependency : ParseDependencies(*source, files[i].parent_path()))
+        {
+            if (visited.insert(dependency.lexically_normal()).second)
+            {
+                files.push_back(dependency.lexically_normal());
+            }
+        }
+    }
+    return files;
+}
+
+void ShaderCache::RunJob(ShaderCompileJob& job, std::string const& command)
+{
+    auto begin = std::chrono::steady_clock::now();
+    int result = RunProcess(command, job.output);
+    job.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    std::error_code error;
+    if (result != 0)
+    {
+        std::filesystem::remove(job.option.output_file, error);
+        return;
+    }
+
+    std::filesystem::rename(job.option.output_file, job.entry, error);
+    if (error)
+    {
+        job.output += std::format("Failed to store shader cache entry {}: {}", job.entry.string(), error.message());
+        std::filesystem::remove(job.option.output_file, error);
+        return;
+    }
+    job.succeeded = true;
+}
+
+auto ShaderCache::HashFileTree(
+    std::filesystem::path const& file,
+    uint64_t seed,
+    std::set<std::filesystem::path>& visited) const -> uint64_t
+{
+    std::filesystem::path normalized = file.lexically_normal();
+    if (!visited.insert(normalized).second)
+    {
+        return seed;
+    }
+
+    uint64_t hash = Fnv1a::Hash(normalized.filename().string(), seed);
+    std::optional<std::string> source = ReadText(normalized);
+    if (!source)
+    {
+        // Missing files still contribute their name so the key stays stable.
+        return hash;
+    }
+
+    hash = Fnv1a::Hash(*source, hash);
+    for (auto const& dependency : ParseDependencies(*source, normalized.parent_path()))
+    {
+        hash = HashFileTree(dependency, hash, visited);
+    }
+    return hash;
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+#include <set>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <SDL3/SDL_gpu.h>
+
+enum class ShaderOptimizationLevel
+{
+    None    = 0,
+    Default = 1,
+    High    = 2,
+    Maximal = 3
+};
+
+enum class ShaderDebugLevel
+{
+    None     = 0,
+    Minimal  = 1,
+    Standard = 2,
+    Maximal  = 3
+};
+
+struct SlangcCompileOption
+{
+    std::filesystem::path   input_file;
+    std::filesystem::path   output_file;
+    std::string             entry_point;
+    SDL_GPUShaderStage      stage;
+    bool                    compute{ false }; // stage is ignored
+    SDL_GPUShaderFormat     format;
+    ShaderOptimizationLevel optimization_level{ ShaderOptimizationLevel::Default };
+    ShaderDebugLevel        debug_level{ ShaderDebugLevel::None };
+};
+
+struct ShaderCompileJob
+{
+    SlangcCompileOption   option;
+    std::filesystem::path entry;
+    std::string           output; // captured slangc stdout/stderr
+    double                milliseconds{ 0.0 };
+    bool                  succeeded{ false };
+};
+
+struct ShaderCacheStats
+{
+    uint32_t hits{ 0 };
+    uint32_t misses{ 0 };
+    uint32_t failures{ 0 };
+};
+
+// On-disk cache of slangc outputs. Entries are keyed by the shader source,
+// every file it transitively imports/includes and all compile options, so
+// a hit can be loaded directly without spawning slangc.
+class ShaderCache
+{
+public:
+             ShaderCache() = default;
+    explicit ShaderCache(std::filesystem::path const& cache_dir);
+
+    // Compile key for the option, `output_file` is ignored.
+    [[nodiscard]] auto Key(SlangcCompileOption const& option) const -> uint64_t;
+    [[nodiscard]] auto EntryPath(SlangcCompileOption const& option, uint64_t key) const -> std::filesystem::path;
+    [[nodiscard]] auto Contains(std::filesystem::path const& entry) const -> bool;
+
+    // Compile all jobs into the cache on a bounded pool of slangc processes.
+    // Output of each job is captured separately and logged once all are done.
+    // Jobs sharing a cache entry compile once and share the result.
+    void CompileAll(std::vector<ShaderCompileJob>& jobs);
+
+    // Also called from the hot reload thread
+    void RecordHit()     { m_hits.fetch_add(1, std::memory_order_relaxed); }
+    void RecordMiss()    { m_misses.fetch_add(1, std::memory_order_relaxed); }
+    void RecordFailure() { m_failures.fetch_add(1, std::memory_order_relaxed); }
+    [[nodiscard]] auto GetStats() const -> ShaderCacheStats;
+    void LogStats() const;
+
+    void SetMaxProcesses(uint32_t count) { m_max_processes = count; }
+
+    [[nodiscard]] static auto FormatSuffix(SDL_GPUShaderFormat format) -> char const*;
+    // The file itself plus every file it transitively imports/includes.
+    [[nodiscard]] static auto Dependencies(std::filesystem::path const& file) -> std::vector<std::filesystem::path>;
+private:
+    // Compile into a temporary file and move it in place only on success,
+    // so an interrupted compile never leaves a truncated cache entry.
+    static void RunJob(ShaderCompileJob& job, std::string const& command);
+
+    auto HashFileTree(
+        std::filesystem::path const& file,
+        uint64_t seed,
+        std::set<std::filesystem::path>& visited) const -> uint64_t;
+private:
+    std::filesystem::path m_cache_dir;
+    std::atomic<uint32_t> m_hits{ 0 };
+    std::atomic<uint32_t> m_misses{ 0 };
+    std::atomic<uint32_t> m_failures{ 0 };
+    uint32_t              m_max_processes{ 0 }; // 0: one per hardware thread
+};
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include <new>
+#include <bit>
+#include <cassert>
+#include "World.hpp"
+
+namespace {
+    constexpr size_t s_chunk_alignment{ 64 };
+
+    auto AlignUp(size_t size, size_t alignment) -> size_t
+    {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    auto Registry() -> std::array<ComponentInfo, World::s_max_components>&
+    {
+        static std::array<ComponentInfo, World::s_max_components> components{};
+        return components;
+    }
+
+    std::mutex s_registry_mutex;
+    uint32_t s_component_count{ 0 };
+
+    void FreeChunk(std::byte* data)
+    {
+        ::operator delete[](data, std::align_val_t{ s_chunk_alignment });
+    }
+}
+
+World::~World()
+{
+    for (auto& archetype : m_archetypes)
+    {
+        for (auto& chunk : archetype->chunks)
+        {
+            for (uint32_t id : archetype->components)
+            {
+                ComponentInfo const& info = GetComponentInfo(id);
+                for (uint32_t row{ 0 }; row < chunk.count; ++row)
+                {
+                    info.destroy(chunk.data.get() + archetype->offsets[id] + row * info.size);
+                }
+            }
+        }
+    }
+}
+
+void World::Destroy(Entity entity)
+{
+    Record* record = m_entities.Get(entity);
+    if (!record)
+    {
+        return;
+    }
+
+    Archetype& archetype = *m_archetypes[record->archetype];
+    Chunk& chunk = archetype.chunks[record->chunk];
+    for (uint32_t id : archetype.components)
+    {
+        ComponentInfo const& info = GetComponentInfo(id);
+        info.destroy(chunk.data.get() + archetype.offsets[id] + record->row * info.size);
+    }
+    Vacate(*record);
+    (void)m_entities.Release(entity);
+}
+
+void World::Flush()
+{
+    std::vector<std::function<void(World&)>> commands;
+    {
+        std::lock_guard lock(m_commands_mutex);
+        commands.swap(m_commands);
+    }
+    for (auto& command : commands)
+    {
+        command(*this);
+    }
+}
+
+auto World::RegisterComponent(ComponentInfo info) -> uint32_t
+{
+    std::lock_guard lock(s_registry_mutex);
+    assert(s_component_count < s_max_components && "Too many component types");
+    assert(info.alignment <= s_chunk_alignment);
+    Registry()[s_component_count] = info;
+    return s_component_count++;
+}
+
+auto World::GetComponentInfo(uint32_t id) -> ComponentInfo const&
+{
+    return Registry()[id];
+}
+
+auto World::FindArchetype(ComponentMask mask) -> uint32_t
+{
+    if (uint32_t const* index = m_archetype_masks.Find(mask))
+    {
+        return *index;
+    }
+
+    auto archetype = std::make_unique<Archetype>();
+    archetype->mask = mask;
+    size_t row_size = sizeof(Entity);
+    for (ComponentMask bits = mask; bits != 0; bits &= bits - 1)
+    {
+        auto id = static_cast<uint32_t>(std::countr_zero(bits));
+        archetype->components.push_back(id);
+        row_size += GetComponentInfo(id).size;
+    }
+
+    // Shrink until the padded columns fit
+    for (size_t capacity = s_chunk_size / row_size; capacity > 0; --capacity)
+    {
+        size_t offset = sizeof(Entity) * capacity;
+        for (uint32_t id : archetype->components)
+        {
+            ComponentInfo const& info = GetComponentInfo(id);
+            offset = AlignUp(offset, info.alignment);
+            archetype->offsets[id] = static_cast<uint32_t>(offset);
+            offset += info.size * capacity;
+        }
+        if (offset <= s_chunk_size)
+        {
+            archetype->capacity = static_cast<uint32_t>(capacity);
+            break;
+        }
+    }
+    assert(archetype->capacity > 0 && "Components do not fit in a chunk");
+
+    auto index = static_cast<uint32_t>(m_archetypes.size());
+    m_archetypes.push_back(std::move(archetype));
+    m_archetype_masks.Assign(mask, index);
+    return index;
+}
+
+auto World::AllocateRow(uint32_t archetype_index, Entity entity) -> Record
+{
+    Archetype& archetype = *m_archetypes[archetype_index];
+    if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.capacity)
+    {
+        auto* data = static_cast<std::byte*>(::operator new[](s_chunk_size, std::align_val_t{ s_chunk_alignment }));
+        archetype.chunks.push_back({ ChunkData(data, FreeChunk), 0 });
+    }
+
+    auto chunk_index = static_cast<uint32_t>(archetype.chunks.size() - 1);
+    Chunk& chunk = archetype.chunks.back();
+    uint32_t row = chunk.count++;
+    Entities(chunk)[row] = entity;
+    return { archetype_index, chunk_index, row };
+}
+
+void World::Vacate(Record record)
+{
+    Archetype& archetype = *m_archetypes[record.archetype];
+    Chunk& last = archetype.chunks.back();
+    uint32_t last_row = last.count - 1;
+    auto last_chunk = static_cast<uint32_t>(archetype.chunks.size() - 1);
+
+    // Keeps every chunk but the last one full
+    if (record.chunk != last_chunk || record.row != last_row)
+    {
+        Chunk& chunk = archetype.chunks[record.chunk];
+        for (uint32_t id : archetype.components)
+        {
+            ComponentInfo const& info = GetComponentInfo(id);
+            void* dst = chunk.data.get() + archetype.offsets[id] + record.row * info.size;
+            void* src = last.data.get() + archetype.offsets[id] + last_row * info.size;
+            info.move(dst, src);
+            info.destroy(src);
+        }
+        Entity moved = Entities(last)[last_row];
+        Entities(chunk)[record.row] = moved;
+        *m_entities.Get(moved) = record;
+    }
+
+    if (--last.count == 0)
+    {
+        archetype.chunks.pop_back();
+    }
+}
+
+auto World::Move(Record record, ComponentMask mask) -> Record
+{
+    Archetype& source = *m_archetypes[record.archetype];
+    Chunk& source_chunk = source.chunks[record.chunk];
+    Entity entity = Entities(source_chunk)[record.row];
+
+    Record moved = AllocateRow(FindArchetype(mask), entity);
+    // FindArchetype may have grown m_archetypes, the archetypes themselves stay put
+    Archetype& target = *m_archetypes[moved.archetype];
+    Chunk& target_chunk = target.chunks[moved.chunk];
+
+    for (uint32_t id : source.components)
+    {
+        ComponentInfo const& info = GetComponentInfo(id);
+        void* src = source_chunk.data.get() + source.offsets[id] + record.row * info.size;
+        if (mask & (ComponentMask{ 1 } << id))
+        {
+            info.move(target_chunk.data.get() + target.offsets[id] + moved.row * info.size, src);
+        }
+        info.destroy(src);
+    }
+
+    // Vacate may move another entity into the old row and update its record
+    *m_entities.Get(entity) = moved;
+    Vacate(record);
+    return moved;
+}
+
+void World::Defer(std::function<void(World&)> command)
+{
+    std::lock_guard lock(m_commands_mutex);
+    m_commands.push_back(std::move(command));
+}
\ No newline at end of file
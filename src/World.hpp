@@ -0,0 +1,269 @@
+#pragma once
+#include <array>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include "Handle.hpp"
+#include "FlatHashMap.hpp"
+#include "JobSystem.hpp"
+
+using Entity = Handle<struct EntityTag>;
+using ComponentMask = uint64_t;
+
+struct ComponentInfo
+{
+    size_t size;
+    size_t alignment;
+    void (*move)(void* dst, void* src); // move constructs into dst
+    void (*destroy)(void* object);
+};
+
+// Archetype ECS. Entities with the same set of components share an
+// archetype, which stores them in fixed size chunks with one contiguous
+// array per component, so queries walk plain arrays.
+// Structural changes (create, destroy, add, remove) move entities between
+// archetypes and must not happen while a query runs. From systems use the
+// Defer* calls, which are thread safe and applied together by Flush.
+class World
+{
+public:
+    static constexpr size_t s_max_components{ 64 };
+    static constexpr size_t s_chunk_size{ 16 * 1024 };
+
+    World() = default;
+    ~World();
+    World(World const&) = delete;
+    auto operator = (World const&) -> World& = delete;
+
+    template <typename T>
+    [[nodiscard]] static auto ComponentID() -> uint32_t
+    {
+        static uint32_t const id = RegisterComponent({
+            .size = sizeof(T),
+            .alignment = alignof(T),
+            .move = [](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); },
+            .destroy = [](void* object) { static_cast<T*>(object)->~T(); },
+        });
+        return id;
+    }
+
+    template <typename... Ts>
+    [[nodiscard]] static auto MaskOf() -> ComponentMask
+    {
+        return ((ComponentMask{ 1 } << ComponentID<std::remove_const_t<Ts>>()) | ... | ComponentMask{ 0 });
+    }
+
+    template <typename... Ts>
+    auto Create(Ts... components) -> Entity
+    {
+        Entity entity = m_entities.Insert({});
+        Record& record = *m_entities.Get(entity);
+        record = AllocateRow(FindArchetype(MaskOf<Ts...>()), entity);
+        (new (Column<Ts>(record)) Ts(std::move(components)), ...);
+        return entity;
+    }
+
+    void Destroy(Entity entity);
+
+    // Replaces the component when the entity already has one
+    template <typename T>
+    void Add(Entity entity, T component)
+    {
+        Record* record = m_entities.Get(entity);
+        if (!record)
+        {
+            return;
+        }
+        ComponentMask mask = m_archetypes[record->archetype]->mask;
+        if (mask & MaskOf<T>())
+        {
+            *Column<T>(*record) = std::move(component);
+            return;
+        }
+        *record = Move(*record, mask | MaskOf<T>());
+        new (Column<T>(*record)) T(std::move(component));
+    }
+
+    template <typename T>
+    void Remove(Entity entity)
+    {
+        Record* record = m_entities.Get(entity);
+        if (!record || !(m_archetypes[record->archetype]->mask & MaskOf<T>()))
+        {
+            return;
+        }
+        *record = Move(*record, m_archetypes[record->archetype]->mask & ~MaskOf<T>());
+    }
+
+    template <typename T>
+    [[nodiscard]] auto Get(Entity entity) -> T*
+    {
+        Record* record = m_entities.Get(entity);
+        if (!record || !(m_archetypes[record->archetype]->mask & MaskOf<T>()))
+        {
+            return nullptr;
+        }
+        return Column<T>(*record);
+    }
+
+    template <typename T>
+    [[nodiscard]] auto Has(Entity entity) const -> bool
+    {
+        Record const* record = m_entities.Get(entity);
+        return record && (m_archetypes[record->archetype]->mask & MaskOf<T>());
+    }
+
+    [[nodiscard]] auto IsAlive(Entity entity) const -> bool { return m_entities.Get(entity) != nullptr; }
+    [[nodiscard]] auto Size() const -> size_t { return m_entities.Size(); }
+    [[nodiscard]] auto ArchetypeCount() const -> size_t { return m_archetypes.size(); }
+
+    // Components must be copyable, the command is stored in a std::function
+    template <typename... Ts>
+    void DeferCreate(Ts... components)
+    {
+        Defer([... components = std::move(components)](World& world) mutable
+        {
+            world.Create(std::move(components)...);
+        });
+    }
+
+    void DeferDestroy(Entity entity)
+    {
+        Defer([entity](World& world) { world.Destroy(entity); });
+    }
+
+    template <typename T>
+    void DeferAdd(Entity entity, T component)
+    {
+        Defer([entity, component = std::move(component)](World& world) mutable
+        {
+            world.Add(entity, std::move(component));
+        });
+    }
+
+    template <typename T>
+    void DeferRemove(Entity entity)
+    {
+        Defer([entity](World& world) { world.Remove<T>(entity); });
+    }
+
+    // Sync point, applies deferred changes in the order they were made
+    void Flush();
+
+    // fn(count, entities, Ts* columns...) once per chunk holding all of Ts
+    // and none of `exclude`
+    template <typename... Ts, typename Fn>
+    void EachChunk(Fn&& fn, ComponentMask exclude = 0)
+    {
+        ComponentMask mask = MaskOf<Ts...>();
+        for (auto& archetype : m_archetypes)
+        {
+            if ((archetype->mask & mask) != mask || (archetype->mask & exclude))
+            {
+                continue;
+            }
+            for (auto& chunk : archetype->chunks)
+            {
+                fn(size_t{ chunk.count }, Entities(chunk), Column<Ts>(*archetype, chunk)...);
+            }
+        }
+    }
+
+    // fn(entity, Ts&...) for every entity holding all of Ts
+    template <typename... Ts, typename Fn>
+    void Each(Fn&& fn)
+    {
+        EachChunk<Ts...>([&fn](size_t count, Entity const* entities, Ts*... columns)
+        {
+            for (size_t i{ 0 }; i < count; ++i)
+            {
+                fn(entities[i], columns[i]...);
+            }
+        });
+    }
+
+    // Each, with one job per chunk. Returns once every chunk is done.
+    template <typename... Ts, typename Fn>
+    void ParallelEach(JobSystem& jobs, Fn const& fn, ComponentMask exclude = 0)
+    {
+        JobCounter counter;
+        EachChunk<Ts...>([&jobs, &fn, &counter](size_t count, Entity const* entities, Ts*... columns)
+        {
+            jobs.Run([&fn, count, entities, columns...]()
+            {
+                for (size_t i{ 0 }; i < count; ++i)
+                {
+                    fn(entities[i], columns[i]...);
+                }
+            }, &counter);
+        }, exclude);
+        jobs.Wait(counter);
+    }
+private:
+    using ChunkData = std::unique_ptr<std::byte[], void (*)(std::byte*)>;
+
+    struct Chunk
+    {
+        ChunkData data;
+        uint32_t  count{ 0 };
+    };
+
+    struct Archetype
+    {
+        ComponentMask                           mask{ 0 };
+        std::vector<uint32_t>                   components; // ascending ids
+        std::array<uint32_t, s_max_components> offsets{};  // column start in a chunk, by id
+        uint32_t                                capacity{ 0 }; // rows per chunk
+        std::vector<Chunk>                      chunks;     // all full but the last
+    };
+
+    struct Record
+    {
+        uint32_t archetype{ 0 };
+        uint32_t chunk{ 0 };
+        uint32_t row{ 0 };
+    };
+
+    static auto RegisterComponent(ComponentInfo info) -> uint32_t;
+    [[nodiscard]] static auto GetComponentInfo(uint32_t id) -> ComponentInfo const&;
+
+    auto FindArchetype(ComponentMask mask) -> uint32_t;
+    auto AllocateRow(uint32_t archetype, Entity entity) -> Record;
+    // Fills the row with the last one of its archetype, its components
+    // must be destroyed or moved out already
+    void Vacate(Record record);
+    // By value, the record usually lives in the entity slot being rewritten
+    auto Move(Record record, ComponentMask mask) -> Record;
+    void Defer(std::function<void(World&)> command);
+
+    [[nodiscard]] static auto Entities(Chunk& chunk) -> Entity*
+    {
+        return reinterpret_cast<Entity*>(chunk.data.get());
+    }
+
+    template <typename T>
+    [[nodiscard]] static auto Column(Archetype& archetype, Chunk& chunk) -> T*
+    {
+        uint32_t offset = archetype.offsets[ComponentID<std::remove_const_t<T>>()];
+        return reinterpret_cast<T*>(chunk.data.get() + offset);
+    }
+
+    template <typename T>
+    [[nodiscard]] auto Column(Record const& record) -> T*
+    {
+        Archetype& archetype = *m_archetypes[record.archetype];
+        return Column<T>(archetype, archetype.chunks[record.chunk]) + record.row;
+    }
+private:
+    SlotArray<Record, Entity>               m_entities;
+    std::vector<std::unique_ptr<Archetype>> m_archetypes;
+    FlatHashMap<uint32_t>                   m_archetype_masks; // mask -> archetype
+
+    std::mutex                              m_commands_mutex;
+    std::vector<std::function<void(World&)>> m_commands;
+};
\ No newline at end of file
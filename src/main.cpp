@@ -6,6 +6,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "Engine.hpp"
 #include "Logger.hpp"
+#include "LogSinks.hpp"
+#include "Profiler.hpp"
 #include "CameraController.hpp"
 
 struct alignas(16) CBuffer
@@ -27,30 +29,48 @@ static CBuffer cbuffer = {
 int main(int argc, char *argv[])
 {
     Logger::Initialize();
+#ifdef NDEBUG
+    Logger::AddSink(std::make_unique<BinaryLogSink>("build/logs/soulike.sllog"));
+#else
+    Logger::AddSink(std::make_unique<RotatingFileSink>("build/logs/soulike.log", 4 << 20, 3));
+#endif
 
+    EngineOptions options = ParseEngineOptions(argc, argv);
     Engine engine;
-    engine.Initialize();
-    cbuffer.resolution = glm::vec2(800.0f, 600.0f);
+    engine.Initialize(options);
+    cbuffer.resolution = glm::vec2(static_cast<float>(options.width), static_cast<float>(options.height));
     
     auto& mgr = ResourceManager::Instance();
-    auto pipeline = mgr.GetPipeline("default");
-    assert(pipeline);
+    PipelineHandle pipeline = mgr.AcquirePipeline("default"_rid);
+    assert(pipeline.IsValid());
 
-    SDL_GPUCommandBuffer* copy_cmd = engine.AcquireCmdBuf();
-    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(copy_cmd);
-    auto const& bunny = engine.UploadModel(copy_pass, "bunny");
-    SDL_EndGPUCopyPass(copy_pass);
-    engine.SubmitCmdBuf(copy_cmd);
+    // Uploaded by Engine::Update once first drawn
+    ModelHandle sphere = mgr.AcquireModel("sphere"_rid);
+    assert(sphere.IsValid());
+    engine.GetWorld().Create(Transform{}, WorldTransform{}, Renderable{ sphere });
 
     Camera camera;
-    camera.SetPerspectiveParams(glm::radians(30.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    camera.SetPerspectiveParams(glm::radians(30.0f), cbuffer.resolution.x / cbuffer.resolution.y, 0.1f, 100.0f);
     CameraController controller(&camera);
-    controller.SetMoveSpeed(0.1f);
+    ViewSet views;
+    controller.SetMoveSpeed(1.0f);
     controller.SetRotateSpeed(0.1f);
     cbuffer.projection = camera.GetProjectionMatrix();
+
+    // The controller moves the camera in simulation steps, frames draw it
+    // between the last two
+    glm::vec3 previous_position = camera.GetPosition();
+    glm::quat previous_rotation = camera.GetRotation();
+    engine.SetFixedUpdate([&](float delta_time)
+    {
+        previous_position = camera.GetPosition();
+        previous_rotation = camera.GetRotation();
+        controller.Update(delta_time);
+    });
     
     bool running = true;
     while (running) {
+        SO_PROFILE_FRAME();
         SDL_Event event;
         while (SDL_PollEvent(&event))
         {
@@ -60,6 +80,7 @@ int main(int argc, char *argv[])
                 running = false;
                 break;
             case SDL_EVENT_KEY_DOWN:
+                engine.NoteInput(event.key.timestamp);
                 switch (event.key.key)
                 {
                 case SDLK_ESCAPE:
@@ -80,9 +101,25 @@ int main(int argc, char *argv[])
                 case SDLK_SPACE:
                     controller.EnableRotating(true);
                     break;
+                case SDLK_F2:
+                    // Last two seconds or so, open in ui.perfetto.dev
+                    SO_PROFILE_WRITE_TRACE("build/trace.json", 120);
+                    break;
+                case SDLK_F3:
+                    // vsync, immediate, mailbox; unsupported ones are skipped
+                    for (int i{ 1 }; i <= 2; ++i)
+                    {
+                        auto mode = static_cast<SDL_GPUPresentMode>((engine.GetPresentMode() + i) % 3);
+                        if (engine.SetPresentMode(mode))
+                        {
+                            break;
+                        }
+                    }
+                    break;
                 }
                 break;
             case SDL_EVENT_KEY_UP:
+                engine.NoteInput(event.key.timestamp);
                 switch (event.key.key)
                 {
                 case SDLK_W:
@@ -103,65 +140,32 @@ int main(int argc, char *argv[])
                 }
                 break;
             case SDL_EVENT_MOUSE_MOTION:
+                engine.NoteInput(event.motion.timestamp);
                 controller.RotateYaw(event.motion.xrel);
                 controller.RotatePitch(event.motion.yrel);
                 break;
             }
         }
 
-        static uint64_t last_tick{ 0 };
-        controller.Update((SDL_GetTicks() - last_tick) / 100.0f);
-        last_tick = SDL_GetTicks();
-
-
-        SDL_GPUCommandBuffer* cmd = engine.AcquireCmdBuf();
-    
-        Texture const& present_texture = engine.AcquireSwapchainImage(cmd);
-
-        std::vector<SDL_GPUColorTargetInfo> color_targets{
-            {
-                .texture = present_texture.handle,
-                .mip_level = 0,
-                .layer_or_depth_plane = 0,
-                .clear_color = {0.2f, 0.2f, 0.2f, 1.0f},
-                .load_op = SDL_GPULoadOp::SDL_GPU_LOADOP_CLEAR,
-                .store_op = SDL_GPUStoreOp::SDL_GPU_STOREOP_STORE,
-                .resolve_mip_level = 0,
-                .resolve_layer = 0,
-                .cycle = false,
-                .cycle_resolve_texture = false,
-            }
-        };
-
-        SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(
-            cmd,
-            color_targets.data(), 
-            static_cast<uint32_t>(color_targets.size()), 
-            nullptr);
-        
-        SDL_GPUViewport viewport {
-            .x = 0, .y = 0,
-            .w = static_cast<float>(present_texture.width), .h = static_cast<float>(present_texture.height),
-        };
-        SDL_SetGPUViewport(render_pass, &viewport);
-        SDL_Rect scissor {
-            .x = 0, .y = 0,
-            .w = static_cast<int>(present_texture.width), .h = static_cast<int>(present_texture.height),
-        };
-        SDL_SetGPUScissor(render_pass, &scissor);
-
-        SDL_BindGPUGraphicsPipeline(render_pass, pipeline);
+        // Input of this frame is seen by its steps
+        engine.Update();
 
-        cbuffer.time = SDL_GetTicks() / 1000.0f;
-        cbuffer.view = camera.GetViewMatrix();
-        SDL_PushGPUVertexUniformData(cmd, 0, &cbuffer, sizeof(CBuffer));
-        // SDL_PushGPUFragmentUniformData(cmd, 0, &ubo, sizeof(UBO));
-        engine.DrawModel(render_pass, bunny);
-        SDL_EndGPURenderPass(render_pass);
+        float alpha = engine.GetInterpolationAlpha();
+        Camera view_camera = camera;
+        view_camera.SetPosition(glm::mix(previous_position, camera.GetPosition(), alpha));
+        view_camera.SetRotation(glm::slerp(previous_rotation, camera.GetRotation(), alpha));
+        views.Clear();
+        views.Add(view_camera);
+        engine.CullScene(views);
 
-        engine.SubmitCmdBuf(cmd);
+        cbuffer.time = static_cast<float>(SDL_GetTicksNS()) * 1e-9f;
+        cbuffer.view = view_camera.GetViewMatrix();
+        // Rendered on the render thread while the next frame updates
+        engine.SubmitFrame(pipeline, std::as_bytes(std::span(&cbuffer, 1)));
     }
 
+    mgr.Release(sphere);
+    mgr.Release(pipeline);
     engine.Destroy();
     Logger::Destroy();
-}
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+// Imports the animations of a skinned glTF model into a compact clip file.
+// Tracks within the tolerances are stored as constants or lines, the rest
+// as 16 bit keys per frame. Set `clips` in the model's model group entry
+// to the output to load it alongside the model.
+//
+//   animimport <model.glb|.gltf> <out.soanim> [--rotation <error>]
+//              [--translation <error>] [--scale <error>]
+//
+// Prints what every clip was reduced to. The exit code is 1 on bad
+// arguments, a model without a skin or a failed write.
+#include <format>
+#include <string>
+#include <vector>
+#include <optional>
+#include <charconv>
+#include <iostream>
+#include <filesystem>
+#include <string_view>
+#include "Logger.hpp"
+#include "Animation.hpp"
+#include "GLTFHelper.hpp"
+
+namespace {
+    struct Options
+    {
+        std::filesystem::path model;
+        std::filesystem::path output;
+        ClipTolerance         tolerance{};
+    };
+
+    auto ParseOptions(int argc, char* argv[]) -> std::optional<Options>
+    {
+        Options options{};
+        auto read_number = [](std::string_view text, float& value)
+        {
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc{} && end == text.data() + text.size() && value >= 0.0f;
+        };
+
+        std::vector<std::string_view> positional;
+        for (int i{ 1 }; i < argc; ++i)
+        {
+            std::string_view arg{ argv[i] };
+            if (!arg.starts_with("--"))
+            {
+                positional.push_back(arg);
+                continue;
+            }
+            if (i + 1 >= argc)
+            {
+                std::cerr << std::format("animimport: {} needs a value\n", arg);
+                return std::nullopt;
+            }
+            std::string_view value{ argv[++i] };
+            bool ok{ true };
+            if (arg == "--rotation")
+            {
+                ok = read_number(value, options.tolerance.rotation);
+            }
+            else if (arg == "--translation")
+            {
+                ok = read_number(value, options.tolerance.translation);
+            }
+            else if (arg == "--scale")
+            {
+                ok = read_number(value, options.tolerance.scale);
+            }
+            else
+            {
+                std::cerr << std::format("animimport: unknown option {}\n", arg);
+                return std::nullopt;
+            }
+            if (!ok)
+            {
+                std::cerr << std::format("animimport: invalid value for {}: {}\n", arg, value);
+                return std::nullopt;
+            }
+        }
+        if (positional.size() != 2)
+        {
+            std::cerr << "usage: animimport <model.glb|.gltf> <out.soanim> [--rotation <error>] [--translation <error>] [--scale <error>]\n";
+            return std::nullopt;
+        }
+        options.model = positional[0];
+        options.output = positional[1];
+        return options;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::optional<Options> options = ParseOptions(argc, argv);
+    if (!options)
+    {
+        return 1;
+    }
+    Logger::Initialize(LogOverflow::Block, LogLevelFlagBits::Warn | LogLevelFlagBits::Error);
+
+    GLTFHelper helper;
+    helper.SetClipTolerance(options->tolerance);
+    helper.Load(options->model);
+    std::shared_ptr<SkinInfo> skin = helper.GetSkin();
+    if (!skin)
+    {
+        std::cerr << std::format("animimport: {} has no skin\n", options->model.string());
+        Logger::Destroy();
+        return 1;
+    }
+
+    uint32_t joint_count = skin->skeleton.JointCount();
+    size_t raw_total{ 0 };
+    size_t compressed_total{ 0 };
+    std::cout << std::format("{:<24} {:>7} {:>9} {:>7} {:>7} {:>11} {:>11}\n",
+        "clip", "frames", "constant", "linear", "keyed", "raw", "compressed");
+    for (auto const& clip : skin->clips)
+    {
+        // A joint has one rotation track and six scalar tracks
+        size_t tracks = static_cast<size_t>(joint_count) * 7;
+        size_t linear = clip.linear.size() + clip.linear_rotations.size();
+        size_t keyed = clip.keyed.size() + clip.keyed_rotations.size();
+        size_t raw = static_cast<size_t>(clip.frame_count) * clip.base.size() * sizeof(float);
+        raw_total += raw;
+        compressed_total += clip.ByteSize();
+        std::cout << std::format("{:<24} {:>7} {:>9} {:>7} {:>7} {:>11} {:>11}\n",
+            clip.name, clip.frame_count, tracks - linear - keyed, linear, keyed, raw, clip.ByteSize());
+    }
+    std::cout << std::format("{} clips, {} joints, {} of {} bytes ({:.1f}%)\n", skin->clips.size(), joint_count,
+        compressed_total, raw_total, raw_total > 0 ? 100.0 * static_cast<double>(compressed_total) / static_cast<double>(raw_total) : 0.0);
+
+    bool saved = SaveClips(options->output, skin->clips, joint_count);
+    Logger::Destroy();
+    return saved ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,228 @@
+// Renders a fixed scene for a number of frames and prints CPU frame time
+// statistics as JSON. With the render thread this is the game thread's
+// time, including waits once the renderer falls a frame behind. Takes the
+// engine options plus
+//   --frames <n>     measured frames (600)
+//   --warmup <n>     frames run before measuring (60)
+//   --model <name>   model from the config to instance ("sphere")
+//   --instances <n>  copies of it on a square grid (1)
+//   --output <file>  write the report there instead of stdout
+//
+//   framebench --headless --config config --instances 1024 --output build/frames.json
+#include <cmath>
+#include <format>
+#include <span>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <numeric>
+#include <charconv>
+#include <iostream>
+#include <algorithm>
+#include <string_view>
+#include <glm/glm.hpp>
+#include "Engine.hpp"
+#include "Logger.hpp"
+#include "Camera.hpp"
+
+namespace {
+    // Layout of the per frame constant buffer in default_shared.slang
+    struct alignas(16) FrameConstants
+    {
+        float     time;
+        float     padding0;
+        glm::vec2 resolution;
+        glm::mat4 projection;
+        glm::mat4 view;
+    };
+
+    struct BenchOptions
+    {
+        uint32_t    frames{ 600 };
+        uint32_t    warmup{ 60 };
+        std::string model{ "sphere" };
+        uint32_t    instances{ 1 };
+        std::string output;
+    };
+
+    auto ParseBenchOptions(int argc, char* argv[]) -> BenchOptions
+    {
+        BenchOptions options{};
+        auto read_count = [](std::string_view text, uint32_t& value)
+        {
+            uint32_t parsed{ 0 };
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+            if (error == std::errc{} && end == text.data() + text.size())
+            {
+                value = parsed;
+            }
+            else
+            {
+                SO_WARN("Ignoring invalid count {}", text);
+            }
+        };
+
+        for (int i{ 1 }; i + 1 < argc; ++i)
+        {
+            std::string_view arg{ argv[i] };
+            if (arg == "--frames")
+            {
+                read_count(argv[++i], options.frames);
+            }
+            else if (arg == "--warmup")
+            {
+                read_count(argv[++i], options.warmup);
+            }
+            else if (arg == "--model")
+            {
+                options.model = argv[++i];
+            }
+            else if (arg == "--instances")
+            {
+                read_count(argv[++i], options.instances);
+            }
+            else if (arg == "--output")
+            {
+                options.output = argv[++i];
+            }
+        }
+        options.frames = std::max(options.frames, 1u);
+        return options;
+    }
+
+    struct FrameStats
+    {
+        double mean_ms{ 0.0 };
+        double p50_ms{ 0.0 };
+        double p99_ms{ 0.0 };
+        double max_ms{ 0.0 };
+    };
+
+    // Nearest rank percentiles
+    auto ComputeStats(std::vector<double> frame_ms) -> FrameStats
+    {
+        std::sort(frame_ms.begin(), frame_ms.end());
+        auto percentile = [&frame_ms](double p)
+        {
+            auto rank = static_cast<size_t>(std::ceil(p * static_cast<double>(frame_ms.size())));
+            return frame_ms[std::clamp<size_t>(rank, 1, frame_ms.size()) - 1];
+        };
+        return {
+            .mean_ms = std::accumulate(frame_ms.begin(), frame_ms.end(), 0.0) / static_cast<double>(frame_ms.size()),
+            .p50_ms = percentile(0.50),
+            .p99_ms = percentile(0.99),
+            .max_ms = frame_ms.back(),
+        };
+    }
+
+    // Everything main does in a frame, minus input
+    void RenderFrame(Engine& engine, PipelineHandle pipeline, ViewSet const& views, FrameConstants const& constants)
+    {
+        engine.Update();
+        engine.CullScene(views);
+        engine.SubmitFrame(pipeline, std::as_bytes(std::span(&constants, 1)));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Logger::Initialize(LogOverflow::Block);
+    EngineOptions engine_options = ParseEngineOptions(argc, argv);
+    // The watcher thread and background slangc runs would skew timings
+    engine_options.hot_reload = false;
+    BenchOptions options = ParseBenchOptions(argc, argv);
+
+    Engine engine;
+    engine.Initialize(engine_options);
+
+    auto& mgr = ResourceManager::Instance();
+    PipelineHandle pipeline = mgr.AcquirePipeline("default"_rid);
+    ModelHandle model = mgr.AcquireModel(ResourceManager::Hash(options.model));
+    if (!pipeline.IsValid() || !model.IsValid())
+    {
+        SO_ERROR("Benchmark scene needs the default pipeline and model {}", options.model);
+        engine.Destroy();
+        Logger::Destroy();
+        return 1;
+    }
+
+    // Square grid around the origin, two units apart
+    auto side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(options.instances))));
+    for (uint32_t i{ 0 }; i < options.instances; ++i)
+    {
+        glm::vec3 position{
+            (static_cast<float>(i % side) - static_cast<float>(side - 1) * 0.5f) * 2.0f,
+            0.0f,
+            (static_cast<float>(i / side) - static_cast<float>(side - 1) * 0.5f) * 2.0f,
+        };
+        engine.GetWorld().Create(Transform{ .position = position }, WorldTransform{}, Renderable{ model });
+    }
+
+    float aspect = static_cast<float>(engine_options.width) / static_cast<float>(engine_options.height);
+    Camera camera;
+    camera.SetPerspectiveParams(glm::radians(30.0f), aspect, 0.1f, 1000.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, -4.0f - 2.0f * static_cast<float>(side)));
+
+    ViewSet views;
+    views.Add(camera);
+
+    FrameConstants constants{
+        .resolution = glm::vec2(static_cast<float>(engine_options.width), static_cast<float>(engine_options.height)),
+        .projection = camera.GetProjectionMatrix(),
+        .view = camera.GetViewMatrix(),
+    };
+
+    std::vector<double> frame_ms;
+    frame_ms.reserve(options.frames);
+    for (uint32_t frame{ 0 }; frame < options.warmup + options.frames; ++frame)
+    {
+        SDL_Event event;
+        while (SDL_PollEvent(&event))
+        {
+        }
+
+        constants.time = static_cast<float>(frame) / 60.0f;
+        auto start = std::chrono::steady_clock::now();
+        RenderFrame(engine, pipeline, views, constants);
+        auto end = std::chrono::steady_clock::now();
+        if (frame >= options.warmup)
+        {
+            frame_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+    engine.WaitIdle();
+
+    FrameStats stats = ComputeStats(frame_ms);
+    std::string report = std::format(
+        "{{\n"
+        "    \"driver\": \"{}\",\n"
+        "    \"headless\": {},\n"
+        "    \"width\": {},\n"
+        "    \"height\": {},\n"
+        "    \"model\": \"{}\",\n"
+        "    \"instances\": {},\n"
+        "    \"render_scale\": {:.2f},\n"
+        "    \"warmup\": {},\n"
+        "    \"frames\": {},\n"
+        "    \"frame_ms\": {{ \"mean\": {:.4f}, \"p50\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f} }}\n"
+        "}}\n",
+        engine.GetDriverName(), engine_options.headless,
+        engine_options.width, engine_options.height,
+        options.model, options.instances, engine.GetRenderScale(), options.warmup, options.frames,
+        stats.mean_ms, stats.p50_ms, stats.p99_ms, stats.max_ms);
+
+    mgr.Release(model);
+    mgr.Release(pipeline);
+    engine.Destroy();
+    Logger::Destroy();
+
+    if (options.output.empty())
+    {
+        std::cout << report;
+        return 0;
+    }
+    std::ofstream file(options.output);
+    file << report;
+    return file ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+// Turns a binary log written by BinaryLogSink back into the text lines
+// FileSink would have written.
+//
+//   logdecode build/logs/soulike.sllog > soulike.log
+#include <format>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include "LogEncoding.hpp"
+
+namespace {
+    struct Site
+    {
+        uint64_t         level{ 0 };
+        uint64_t         line{ 0 };
+        std::string_view file;
+        std::string_view function;
+        std::string_view format;
+    };
+
+    // Bits of LogLevelFlagBits
+    auto LevelName(uint64_t level) -> std::string_view
+    {
+        if (level & (1u << 4))
+        {
+            return "error";
+        }
+        if (level & (1u << 3))
+        {
+            return "warn";
+        }
+        return "info";
+    }
+
+    auto ReadSite(LogReader& reader, std::vector<Site>& sites) -> bool
+    {
+        std::optional<uint64_t> id = reader.Varint();
+        std::optional<uint64_t> level = reader.Varint();
+        std::optional<uint64_t> line = reader.Varint();
+        std::optional<std::string_view> file = reader.String();
+        std::optional<std::string_view> function = reader.String();
+        std::optional<std::string_view> format = reader.String();
+        if (!id || !level || !line || !file || !function || !format || *id != sites.size())
+        {
+            return false;
+        }
+        sites.push_back({ *level, *line, *file, *function, *format });
+        return true;
+    }
+
+    auto ReadMessage(LogReader& reader, std::vector<Site> const& sites, uint64_t& time) -> bool
+    {
+        std::optional<uint64_t> id = reader.Varint();
+        std::optional<uint64_t> thread = reader.Varint();
+        std::optional<uint64_t> delta = reader.Varint();
+        std::optional<std::string_view> args = reader.String();
+        if (!id || !thread || !delta || !args || *id >= sites.size())
+        {
+            return false;
+        }
+
+        time += *delta;
+        Site const& site = sites[*id];
+        std::cout << std::format(
+            "[{:10.3f}] [{}] [{}] {}:{} ({}) {}\n",
+            static_cast<double>(time) * 1e-9, LevelName(site.level), *thread,
+            site.file, site.line, site.function,
+            FormatLogMessage(site.format, *args));
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "usage: logdecode <log.sllog>\n";
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file)
+    {
+        std::cerr << std::format("logdecode: cannot open {}\n", argv[1]);
+        return 1;
+    }
+    std::string bytes{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    LogReader reader(bytes);
+    std::optional<std::string_view> magic = reader.Bytes(s_log_magic.size());
+    std::optional<uint64_t> version = reader.Varint();
+    if (!magic || *magic != s_log_magic || version != s_log_version)
+    {
+        std::cerr << std::format("logdecode: {} is not a version {} binary log\n", argv[1], s_log_version);
+        return 1;
+    }
+
+    std::vector<Site> sites;
+    uint64_t time{ 0 };
+    while (!reader.AtEnd())
+    {
+        std::optional<uint8_t> kind = reader.Byte();
+        bool ok{ false };
+        switch (static_cast<LogRecordKind>(*kind))
+        {
+        case LogRecordKind::Site:
+            ok = ReadSite(reader, sites);
+            break;
+        case LogRecordKind::Message:
+            ok = ReadMessage(reader, sites, time);
+            break;
+        }
+        if (!ok)
+        {
+            // The tail of a log cut short by a crash
+            std::cerr << "logdecode: truncated or corrupt record, stopping\n";
+            return 1;
+        }
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,667 @@
+// CPU microbenchmarks for asset loading, resource lookups, config parsing,
+// camera math, animation and logging. Every benchmark is calibrated to a minimum
+// batch time, warmed up, then timed over a number of batches; the median
+// time per operation is what gets compared.
+//
+//   microbench [--filter <text>] [--repetitions <n>] [--min-batch-ms <n>]
+//              [--warmup-ms <n>] [--json <file>] [--baseline <file>]
+//              [--threshold <percent>]
+//
+// --json writes the results, feed such a file back as --baseline to get
+// the change per benchmark. The exit code is 2 when any median got slower
+// than the threshold (10% by default).
+#include <cmath>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <optional>
+#include <filesystem>
+#include <numeric>
+#include <charconv>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "Camera.hpp"
+#include "Animation.hpp"
+#include "Frustum.hpp"
+#include "Logger.hpp"
+#include "Script.hpp"
+#include "JobSystem.hpp"
+#include "GLTFHelper.hpp"
+#include "ResourceManager.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Keeps the compiler from dropping work whose result is unused
+    template <typename T>
+    void DoNotOptimize(T const& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static_cast<void>(*static_cast<T const volatile*>(&value));
+#endif
+    }
+
+    struct Benchmark
+    {
+        std::string                    name;
+        // Runs the operation `iterations` times
+        std::function<void(uint64_t)> run;
+    };
+
+    struct Result
+    {
+        std::string name;
+        uint64_t    iterations{ 0 }; // per batch
+        double      mean_ns{ 0.0 };
+        double      median_ns{ 0.0 };
+        double      stddev_ns{ 0.0 };
+        double      min_ns{ 0.0 };
+        double      max_ns{ 0.0 };
+    };
+
+    struct Options
+    {
+        std::string filter;
+        uint32_t    repetitions{ 15 };
+        uint32_t    min_batch_ms{ 10 };
+        uint32_t    warmup_ms{ 100 };
+        std::string json;
+        std::string baseline;
+        double      threshold{ 10.0 };
+    };
+
+    auto ParseOptions(int argc, char* argv[]) -> std::optional<Options>
+    {
+        Options options{};
+        auto read_number = [](std::string_view text, auto& value)
+        {
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc{} && end == text.data() + text.size();
+        };
+
+        for (int i{ 1 }; i < argc; ++i)
+        {
+            std::string_view arg{ argv[i] };
+            if (i + 1 >= argc)
+            {
+                std::cerr << std::format("microbench: {} needs a value\n", arg);
+                return std::nullopt;
+            }
+            std::string_view value{ argv[++i] };
+            bool ok{ true };
+            if (arg == "--filter")
+            {
+                options.filter = value;
+            }
+            else if (arg == "--repetitions")
+            {
+                ok = read_number(value, options.repetitions) && options.repetitions > 0;
+            }
+            else if (arg == "--min-batch-ms")
+            {
+                ok = read_number(value, options.min_batch_ms);
+            }
+            else if (arg == "--warmup-ms")
+            {
+                ok = read_number(value, options.warmup_ms);
+            }
+            else if (arg == "--json")
+            {
+                options.json = value;
+            }
+            else if (arg == "--baseline")
+            {
+                options.baseline = value;
+            }
+            else if (arg == "--threshold")
+            {
+                ok = read_number(value, options.threshold);
+            }
+            else
+            {
+                ok = false;
+            }
+            if (!ok)
+            {
+                std::cerr << std::format("microbench: bad argument {} {}\n", arg, value);
+                return std::nullopt;
+            }
+        }
+        return options;
+    }
+
+    auto TimeBatch(Benchmark const& benchmark, uint64_t iterations) -> double
+    {
+        auto start = Clock::now();
+        benchmark.run(iterations);
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    auto Run(Benchmark const& benchmark, Options const& options) -> Result
+    {
+        // Grow the batch until it is long enough for the clock, which also
+        // warms caches and allocators up
+        double min_batch_ns = options.min_batch_ms * 1e6;
+        uint64_t iterations{ 1 };
+        double batch_ns = TimeBatch(benchmark, iterations);
+        while (batch_ns < min_batch_ns && iterations < (uint64_t{ 1 } << 40))
+        {
+            double scale = batch_ns > 0.0 ? std::clamp(1.2 * min_batch_ns / batch_ns, 2.0, 100.0) : 100.0;
+            iterations = static_cast<uint64_t>(std::ceil(static_cast<double>(iterations) * scale));
+            batch_ns = TimeBatch(benchmark, iterations);
+        }
+        for (auto end = Clock::now() + std::chrono::milliseconds(options.warmup_ms); Clock::now() < end;)
+        {
+            TimeBatch(benchmark, iterations);
+        }
+
+        std::vector<double> samples(options.repetitions);
+        for (double& sample : samples)
+        {
+            sample = TimeBatch(benchmark, iterations) / static_cast<double>(iterations);
+        }
+        std::sort(samples.begin(), samples.end());
+
+        Result result{ .name = benchmark.name, .iterations = iterations };
+        size_t count = samples.size();
+        result.mean_ns = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(count);
+        result.median_ns = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) * 0.5;
+        double variance{ 0.0 };
+        for (double sample : samples)
+        {
+            variance += (sample - result.mean_ns) * (sample - result.mean_ns);
+        }
+        result.stddev_ns = count > 1 ? std::sqrt(variance / static_cast<double>(count - 1)) : 0.0;
+        result.min_ns = samples.front();
+        result.max_ns = samples.back();
+        return result;
+    }
+
+    void WriteJson(std::filesystem::path const& path, std::vector<Result> const& results)
+    {
+        std::ofstream file(path);
+        file << "{\n    \"benchmarks\": [\n";
+        for (size_t i{ 0 }; i < results.size(); ++i)
+        {
+            Result const& result = results[i];
+            // One benchmark per line, ReadBaseline depends on it
+            file << std::format(
+                "        {{ \"name\": \"{}\", \"iterations\": {}, \"mean_ns\": {:.3f}, \"median_ns\": {:.3f}, "
+                "\"stddev_ns\": {:.3f}, \"min_ns\": {:.3f}, \"max_ns\": {:.3f} }}{}\n",
+                result.name, result.iterations, result.mean_ns, result.median_ns,
+                result.stddev_ns, result.min_ns, result.max_ns,
+                i + 1 < results.size() ? "," : "");
+        }
+        file << "    ]\n}\n";
+    }
+
+    // Medians by name from a file WriteJson produced
+    auto ReadBaseline(std::filesystem::path const& path) -> std::optional<std::unordered_map<std::string, double>>
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            return std::nullopt;
+        }
+
+        std::unordered_map<std::string, double> medians;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            constexpr std::string_view name_key{ "\"name\": \"" };
+            constexpr std::string_view median_key{ "\"median_ns\": " };
+            size_t name = line.find(name_key);
+            size_t median = line.find(median_key);
+            if (name == std::string::npos || median == std::string::npos)
+            {
+                continue;
+            }
+            name += name_key.size();
+            median += median_key.size();
+            double value{ 0.0 };
+            auto [end, error] = std::from_chars(line.data() + median, line.data() + line.size(), value);
+            if (error == std::errc{})
+            {
+                medians[line.substr(name, line.find('"', name) - name)] = value;
+            }
+        }
+        return medians;
+    }
+
+    auto FormatTime(double ns) -> std::string
+    {
+        if (ns >= 1e6)
+        {
+            return std::format("{:.3f} ms", ns * 1e-6);
+        }
+        if (ns >= 1e3)
+        {
+            return std::format("{:.3f} us", ns * 1e-3);
+        }
+        return std::format("{:.2f} ns", ns);
+    }
+
+    /// Fixtures
+
+    // Square grid of `side` x `side` vertices as .gltf plus .bin
+    auto WriteGridMesh(std::filesystem::path const& dir, uint32_t side) -> std::filesystem::path
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<uint32_t> indices;
+        positions.reserve(side * side);
+        normals.reserve(side * side);
+        indices.reserve((side - 1) * (side - 1) * 6);
+        for (uint32_t z{ 0 }; z < side; ++z)
+        {
+            for (uint32_t x{ 0 }; x < side; ++x)
+            {
+                positions.emplace_back(static_cast<float>(x), 0.0f, static_cast<float>(z));
+                normals.emplace_back(0.0f, 1.0f, 0.0f);
+            }
+        }
+        for (uint32_t z{ 0 }; z + 1 < side; ++z)
+        {
+            for (uint32_t x{ 0 }; x + 1 < side; ++x)
+            {
+                uint32_t i = z * side + x;
+                indices.insert(indices.end(), { i, i + side, i + 1, i + 1, i + side, i + side + 1 });
+            }
+        }
+
+        size_t vertex_bytes = positions.size() * sizeof(glm::vec3);
+        size_t index_bytes = indices.size() * sizeof(uint32_t);
+        std::string name = std::format("grid{}", side);
+        {
+            std::ofstream bin(dir/(name + ".bin"), std::ios::binary);
+            bin.write(reinterpret_cast<char const*>(positions.data()), static_cast<std::streamsize>(vertex_bytes));
+            bin.write(reinterpret_cast<char const*>(normals.data()), static_cast<std::streamsize>(vertex_bytes));
+            bin.write(reinterpret_cast<char const*>(indices.data()), static_cast<std::streamsize>(index_bytes));
+        }
+
+        float extent = static_cast<float>(side - 1);
+        std::filesystem::path path = dir/(name + ".gltf");
+        std::ofstream gltf(path);
+        gltf << std::format(
+            R"({{
+    "asset": {{ "version": "2.0" }},
+    "scene": 0,
+    "scenes": [ {{ "nodes": [ 0 ] }} ],
+    "nodes": [ {{ "mesh": 0 }} ],
+    "meshes": [ {{ "primitives": [ {{ "attributes": {{ "POSITION": 0, "NORMAL": 1 }}, "indices": 2 }} ] }} ],
+    "buffers": [ {{ "uri": "{0}.bin", "byteLength": {1} }} ],
+    "bufferViews": [
+        {{ "buffer": 0, "byteOffset": 0, "byteLength": {2} }},
+        {{ "buffer": 0, "byteOffset": {2}, "byteLength": {2} }},
+        {{ "buffer": 0, "byteOffset": {3}, "byteLength": {4} }}
+    ],
+    "accessors": [
+        {{ "bufferView": 0, "componentType": 5126, "count": {5}, "type": "VEC3", "min": [ 0, 0, 0 ], "max": [ {6}, 0, {6} ] }},
+        {{ "bufferView": 1, "componentType": 5126, "count": {5}, "type": "VEC3" }},
+        {{ "bufferView": 2, "componentType": 5125, "count": {7}, "type": "SCALAR" }}
+    ]
+}}
+)",
+            name, vertex_bytes * 2 + index_bytes, vertex_bytes, vertex_bytes * 2, index_bytes,
+            positions.size(), extent, indices.size());
+        return path;
+    }
+
+    constexpr char const* s_shader_config = R"(
+shader = {
+    is_byte_code = false,
+    source_path = "../src/shaders/default_vertex.slang",
+    stage = 0,
+    format = 2,
+    entry_point = "vertexMain",
+    num_samplers = 0,
+    num_storage_buffers = 0,
+    num_uniform_buffers = 2,
+}
+)";
+}
+
+int main(int argc, char* argv[])
+{
+    std::optional<Options> options = ParseOptions(argc, argv);
+    if (!options)
+    {
+        return 1;
+    }
+    // Only errors reach the console, the benchmarks log a lot. Blocking
+    // keeps logger/info on the enqueue path, dropped records return early
+    // and would mix a cheaper path into the timing.
+    Logger::Initialize(LogOverflow::Block, LogLevelFlagBits::Error);
+
+    // A config root without shaders or pipelines, ResourceManager runs
+    // without a GPU device as long as no model is drawn
+    std::filesystem::path root = std::filesystem::temp_directory_path()/"soulike-microbench";
+    std::filesystem::path config = root/"config";
+    std::filesystem::remove_all(root);
+    for (char const* dir : { "shaders", "pipelines", "models", "preludes", "meshes" })
+    {
+        std::filesystem::create_directories(config/dir);
+    }
+    std::vector<std::pair<uint32_t, std::filesystem::path>> meshes;
+    for (uint32_t side : { 16u, 64u, 256u })
+    {
+        meshes.emplace_back(side * side, WriteGridMesh(config/"meshes", side));
+    }
+
+    JobSystem jobs(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    ResourceManager::Initialize(config, nullptr, jobs);
+    ResourceManager& mgr = ResourceManager::Instance();
+
+    std::vector<Benchmark> benchmarks;
+
+    /// GLTFHelper
+    std::vector<std::unique_ptr<GLTFHelper>> helpers;
+    for (auto const& [vertices, path] : meshes)
+    {
+        benchmarks.push_back({ std::format("gltf/load/{}", vertices), [path](uint64_t iterations)
+        {
+            for (uint64_t i{ 0 }; i < iterations; ++i)
+            {
+                GLTFHelper helper;
+                DoNotOptimize(helper.Load(path).first);
+            }
+        }});
+
+        auto& helper = helpers.emplace_back(std::make_unique<GLTFHelper>());
+        helper->Load(path);
+        benchmarks.push_back({ std::format("vertex/copy/{}", vertices), [&mgr, helper = helper.get()](uint64_t iterations)
+        {
+            for (uint64_t i{ 0 }; i < iterations; ++i)
+            {
+                mgr.CreateModel("copy", *helper);
+                // Runs the release of the replaced copy
+                mgr.BeginFrame(mgr.GetFrame());
+            }
+        }});
+    }
+
+    /// ResourceManager
+    std::vector<ResouceID> ids;
+    std::vector<std::string> names;
+    for (uint32_t i{ 0 }; i < 1024; ++i)
+    {
+        names.push_back(std::format("model_{}", i));
+        ids.push_back(ResourceManager::Hash(names.back()));
+        mgr.CreateModel(names.back(), *helpers.front());
+    }
+    benchmarks.push_back({ "resource/get_model/id", [&mgr, &ids](uint64_t iterations)
+    {
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            DoNotOptimize(mgr.GetModel(ids[i & 1023]));
+        }
+    }});
+    benchmarks.push_back({ "resource/get_model/name", [&mgr, &names](uint64_t iterations)
+    {
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            DoNotOptimize(mgr.GetModel(std::string_view(names[i & 1023])));
+        }
+    }});
+    benchmarks.push_back({ "resource/get_model/miss", [&mgr](uint64_t iterations)
+    {
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            DoNotOptimize(mgr.GetModel(static_cast<ResouceID>(i * 0x9E3779B97F4A7C15ull)));
+        }
+    }});
+    benchmarks.push_back({ "resource/acquire_release", [&mgr, &ids](uint64_t iterations)
+    {
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            ModelHandle handle = mgr.AcquireModel(ids[i & 1023]);
+            DoNotOptimize(mgr.GetModel(handle));
+            mgr.Release(handle);
+        }
+    }});
+
+    /// Script
+    std::filesystem::path shader_script = config/"shaders"/"bench.vertex.lua";
+    std::ofstream(shader_script) << s_shader_config;
+    lua_State* L = luaL_newstate();
+    luaL_openlibs(L);
+    static_cast<void>(Script::Load(L, shader_script));
+    benchmarks.push_back({ "lua/read_fields", [L](uint64_t iterations)
+    {
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            LuaTableScope scope(L, "shader");
+            DoNotOptimize(Script::ReadBooleanField(L, "is_byte_code"));
+            DoNotOptimize(Script::ReadStringField(L, "source_path"));
+            DoNotOptimize(Script::ReadIntegerField(L, "stage"));
+            DoNotOptimize(Script::ReadIntegerField(L, "format"));
+            DoNotOptimize(Script::ReadStringField(L, "entry_point"));
+            DoNotOptimize(Script::ReadIntegerField(L, "num_samplers"));
+            DoNotOptimize(Script::ReadIntegerField(L, "num_storage_buffers"));
+            DoNotOptimize(Script::ReadIntegerField(L, "num_uniform_buffers"));
+        }
+    }});
+    benchmarks.push_back({ "lua/load_shader_info", [L, &mgr, shader_script](uint64_t iterations)
+    {
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            DoNotOptimize(mgr.LoadShaderInfo(L, shader_script));
+        }
+    }});
+
+    /// Camera
+    benchmarks.push_back({ "camera/view", [](uint64_t iterations)
+    {
+        Camera camera;
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            camera.SetPosition(glm::vec3(static_cast<float>(i & 255), 1.0f, -4.0f));
+            DoNotOptimize(camera.GetViewMatrix());
+        }
+    }});
+    benchmarks.push_back({ "camera/projection", [](uint64_t iterations)
+    {
+        Camera camera;
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            camera.SetPerspectiveParams(glm::radians(30.0f + static_cast<float>(i & 15)), 16.0f / 9.0f, 0.1f, 100.0f);
+            DoNotOptimize(camera.GetProjectionMatrix());
+        }
+    }});
+    benchmarks.push_back({ "camera/view_projection", [](uint64_t iterations)
+    {
+        Camera camera;
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            camera.SetPosition(glm::vec3(static_cast<float>(i & 255), 1.0f, -4.0f));
+            DoNotOptimize(camera.GetViewProjectionMatrix());
+        }
+    }});
+
+    benchmarks.push_back({ "camera/view_cached", [](uint64_t iterations)
+    {
+        Camera camera;
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            camera.SetPosition(glm::vec3(0.0f, 1.0f, -4.0f));
+            DoNotOptimize(camera.GetViewProjectionMatrix());
+        }
+    }});
+    benchmarks.push_back({ "viewset/cull/4_views", [](uint64_t iterations)
+    {
+        ViewSet views;
+        Camera camera;
+        camera.SetPerspectiveParams(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        for (float x : { -20.0f, 0.0f, 20.0f, 40.0f })
+        {
+            camera.SetPosition(glm::vec3(x, 0.0f, -10.0f));
+            static_cast<void>(views.Add(camera));
+        }
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            DoNotOptimize(views.Cull(glm::vec4(static_cast<float>(i & 63) - 32.0f, 0.0f, 5.0f, 1.0f)));
+        }
+    }});
+
+    /// Animation, a 64 joint chain with a two second clip
+    auto skin = std::make_shared<SkinInfo>();
+    auto raw_clip = std::make_shared<AnimationClip>();
+    {
+        constexpr uint32_t joint_count{ 64 };
+        Skeleton& skeleton = skin->skeleton;
+        skeleton.rest.Resize(joint_count);
+        for (uint32_t joint{ 0 }; joint < joint_count; ++joint)
+        {
+            skeleton.joint_names.push_back(std::format("joint_{}", joint));
+            skeleton.parents.push_back(static_cast<int32_t>(joint) - 1);
+            skeleton.inverse_bind.push_back(glm::mat4(1.0f));
+            skeleton.rest.SetTranslation(joint, glm::vec3(0.0f, 0.1f, 0.0f));
+        }
+        AnimationClip& clip = *raw_clip;
+        clip.duration = 2.0f;
+        clip.frame_count = static_cast<uint32_t>(clip.duration * clip.sample_rate) + 1;
+        clip.stride = static_cast<uint32_t>(skeleton.rest.Data().size());
+        Pose pose = skeleton.rest;
+        for (uint32_t frame{ 0 }; frame < clip.frame_count; ++frame)
+        {
+            for (uint32_t joint{ 0 }; joint < joint_count; ++joint)
+            {
+                float angle = 0.05f * std::sin(static_cast<float>(frame + joint) * 0.2f);
+                pose.SetRotation(joint, glm::angleAxis(angle, glm::vec3(0.0f, 0.0f, 1.0f)));
+            }
+            clip.frames.insert(clip.frames.end(), pose.Data().begin(), pose.Data().end());
+        }
+        skin->clips.push_back(CompressClip(clip, joint_count));
+    }
+    benchmarks.push_back({ "animation/sample_raw/64", [skin, raw_clip](uint64_t iterations)
+    {
+        Pose pose = skin->skeleton.rest;
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            SampleClip(*raw_clip, static_cast<float>(i & 255) * 0.011f, true, pose);
+            DoNotOptimize(pose.Data().front());
+        }
+    }});
+    benchmarks.push_back({ "animation/sample/64", [skin](uint64_t iterations)
+    {
+        Pose pose = skin->skeleton.rest;
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            SampleClip(skin->clips.front(), static_cast<float>(i & 255) * 0.011f, true, pose);
+            DoNotOptimize(pose.Data().front());
+        }
+    }});
+    benchmarks.push_back({ "animation/compress/64", [skin, raw_clip](uint64_t iterations)
+    {
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            DoNotOptimize(CompressClip(*raw_clip, skin->skeleton.JointCount()).keys.size());
+        }
+    }});
+    benchmarks.push_back({ "animation/blend/64", [skin](uint64_t iterations)
+    {
+        Pose from = skin->skeleton.rest;
+        Pose to = skin->skeleton.rest;
+        SampleClip(skin->clips.front(), 0.5f, true, to);
+        Pose out = skin->skeleton.rest;
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            BlendPoses(from, to, static_cast<float>(i & 255) / 255.0f, out);
+            DoNotOptimize(out.Data().front());
+        }
+    }});
+    benchmarks.push_back({ "animation/palette/64", [skin](uint64_t iterations)
+    {
+        std::vector<glm::mat4> palette(skin->skeleton.JointCount());
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            ComputePalette(skin->skeleton, skin->skeleton.rest, palette);
+            DoNotOptimize(palette.back());
+        }
+    }});
+
+    /// Logger, the cost at the call site. Batches outgrow the queue, so
+    /// this is the sustained rate, held back by the logger thread when it
+    /// falls behind.
+    benchmarks.push_back({ "logger/info", [](uint64_t iterations)
+    {
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            SO_INFO("frame {} took {:.3f} ms on {}", i, 16.6, "main");
+        }
+    }});
+    benchmarks.push_back({ "logger/filtered", [](uint64_t iterations)
+    {
+        Logger::SetFilter(LogLevelFlagBits::Info);
+        for (uint64_t i{ 0 }; i < iterations; ++i)
+        {
+            SO_INFO("frame {} took {:.3f} ms on {}", i, 16.6, "main");
+        }
+        Logger::SetFilter(LogLevelFlagBits::None);
+    }});
+
+    std::vector<Result> results;
+    std::cout << std::format("{:<28} {:>14} {:>14} {:>8} {:>12}\n", "benchmark", "median", "mean", "cv", "iterations");
+    for (auto const& benchmark : benchmarks)
+    {
+        if (!options->filter.empty() && benchmark.name.find(options->filter) == std::string::npos)
+        {
+            continue;
+        }
+        Result const& result = results.emplace_back(Run(benchmark, *options));
+        std::cout << std::format(
+            "{:<28} {:>14} {:>14} {:>7.1f}% {:>12}\n",
+            result.name, FormatTime(result.median_ns), FormatTime(result.mean_ns),
+            result.mean_ns > 0.0 ? 100.0 * result.stddev_ns / result.mean_ns : 0.0,
+            result.iterations);
+    }
+
+    lua_close(L);
+    ResourceManager::Destroy();
+    std::filesystem::remove_all(root);
+    Logger::Destroy();
+
+    if (!options->json.empty())
+    {
+        WriteJson(options->json, results);
+    }
+
+    int exit_code{ 0 };
+    if (!options->baseline.empty())
+    {
+        auto baseline = ReadBaseline(options->baseline);
+        if (!baseline)
+        {
+            std::cerr << std::format("microbench: cannot read baseline {}\n", options->baseline);
+            return 1;
+        }
+        std::cout << std::format("\n{:<28} {:>14} {:>14} {:>9}\n", "against baseline", "before", "after", "change");
+        for (auto const& result : results)
+        {
+            auto it = baseline->find(result.name);
+            if (it == baseline->end() || it->second <= 0.0)
+            {
+                std::cout << std::format("{:<28} {:>14} {:>14} {:>9}\n", result.name, "-", FormatTime(result.median_ns), "new");
+                continue;
+            }
+            double change = 100.0 * (result.median_ns - it->second) / it->second;
+            bool regressed = change > options->threshold;
+            exit_code = regressed ? 2 : exit_code;
+            std::cout << std::format(
+                "{:<28} {:>14} {:>14} {:>+8.1f}%{}\n",
+                result.name, FormatTime(it->second), FormatTime(result.median_ns), change,
+                regressed ? "  REGRESSION" : "");
+        }
+    }
+    return exit_code;
+}
\ No newline at end of file
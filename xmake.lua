@@ -2,6 +2,13 @@ add_rules("mode.debug", "mode.release")
 
 set_languages("c++20")
 
+-- CPU profiler zones, compiled out of release builds
+if is_mode("release") then
+    add_defines("NDEBUG")
+else
+    add_defines("SO_PROFILE")
+end
+
 add_requires("SDL3", {system = true})
 add_requires("lua 5.4.7", "glm", "tinygltf")
 
@@ -11,3 +18,33 @@ target("soulike")
     add_files("src/*.cpp")
     add_packages("SDL3", "lua", "glm", "tinygltf")
     set_rundir("$(projectdir)")
+
+
+-- CPU frame time statistics as JSON, see tools/framebench.cpp
+target("framebench")
+    set_kind("binary")
+    add_includedirs("src")
+    add_files("src/*.cpp|main.cpp", "tools/framebench.cpp")
+    add_packages("SDL3", "lua", "glm", "tinygltf")
+    set_rundir("$(projectdir)")
+
+-- CPU microbenchmarks, build in release mode, see tools/microbench.cpp
+target("microbench")
+    set_kind("binary")
+    add_files("src/*.cpp|main.cpp", "tools/microbench.cpp")
+    add_includedirs("src")
+    add_packages("SDL3", "lua", "glm", "tinygltf")
+    set_rundir("$(projectdir)")
+
+-- Compact animation clips for skinned models, see tools/animimport.cpp
+target("animimport")
+    set_kind("binary")
+    add_includedirs("src")
+    add_files("src/*.cpp|main.cpp", "tools/animimport.cpp")
+    add_packages("SDL3", "lua", "glm", "tinygltf")
+
+-- Decodes logs written by BinaryLogSink
+target("logdecode")
+    set_kind("binary")
+    add_includedirs("src")
+    add_files("tools/logdecode.cpp", "src/LogEncoding.cpp")